@@ -0,0 +1,148 @@
+#include "grafics2.h"
+
+/*
+	Compares the analytic coverage rasterizer against the supersampled path it
+	replaces, hard pixels at SUPERSAMPLE times the size box filtered down.
+
+	Then times atlas generation from 1 to max threads, every atlas has to match
+	the single threaded one byte for byte.
+
+	USAGE: ttf_bench.exe [font.ttf] [iterations] [max threads]
+ */
+
+#define SUPERSAMPLE 4
+
+static const char* BENCH_CHARACTERS =
+	"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+static const u32 BENCH_SIZES[] = { 16, 32, 64, 128 };
+static const u32 BENCH_ATLAS_SIZE = 64;
+
+static u8* bench_supersampled(TrueTypeFont* ttf, char c, u32 width, u32 height)
+{
+	u32 ss_width = width * SUPERSAMPLE;
+	u8* ss = (u8*) ttf_create_bitmap(ttf, c, ss_width, height * SUPERSAMPLE, 0);
+	u8* bmp = (u8*) malloc(width * height);
+	for (u32 y = 0; y < height; y++) {
+		for (u32 x = 0; x < width; x++) {
+			u32 sum = 0;
+			for (u32 j = 0; j < SUPERSAMPLE; j++) {
+				u8* row = ss + (y * SUPERSAMPLE + j) * ss_width + x * SUPERSAMPLE;
+				for (u32 i = 0; i < SUPERSAMPLE; i++) { sum += row[i]; }
+			}
+			bmp[x + y * width] = sum / (SUPERSAMPLE * SUPERSAMPLE);
+		}
+	}
+	free(ss);
+	return bmp;
+}
+
+static LARGE_INTEGER bench_now()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now;
+}
+
+static double bench_seconds(LARGE_INTEGER begin)
+{
+	// wall clock, the atlas runs on several threads
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return (double) (bench_now().QuadPart - begin.QuadPart) / frequency.QuadPart;
+}
+
+int main(int argc, char** argv)
+{
+	log_init("ttf_bench.log");
+
+	const char* font_path = (argc > 1) ? argv[1] : "resources/calibri.ttf";
+	u32 iterations = (argc > 2) ? atoi(argv[2]) : 20;
+	u32 max_threads = (argc > 3) ? atoi(argv[3]) : 8;
+
+	TrueTypeFont* ttf = NULL;
+	if (ttf_load(&ttf, font_path, 0) != 1) {
+		printf("failed to load %s\n", font_path);
+		return 1;
+	}
+
+	u32 num_characters = strlen(BENCH_CHARACTERS);
+	printf("%s, %u glyphs, %u iterations\n", font_path, num_characters, iterations);
+	printf("%6s %14s %14s %8s %10s %10s %10s\n", "size", "aa us/glyph", "ss us/glyph",
+		   "speedup", "mean diff", "hits", "misses");
+
+	for (u32 s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); s++) {
+		u32 size = BENCH_SIZES[s];
+		ttf_edge_cache_reset(ttf, ttf->edge_cache.capacity);
+
+		LARGE_INTEGER begin = bench_now();
+		for (u32 n = 0; n < iterations; n++) {
+			for (u32 i = 0; i < num_characters; i++) {
+				free(ttf_create_bitmap(ttf, BENCH_CHARACTERS[i], size, size, TTF_RASTER_AA));
+			}
+		}
+		double aa_time = bench_seconds(begin);
+		TrueTypeFontEdgeCache cache = ttf->edge_cache;
+
+		begin = bench_now();
+		for (u32 n = 0; n < iterations; n++) {
+			for (u32 i = 0; i < num_characters; i++) {
+				free(bench_supersampled(ttf, BENCH_CHARACTERS[i], size, size));
+			}
+		}
+		double ss_time = bench_seconds(begin);
+
+		// how far the two paths disagree, in 8-bit coverage steps
+		u64 diff = 0;
+		for (u32 i = 0; i < num_characters; i++) {
+			u8* aa = (u8*) ttf_create_bitmap(ttf, BENCH_CHARACTERS[i], size, size, TTF_RASTER_AA);
+			u8* ss = bench_supersampled(ttf, BENCH_CHARACTERS[i], size, size);
+			for (u32 p = 0; p < size * size; p++) { diff += abs(aa[p] - ss[p]); }
+			free(aa);
+			free(ss);
+		}
+
+		double glyphs = (double) iterations * num_characters;
+		printf("%6u %14.2f %14.2f %7.2fx %10.3f %10llu %10llu\n", size, 1e6 * aa_time / glyphs,
+			   1e6 * ss_time / glyphs, ss_time / aa_time,
+			   (double) diff / ((double) num_characters * size * size), cache.hits,
+			   cache.misses);
+	}
+
+	TrueTypeFontAtlasCreateInfo atlas_info = (TrueTypeFontAtlasCreateInfo) {
+		.characters = BENCH_CHARACTERS,
+		.point_size = BENCH_ATLAS_SIZE,
+		.padding = 1,
+		.max_size = 0,
+		.flags = TTF_RASTER_AA,
+		.thread_count = 1
+	};
+	TrueTypeFontAtlas reference;
+	ttf_create_font_atlas(ttf, &atlas_info, &reference);
+	u32 atlas_size = reference.width * reference.height;
+
+	printf("\natlas, %u glyphs at %upx in %ux%u\n", reference.num_glyphs, BENCH_ATLAS_SIZE,
+		   reference.width, reference.height);
+	printf("%8s %14s %8s %10s\n", "threads", "glyphs/s", "scaling", "identical");
+	double single_rate = 0.0;
+	for (u32 threads = 1; threads <= max_threads; threads *= 2) {
+		bool identical = true;
+		atlas_info.thread_count = threads;
+		LARGE_INTEGER begin = bench_now();
+		for (u32 n = 0; n < iterations; n++) {
+			TrueTypeFontAtlas atlas;
+			ttf_create_font_atlas(ttf, &atlas_info, &atlas);
+			identical &= atlas.width * atlas.height == atlas_size &&
+				memcmp(atlas.bitmap, reference.bitmap, atlas_size) == 0;
+			ttf_font_atlas_free(&atlas);
+		}
+		double rate = (double) iterations * reference.num_glyphs / bench_seconds(begin);
+		if (threads == 1) { single_rate = rate; }
+		printf("%8u %14.0f %7.2fx %10s\n", threads, rate, rate / single_rate,
+			   identical ? "yes" : "NO");
+	}
+	ttf_font_atlas_free(&reference);
+
+	ttf_free(&ttf);
+	log_close();
+	return 0;
+}
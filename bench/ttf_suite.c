@@ -0,0 +1,381 @@
+#include "grafics2.h"
+#include <psapi.h>
+
+/*
+	CPU-only numbers for the font code, one JSON document so runs can be diffed
+	and tracked over time, the human readable log goes to ttf_suite.log.
+
+	Per font: ttf_load time and memory, glyph index lookups per second for
+	ASCII, Latin-1 and CJK text, glyphs rasterized per second by
+	ttf_glyph_rasterize at every SUITE_SIZES entry and mode, and atlas build
+	time on one and on the given number of threads.
+
+	USAGE: ttf_suite.exe [-o results.json] [-n iterations] [-t threads] font.ttf [font.ttf ...]
+
+	NOTE:
+	- memory is the process' private commit, resident_bytes is what the font
+	  keeps after ttf_load, peak_bytes how far the load raised the process peak
+	- windows can't reset the peak, fonts are loaded before anything else and
+	  smallest file first so every load gets a chance to raise it, peak_bytes is
+	  null when it didn't (the heap reused pages of an earlier font)
+	- lookups and rasterization are timed warm, after one untimed pass
+ */
+
+#define SUITE_VERSION 1
+#define SUITE_LOOKUP_REPEATS 1000
+#define SUITE_CJK_FIRST 0x4e00
+#define SUITE_CJK_COUNT 4096
+
+static const u32 SUITE_SIZES[] = { 12, 16, 32, 64, 128 };
+static const u32 SUITE_ATLAS_SIZES[] = { 32, 64 };
+static const char* SUITE_ATLAS_CHARACTERS =
+	" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`"
+	"abcdefghijklmnopqrstuvwxyz{|}~";
+
+typedef struct SuiteFont_t
+{
+	const char* path;
+	u64 file_bytes;
+	double load_ms;					// mean over the iterations
+	double load_min_ms;
+	double lazy_load_ms;
+	u64 resident_bytes;
+	u64 peak_bytes;
+	bool peak_exact;
+} SuiteFont;
+
+static LARGE_INTEGER suite_now()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now;
+}
+
+static double suite_seconds(LARGE_INTEGER begin)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return (double) (suite_now().QuadPart - begin.QuadPart) / frequency.QuadPart;
+}
+
+static void suite_memory(u64* usage, u64* peak)
+{
+	PROCESS_MEMORY_COUNTERS counters = (PROCESS_MEMORY_COUNTERS) { 0 };
+	counters.cb = sizeof(counters);
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	*usage = counters.PagefileUsage;
+	*peak = counters.PeakPagefileUsage;
+}
+
+static u64 suite_file_bytes(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL) { return 0; }
+	fseek(file, 0, SEEK_END);
+	u64 size = ftell(file);
+	fclose(file);
+	return size;
+}
+
+static void suite_json_string(FILE* out, const char* s)
+{
+	// font paths, windows ones are full of backslashes
+	fputc('"', out);
+	for (; *s; s++) {
+		if (*s == '"' || *s == '\\') { fputc('\\', out); }
+		fputc(*s, out);
+	}
+	fputc('"', out);
+}
+
+static u32 suite_utf8_encode(u32 code_point, char* out)
+{
+	if (code_point < 0x80) {
+		out[0] = code_point;
+		return 1;
+	}
+	if (code_point < 0x800) {
+		out[0] = 0xc0 | (code_point >> 6);
+		out[1] = 0x80 | (code_point & 0x3f);
+		return 2;
+	}
+	out[0] = 0xe0 | (code_point >> 12);
+	out[1] = 0x80 | ((code_point >> 6) & 0x3f);
+	out[2] = 0x80 | (code_point & 0x3f);
+	return 3;
+}
+
+static int suite_load(SuiteFont* font, u32 iterations)
+{
+	// the first load is the cold one memory is measured on
+	u64 usage_before, peak_before, usage_after, peak_after;
+	suite_memory(&usage_before, &peak_before);
+	TrueTypeFont* ttf = NULL;
+	LARGE_INTEGER begin = suite_now();
+	if (ttf_load(&ttf, font->path, 0) != 1) { return 0; }
+	double seconds = suite_seconds(begin);
+	suite_memory(&usage_after, &peak_after);
+	ttf_free(&ttf);
+
+	font->resident_bytes = (usage_before < usage_after) ? usage_after - usage_before : 0;
+	font->peak_exact = peak_before < peak_after;
+	font->peak_bytes = font->peak_exact ? peak_after - usage_before : 0;
+
+	double total = seconds;
+	font->load_min_ms = 1e3 * seconds;
+	for (u32 n = 1; n < iterations; n++) {
+		begin = suite_now();
+		ttf_load(&ttf, font->path, 0);
+		seconds = suite_seconds(begin);
+		ttf_free(&ttf);
+		total += seconds;
+		font->load_min_ms = MIN(font->load_min_ms, 1e3 * seconds);
+	}
+	font->load_ms = 1e3 * total / iterations;
+
+	total = 0.0;
+	for (u32 n = 0; n < iterations; n++) {
+		begin = suite_now();
+		ttf_load(&ttf, font->path, TTF_LOAD_LAZY);
+		total += suite_seconds(begin);
+		ttf_free(&ttf);
+	}
+	font->lazy_load_ms = 1e3 * total / iterations;
+	return 1;
+}
+
+static void suite_lookups(FILE* out, TrueTypeFont* ttf, u32 iterations)
+{
+	const char* names[] = { "ascii", "latin1", "cjk" };
+	u32 firsts[] = { 0x20, 0xa0, SUITE_CJK_FIRST };
+	u32 counts[] = { 0x7f - 0x20, 0x100 - 0xa0, SUITE_CJK_COUNT };
+
+	fprintf(out, "\t\t\t\"lookup\": [\n");
+	for (u32 s = 0; s < 3; s++) {
+		char* text = (char*) malloc(counts[s] * 3);
+		u32* indices = (u32*) malloc(counts[s] * sizeof(u32));
+		u32 length = 0;
+		for (u32 i = 0; i < counts[s]; i++) {
+			length += suite_utf8_encode(firsts[s] + i, text + length);
+		}
+
+		u32 num_indices = ttf_glyph_indices_utf8(ttf, text, length, indices);
+		u32 mapped = 0;
+		for (u32 i = 0; i < num_indices; i++) { mapped += indices[i] != 0; }
+
+		u32 repeats = iterations * SUITE_LOOKUP_REPEATS;
+		LARGE_INTEGER begin = suite_now();
+		for (u32 n = 0; n < repeats; n++) {
+			ttf_glyph_indices_utf8(ttf, text, length, indices);
+		}
+		double rate = (double) repeats * num_indices / suite_seconds(begin);
+
+		logi("  lookup %-6s %5u code points, %5u mapped, %12.0f lookups/s\n", names[s],
+			 num_indices, mapped, rate);
+		fprintf(out, "\t\t\t\t{ \"set\": \"%s\", \"code_points\": %u, \"mapped\": %u, "
+				"\"lookups_per_second\": %.0f }%s\n", names[s], num_indices, mapped, rate,
+				(s < 2) ? "," : "");
+		free(text);
+		free(indices);
+	}
+	fprintf(out, "\t\t\t],\n");
+}
+
+static void suite_raster(FILE* out, TrueTypeFont* ttf, u32 iterations)
+{
+	// every printable ascii glyph the font has, through the caller buffer path
+	u32 glyphs[0x7f - 0x20];
+	u32 num_glyphs = 0;
+	for (u32 c = 0x20; c < 0x7f; c++) {
+		i32 glyph_index = ttf_glyph_index_get(ttf, c);
+		if (0 < glyph_index) { glyphs[num_glyphs++] = glyph_index; }
+	}
+
+	const char* mode_names[] = { "hard", "aa", "sdf" };
+	TrueTypeFontRasterFlags modes[] = { 0, TTF_RASTER_AA, TTF_RASTER_SDF };
+	u32 num_sizes = sizeof(SUITE_SIZES) / sizeof(SUITE_SIZES[0]);
+
+	fprintf(out, "\t\t\t\"raster\": [\n");
+	for (u32 m = 0; m < 3; m++) {
+		for (u32 s = 0; s < num_sizes; s++) {
+			u32 size = SUITE_SIZES[s];
+			u64 pixels_size = 0;
+			u64 scratch_size = 0;
+			for (u32 i = 0; i < num_glyphs; i++) {
+				TrueTypeFontGlyphBitmap bitmap;
+				ttf_glyph_bitmap_metrics(ttf, glyphs[i], size, 1, modes[m], &bitmap);
+				u64 glyph_scratch = ttf_glyph_scratch_size(ttf, glyphs[i], size, 1, modes[m]);
+				pixels_size = MAX(pixels_size, (u64) bitmap.width * bitmap.height);
+				scratch_size = MAX(scratch_size, glyph_scratch);
+			}
+			u8* pixels = (u8*) malloc(MAX(pixels_size, 1));
+			void* memory = malloc(MAX(scratch_size, 1));
+			TrueTypeFontArena scratch;
+
+			// pass 0 warms the edge cache and is not timed
+			LARGE_INTEGER begin = suite_now();
+			for (u32 n = 0; n <= iterations; n++) {
+				if (n == 1) { begin = suite_now(); }
+				for (u32 i = 0; i < num_glyphs; i++) {
+					TrueTypeFontGlyphBitmap bitmap;
+					ttf_glyph_bitmap_metrics(ttf, glyphs[i], size, 1, modes[m], &bitmap);
+					TrueTypeFontRasterTarget target = (TrueTypeFontRasterTarget) {
+						.pixels = pixels,
+						.stride = bitmap.width
+					};
+					ttf_arena_init(&scratch, memory, scratch_size);
+					ttf_glyph_rasterize(ttf, glyphs[i], size, 1, modes[m], &target, &scratch);
+				}
+			}
+			double rate = (double) iterations * num_glyphs / suite_seconds(begin);
+
+			logi("  raster %-4s %4upx %12.0f glyphs/s\n", mode_names[m], size, rate);
+			fprintf(out, "\t\t\t\t{ \"mode\": \"%s\", \"point_size\": %u, \"glyphs\": %u, "
+					"\"glyphs_per_second\": %.0f }%s\n", mode_names[m], size, num_glyphs, rate,
+					(m < 2 || s + 1 < num_sizes) ? "," : "");
+			free(pixels);
+			free(memory);
+		}
+	}
+	fprintf(out, "\t\t\t],\n");
+}
+
+static void suite_atlas(FILE* out, TrueTypeFont* ttf, u32 iterations, u32 max_threads)
+{
+	u32 num_sizes = sizeof(SUITE_ATLAS_SIZES) / sizeof(SUITE_ATLAS_SIZES[0]);
+	u32 thread_counts[] = { 1, MAX(max_threads, 1) };
+	u32 num_thread_counts = (1 < max_threads) ? 2 : 1;
+
+	fprintf(out, "\t\t\t\"atlas\": [\n");
+	for (u32 s = 0; s < num_sizes; s++) {
+		for (u32 t = 0; t < num_thread_counts; t++) {
+			TrueTypeFontAtlasCreateInfo info = (TrueTypeFontAtlasCreateInfo) {
+				.characters = SUITE_ATLAS_CHARACTERS,
+				.point_size = SUITE_ATLAS_SIZES[s],
+				.padding = 1,
+				.max_size = 0,
+				.flags = TTF_RASTER_AA,
+				.thread_count = thread_counts[t]
+			};
+
+			TrueTypeFontAtlas atlas = (TrueTypeFontAtlas) { 0 };
+			double total = 0.0;
+			for (u32 n = 0; n < iterations; n++) {
+				ttf_font_atlas_free(&atlas);
+				LARGE_INTEGER begin = suite_now();
+				ttf_create_font_atlas(ttf, &info, &atlas);
+				total += suite_seconds(begin);
+			}
+			double ms = 1e3 * total / iterations;
+
+			logi("  atlas  %4upx %2u threads, %3u glyphs in %4ux%-4u %10.3f ms\n",
+				 info.point_size, info.thread_count, atlas.num_glyphs, atlas.width,
+				 atlas.height, ms);
+			fprintf(out, "\t\t\t\t{ \"point_size\": %u, \"threads\": %u, \"glyphs\": %u, "
+					"\"width\": %u, \"height\": %u, \"ms\": %.3f }%s\n", info.point_size,
+					info.thread_count, atlas.num_glyphs, atlas.width, atlas.height, ms,
+					(s + 1 < num_sizes || t + 1 < num_thread_counts) ? "," : "");
+			ttf_font_atlas_free(&atlas);
+		}
+	}
+	fprintf(out, "\t\t\t]\n");
+}
+
+int main(int argc, char** argv)
+{
+	log_init("ttf_suite.log");
+
+	const char* out_path = NULL;
+	u32 iterations = 10;
+	u32 max_threads = 8;
+	u32 num_fonts = 0;
+	SuiteFont* fonts = (SuiteFont*) calloc(argc, sizeof(SuiteFont));
+	for (i32 i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+			out_path = argv[++i];
+		} else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			iterations = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			max_threads = atoi(argv[++i]);
+		} else {
+			fonts[num_fonts].path = argv[i];
+			fonts[num_fonts].file_bytes = suite_file_bytes(argv[i]);
+			num_fonts++;
+		}
+	}
+	iterations = MAX(iterations, 1);
+	if (num_fonts == 0) {
+		printf("USAGE: %s [-o results.json] [-n iterations] [-t threads] font.ttf [font.ttf ...]\n",
+			   argv[0]);
+		free(fonts);
+		return 1;
+	}
+
+	FILE* out = (out_path != NULL) ? fopen(out_path, "w") : stdout;
+	if (out == NULL) {
+		printf("failed to open %s\n", out_path);
+		free(fonts);
+		return 1;
+	}
+
+	// smallest file first, see the NOTE on peak_bytes
+	for (u32 i = 1; i < num_fonts; i++) {
+		SuiteFont font = fonts[i];
+		u32 j = i;
+		for (; 0 < j && font.file_bytes < fonts[j - 1].file_bytes; j--) {
+			fonts[j] = fonts[j - 1];
+		}
+		fonts[j] = font;
+	}
+
+	bool* loaded = (bool*) malloc(num_fonts * sizeof(bool));
+	for (u32 f = 0; f < num_fonts; f++) {
+		loaded[f] = suite_load(&fonts[f], iterations);
+		if (!loaded[f]) { logw("failed to load %s\n", fonts[f].path); }
+	}
+
+	i32 failed = 0;
+	fprintf(out, "{\n\t\"version\": %u,\n\t\"iterations\": %u,\n\t\"max_threads\": %u,\n"
+			"\t\"fonts\": [\n", SUITE_VERSION, iterations, max_threads);
+	for (u32 f = 0; f < num_fonts; f++) {
+		SuiteFont* font = &fonts[f];
+		fprintf(out, "\t\t{\n\t\t\t\"path\": ");
+		suite_json_string(out, font->path);
+		fprintf(out, ",\n\t\t\t\"file_bytes\": %llu,\n", font->file_bytes);
+
+		TrueTypeFont* ttf = NULL;
+		if (!loaded[f] || ttf_load(&ttf, font->path, 0) != 1) {
+			fprintf(out, "\t\t\t\"error\": \"load failed\"\n\t\t}%s\n",
+					(f + 1 < num_fonts) ? "," : "");
+			failed++;
+			continue;
+		}
+
+		logi("%s, %u glyphs\n", font->path, ttf->num_glyphs);
+		logi("  load %10.3f ms (min %.3f, lazy %.3f), %llu bytes resident, %llu peak%s\n",
+			 font->load_ms, font->load_min_ms, font->lazy_load_ms, font->resident_bytes,
+			 font->peak_bytes, font->peak_exact ? "" : " (not measured)");
+		fprintf(out, "\t\t\t\"num_glyphs\": %u,\n", ttf->num_glyphs);
+		fprintf(out, "\t\t\t\"load\": { \"ms\": %.3f, \"min_ms\": %.3f, \"lazy_ms\": %.3f, "
+				"\"resident_bytes\": %llu, ", font->load_ms, font->load_min_ms,
+				font->lazy_load_ms, font->resident_bytes);
+		if (font->peak_exact) {
+			fprintf(out, "\"peak_bytes\": %llu },\n", font->peak_bytes);
+		} else {
+			fprintf(out, "\"peak_bytes\": null },\n");
+		}
+
+		suite_lookups(out, ttf, iterations);
+		suite_raster(out, ttf, iterations);
+		suite_atlas(out, ttf, iterations, max_threads);
+		fprintf(out, "\t\t}%s\n", (f + 1 < num_fonts) ? "," : "");
+		ttf_free(&ttf);
+	}
+	fprintf(out, "\t]\n}\n");
+
+	if (out != stdout) { fclose(out); }
+	free(loaded);
+	free(fonts);
+	log_close();
+	return failed;
+}
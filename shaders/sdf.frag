@@ -0,0 +1,19 @@
+#version 450
+
+// single channel signed distance field from ttf_create_font_atlas with
+// TTF_RASTER_SDF, 0.5 is the outline, upload it as unorm, srgb would bend the
+// distances
+layout(binding = 0) uniform sampler2D img;
+
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	float distance = texture(img, in_uv).r;
+	// how much the distance changes across one screen pixel, keeps the edge about a
+	// pixel wide at any scale
+	float width = max(0.5 * fwidth(distance), 1.0 / 255.0);
+	float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+	out_color = vec4(vec3(alpha), 1.0);
+}
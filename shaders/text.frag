@@ -0,0 +1,12 @@
+#version 450
+
+// coverage from the glyph cache page, blended over the frame
+layout(binding = 0) uniform sampler2D img;
+
+layout(location = 1) in vec2 in_uv;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	out_color = vec4(1.0, 1.0, 1.0, texture(img, in_uv).r);
+}
@@ -0,0 +1,21 @@
+#version 450
+
+// pixels, y down from the top left, to clip space
+layout(binding = 1) uniform uniformBufferObject0
+{
+	vec4 transform;
+} ubo0;
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec2 in_uv;
+layout(location = 2) in vec4 in_rect;
+layout(location = 3) in vec4 in_uvrect;
+
+layout(location = 1) out vec2 out_uv;
+
+void main() {
+	// the quad is a unit square, every glyph instance places and sizes it
+	vec2 position = in_rect.xy + in_position * in_rect.zw;
+	gl_Position = vec4(position * ubo0.transform.xy + ubo0.transform.zw, 0.0, 1.0);
+	out_uv = mix(in_uvrect.xy, in_uvrect.zw, in_uv);
+}
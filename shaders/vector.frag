@@ -0,0 +1,15 @@
+#version 450
+
+// Loop-Blinn coverage, ink where side * (u * u - v) < 0, solid triangles always are
+layout(location = 1) in vec3 in_curve;
+
+layout(location = 0) out vec4 out_color;
+
+void main() {
+	float f = in_curve.x * in_curve.x - in_curve.y;
+	vec2 gradient = vec2(2.0 * in_curve.x * dFdx(in_curve.x) - dFdx(in_curve.y),
+						 2.0 * in_curve.x * dFdy(in_curve.x) - dFdy(in_curve.y));
+	// signed distance to the curve in pixels, half a pixel either side is blended
+	float distance = in_curve.z * f / max(length(gradient), 1e-6);
+	out_color = vec4(1.0, 1.0, 1.0, clamp(0.5 - distance, 0.0, 1.0));
+}
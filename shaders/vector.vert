@@ -0,0 +1,20 @@
+#version 450
+
+// pixels, y down from the top left, to clip space
+layout(binding = 0) uniform uniformBufferObject0
+{
+	vec4 transform;
+} ubo0;
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec3 in_curve;
+layout(location = 2) in vec4 in_pen;
+
+layout(location = 1) out vec3 out_curve;
+
+void main() {
+	// glyph meshes are in font units y up, every instance places and scales one
+	vec2 position = in_pen.xy + vec2(in_position.x, -in_position.y) * in_pen.z;
+	gl_Position = vec4(position * ubo0.transform.xy + ubo0.transform.zw, 0.0, 1.0);
+	out_curve = in_curve;
+}
@@ -1,68 +1,14 @@
 #include "grafics2.h"
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-__int64 get_file_size(const char* file)
-{
-	HANDLE handle = CreateFile(
-		file,
-		GENERIC_READ,
-		0,
-		NULL,
-		OPEN_EXISTING,
-		FILE_ATTRIBUTE_NORMAL,
-		NULL
-	);
-
-	if (handle == INVALID_HANDLE_VALUE)
-	{
-		printf("get_file_size(%s) --- INVALID_HANDLE_VALUE\n", file);
-		return 0;
-	}
-
-	LARGE_INTEGER size;
-	if (!GetFileSizeEx(handle, &size))
-	{
-		printf("get_file_size(%s) --- GetFileSizeEz() failed\n", file);
-		CloseHandle(handle);
-		return 0;
-  	}
-
-	CloseHandle(handle);
-	return size.QuadPart;
-}
-
-void read_file(const char* file, char* buffer, __int64 size)
-{
-	HANDLE handle = CreateFile(
-		file,
-		GENERIC_READ,
-		0,
-		NULL,
-		OPEN_EXISTING,
-		FILE_ATTRIBUTE_NORMAL,
-		NULL
-	);
-
-	if (handle == INVALID_HANDLE_VALUE)
-	{
-		printf("read_file(%s) --- INVALID_HANDLE_VALUE\n", file);
-		return;
-	}
-
-	BOOL result = ReadFile(
-		handle,
-		buffer,
-		size,
-		NULL,
-		NULL
-	);
-
-	if (!result)
-	{
-		printf("read_file(%s) --- ReadFile() failed\n", file);
-	}
-
-	CloseHandle(handle);
-}
+// pixel data is bgr(a), little endian words swap to rgba with a byte swap
+#if defined(_MSC_VER)
+#define BMP_BSWAP32(a) _byteswap_ulong(a)
+#else
+#define BMP_BSWAP32(a) __builtin_bswap32(a)
+#endif
 
 typedef struct bmp_header
 {
@@ -87,96 +33,340 @@ typedef struct bmp_info_header
 	uint32_t important_colors;
 } bmp_info_header;
 
-char* bmp_load(const char* file, uint32_t* width, uint32_t* height)
+#define BMP_HEADER_SIZE 14
+#define BMP_INFO_HEADER_SIZE 40
+#define BMP_V4_HEADER_SIZE 108
+#define BMP_RGB 0
+#define BMP_BITFIELDS 3
+#define BMP_SRGB 0x73524742			// 'sRGB'
+#define BMP_PIXELS_PER_M 2835		// 72 dpi
+#define BMP_ALPHA 0xff000000
+
+static uint32_t bmp_u32(const u8* ptr)
+{
+	// headers are little endian and only 2 byte aligned in the file
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(uint32_t));
+	return value;
+}
+
+static uint16_t bmp_u16(const u8* ptr)
 {
-	__int64 fsize = get_file_size(file);
-	char* buffer = (char*) malloc(fsize);
-	read_file(file, buffer, fsize);
-
-	bmp_header header = (bmp_header) {
-		.signature = { *buffer, *(buffer + 1), 0, 0 },
-		.file_size = *((uint32_t*) (buffer + 2)),
-		.reserved = *((uint32_t*) (buffer + 6)),
-		.data_offset = *((uint32_t*) (buffer + 10))
-	};
-
-	bmp_info_header info_header = (bmp_info_header) {
-		.size = *((uint32_t*) (buffer + 14)),
-		.width = *((uint32_t*) (buffer + 18)),
-		.height = *((uint32_t*) (buffer + 22)),
-		.planes = *((short*) (buffer + 26)),
-		.bits_per_pixel = *((short*) (buffer + 28)),
-		.compression = *((uint32_t*) (buffer + 30)),
- 		.image_size = *((uint32_t*) (buffer + 34)),
-		.xpixel_per_m = *((uint32_t*) (buffer + 38)),
-		.ypixel_per_m = *((uint32_t*) (buffer + 42)),
-		.colors_used = *((uint32_t*) (buffer + 46)),
-		.important_colors = *((uint32_t*) (buffer + 50))
-	};
-
-	*width = info_header.width;
-	*height = info_header.height;
-
-	char* bmp_data = buffer + header.data_offset;
+	uint16_t value;
+	memcpy(&value, ptr, sizeof(uint16_t));
+	return value;
+}
 
+static void bmp_put_u32(u8* ptr, uint32_t value)
+{
+	memcpy(ptr, &value, sizeof(uint32_t));
+}
+
+static void bmp_put_u16(u8* ptr, uint16_t value)
+{
+	memcpy(ptr, &value, sizeof(uint16_t));
+}
+
+static void bmp_bgr_to_rgba(const u8* src, uint32_t* dst, uint32_t count)
+{
+	// 3 byte pixels, every 16 byte load holds 4 and a bit, so the vector loops
+	// stop while a whole load still fits the row
+	uint32_t x = 0;
+#if defined(__SSSE3__)
+	__m128i mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	__m128i alpha = _mm_set1_epi32(BMP_ALPHA);
+#if defined(__AVX2__)
+	__m256i mask8 = _mm256_broadcastsi128_si256(mask);
+	__m256i alpha8 = _mm256_set1_epi32(BMP_ALPHA);
+	for (; x + 10 <= count; x += 8) {
+		__m256i v = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*) (src + 3 * x))),
+			_mm_loadu_si128((const __m128i*) (src + 3 * x + 12)), 1);
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, mask8), alpha8);
+		_mm256_storeu_si256((__m256i*) (dst + x), v);
+	}
+#endif
+	for (; x + 6 <= count; x += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + 3 * x));
+		v = _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha);
+		_mm_storeu_si128((__m128i*) (dst + x), v);
+	}
+#endif
+	// b, g, r and the next byte as one word, shifted and swapped to r, g, b, 0
+	for (; x + 1 < count; x++) {
+		dst[x] = BMP_BSWAP32(bmp_u32(src + 3 * x) << 8) | BMP_ALPHA;
+	}
+	for (; x < count; x++) {
+		const u8* p = src + 3 * x;
+		dst[x] = (uint32_t) p[2] | ((uint32_t) p[1] << 8) | ((uint32_t) p[0] << 16) |
+			BMP_ALPHA;
+	}
+}
+
+static void bmp_swap_red_blue(const u8* src, u8* dst, uint32_t count, uint32_t alpha)
+{
+	// bgra to rgba and back, 'alpha' is or'ed in, BMP_ALPHA for opaque pixels,
+	// saved rows are not 4 byte aligned
+	uint32_t x = 0;
+#if defined(__AVX2__)
+	__m256i green8 = _mm256_set1_epi32(0xff00ff00);
+	__m256i low8 = _mm256_set1_epi32(0xff);
+	__m256i alpha8 = _mm256_set1_epi32(alpha);
+	for (; x + 8 <= count; x += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i*) (src + 4 * x));
+		__m256i r = _mm256_and_si256(_mm256_srli_epi32(v, 16), low8);
+		__m256i b = _mm256_slli_epi32(_mm256_and_si256(v, low8), 16);
+		v = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(v, green8), alpha8),
+							_mm256_or_si256(r, b));
+		_mm256_storeu_si256((__m256i*) (dst + 4 * x), v);
+	}
+#endif
+#if defined(__SSE2__)
+	__m128i green = _mm_set1_epi32(0xff00ff00);
+	__m128i low = _mm_set1_epi32(0xff);
+	__m128i alpha4 = _mm_set1_epi32(alpha);
+	for (; x + 4 <= count; x += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + 4 * x));
+		__m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+		__m128i b = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+		v = _mm_or_si128(_mm_or_si128(_mm_and_si128(v, green), alpha4), _mm_or_si128(r, b));
+		_mm_storeu_si128((__m128i*) (dst + 4 * x), v);
+	}
+#endif
+	for (; x < count; x++) {
+		uint32_t v = bmp_u32(src + 4 * x);
+		bmp_put_u32(dst + 4 * x, (v & 0xff00ff00) | ((v >> 16) & 0xff) | ((v & 0xff) << 16) |
+					alpha);
+	}
+}
+
+static void bmp_gray_to_rgba(const u8* src, uint32_t* dst, uint32_t count)
+{
+	// every byte four times, alpha or'ed over the fourth copy
+	uint32_t x = 0;
+#if defined(__SSE2__)
+	__m128i alpha = _mm_set1_epi32(BMP_ALPHA);
+	for (; x + 16 <= count; x += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + x));
+		__m128i lo = _mm_unpacklo_epi8(v, v);
+		__m128i hi = _mm_unpackhi_epi8(v, v);
+		_mm_storeu_si128((__m128i*) (dst + x),
+						 _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha));
+		_mm_storeu_si128((__m128i*) (dst + x + 4),
+						 _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha));
+		_mm_storeu_si128((__m128i*) (dst + x + 8),
+						 _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha));
+		_mm_storeu_si128((__m128i*) (dst + x + 12),
+						 _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha));
+	}
+#endif
+	for (; x < count; x++) { dst[x] = src[x] * 0x00010101u | BMP_ALPHA; }
+}
+
+static void bmp_index_to_rgba(const u8* src, uint32_t* dst, uint32_t count,
+							  const uint32_t* palette)
+{
+	for (uint32_t x = 0; x < count; x++) { dst[x] = palette[src[x]]; }
+}
+
+static void bmp_rgb_to_bgr(const u8* src, u8* dst, uint32_t count)
+{
+	// 5 pixels per 16 byte load, the 16th byte is rewritten by the next store
+	uint32_t x = 0;
+#if defined(__SSSE3__)
+	__m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+	for (; x + 6 <= count; x += 5) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + 3 * x));
+		_mm_storeu_si128((__m128i*) (dst + 3 * x), _mm_shuffle_epi8(v, mask));
+	}
+#endif
+	for (; x < count; x++) {
+		const u8* p = src + 3 * x;
+		u8* q = dst + 3 * x;
+		q[0] = p[2];
+		q[1] = p[1];
+		q[2] = p[0];
+	}
+}
+
+int bmp_open(BmpImage* bmp, const char* file)
+{
 	/*
-		SPECIFICATION:
-		 If bits_per_pixels are more then 8bits, pixel array begins with
-		 last row's first element, and continues untill it reaches last
-		 element on the row. Then it moves to second to last array and
-		 so on. Each row is padded at the end with 0x00 so that it
-		 reaches closest multiple of four. You can this:
-		  ((4 * width) - (bits_per_pixel / 8) * width) % 4, and so you get
-		 your padding per one row.
+	  	USAGE:
+
+		BmpImage bmp;
+		if (bmp_open(&bmp, "resources/test2.bmp") == 1) {
+			// size the destination, e.g. a staging buffer, from bmp.width and bmp.height
+			bmp_decode(&bmp, staging.dst, 4 * bmp.width);
+			bmp_close(&bmp);
+		}
 
 		NOTE:
-	 	 This supports only 24 bits per pixel and returns data in
-		 R8G8B8A8 format. First pixel is on row 0 position 0, and
-		 it moves by rows.
+		 - the file is mapped and only its headers are read, 1 on success, 0 if it
+		   can't be opened and -1 if it is not a bmp bmp_decode() handles
+		 - 8 bits per pixel with a color table, 24 bits, or 32 uncompressed or
+		   with the usual bgra masks, 32 bits keep their alpha only when the
+		   header declares an alpha mask
 	 */
+	*bmp = (BmpImage) { 0 };
 
-	char* bmp_buffer = (char*) malloc(4 * (*width) * (*height));
-	
-	if (info_header.bits_per_pixel == 24)
-	{
-		uint32_t padding = ((4 * (*width) - 3 * (*width))) % 4;
-		char* bmp_data_ptr = bmp_data + info_header.image_size;
-		char* bmp_buffer_ptr = bmp_buffer;
-		
-		bmp_data_ptr--;
-		
-		for (uint32_t i = 0; i < (*height); i++)
-		{
-			bmp_data_ptr -= padding;
-
-		   	for (uint32_t j = 0; j < (*width); j++)
-			{
-				*bmp_buffer_ptr = *bmp_data_ptr;
-				bmp_buffer_ptr++;
-				bmp_data_ptr--;
-
-				*bmp_buffer_ptr = *bmp_data_ptr;
-				bmp_buffer_ptr++;
-				bmp_data_ptr--;
-
-				*bmp_buffer_ptr = *bmp_data_ptr;
-				bmp_buffer_ptr++;
-				bmp_data_ptr--;
-
-				*bmp_buffer_ptr = 0xff;
-				bmp_buffer_ptr++;
-			}
+	uint32_t size;
+	u8* view = file_map(file, &size);
+	if (view == NULL) { return 0; }
+
+	bmp_header header = (bmp_header) { 0 };
+	bmp_info_header info_header = (bmp_info_header) { 0 };
+	if (BMP_HEADER_SIZE + BMP_INFO_HEADER_SIZE <= size) {
+		header = (bmp_header) {
+			.signature = { view[0], view[1], 0, 0 },
+			.file_size = bmp_u32(view + 2),
+			.reserved = bmp_u32(view + 6),
+			.data_offset = bmp_u32(view + 10)
+		};
+		info_header = (bmp_info_header) {
+			.size = bmp_u32(view + 14),
+			.width = bmp_u32(view + 18),
+			.height = bmp_u32(view + 22),
+			.planes = bmp_u16(view + 26),
+			.bits_per_pixel = bmp_u16(view + 28),
+			.compression = bmp_u32(view + 30),
+			.image_size = bmp_u32(view + 34),
+			.colors_used = bmp_u32(view + 46)
+		};
+	}
+
+	// negative heights store the top row first
+	int32_t height = (int32_t) info_header.height;
+	bmp->width = info_header.width;
+	bmp->height = (height < 0) ? (uint32_t) -(int64_t) height : (uint32_t) height;
+	bmp->bits_per_pixel = info_header.bits_per_pixel;
+	bmp->alpha = false;
+
+	bool valid = header.signature[0] == 'B' && header.signature[1] == 'M' &&
+		BMP_INFO_HEADER_SIZE <= info_header.size && info_header.planes == 1 &&
+		0 < (int32_t) bmp->width && bmp->height != 0 &&
+		(bmp->bits_per_pixel == 8 || bmp->bits_per_pixel == 24 || bmp->bits_per_pixel == 32);
+	// masks and the color table follow the info header
+	u64 table = BMP_HEADER_SIZE + (u64) info_header.size;
+	if (valid && info_header.compression == BMP_BITFIELDS && bmp->bits_per_pixel == 32) {
+		// the masks are part of version 2 and later headers, they follow the first
+		u64 masks = BMP_HEADER_SIZE + BMP_INFO_HEADER_SIZE;
+		valid = masks + 3 * sizeof(uint32_t) <= size &&
+			bmp_u32(view + masks) == 0x00ff0000 && bmp_u32(view + masks + 4) == 0x0000ff00 &&
+			bmp_u32(view + masks + 8) == 0x000000ff;
+		bmp->alpha = 56 <= info_header.size && masks + 4 * sizeof(uint32_t) <= size &&
+			bmp_u32(view + masks + 12) == BMP_ALPHA;
+	} else if (valid && bmp->bits_per_pixel == 8) {
+		// bgrx entries, 0 counts as all 256, indices past the table are black
+		uint32_t num_colors = (info_header.colors_used != 0) ? info_header.colors_used : 256;
+		valid = info_header.compression == BMP_RGB && num_colors <= 256 &&
+			table + 4 * (u64) num_colors <= size;
+		bmp->gray = valid && num_colors == 256;
+		for (uint32_t i = 0; i < 256; i++) {
+			uint32_t bgrx = (valid && i < num_colors) ? bmp_u32(view + table + 4 * i) : 0;
+			bmp->palette[i] = BMP_BSWAP32(bgrx << 8) | BMP_ALPHA;
+			bmp->gray &= bmp->palette[i] == (i * 0x00010101u | BMP_ALPHA);
 		}
+	} else {
+		valid &= info_header.compression == BMP_RGB;
 	}
-	else
-	{
-		printf("bmp_load(%s) --- info_header.bits_per_pixel unsupported\n", file);
-		free(bmp_buffer);
-		return NULL;
+
+	// rows are padded to 4 bytes, the last one may stop at its last pixel
+	bmp->row_size = ((u64) bmp->width * bmp->bits_per_pixel / 8 + 3) & ~3ull;
+	u64 pixels_size = (u64) bmp->row_size * (bmp->height - 1) +
+		(u64) bmp->width * bmp->bits_per_pixel / 8;
+	valid &= header.data_offset <= size && pixels_size <= size - header.data_offset;
+	if (!valid) {
+		printf("bmp_open(%s) --- unsupported or malformed bmp\n", file);
+		file_unmap(view);
+		*bmp = (BmpImage) { 0 };
+		return -1;
 	}
-	
-	free(buffer);
-	
+
+	bmp->pixels = view + header.data_offset;
+	bmp->top_down = height < 0;
+	bmp->view = view;
+	return 1;
+}
+
+void bmp_decode(const BmpImage* bmp, void* dst, uint32_t stride)
+{
+	/*
+		NOTE:
+		 - R8G8B8A8, rows top to bottom and 'stride' bytes apart, every texel is
+		   read from the mapped file and written to 'dst' once
+		 - 'dst' is only written, in order and 16 or 32 bytes at a time, so it can
+		   be write combined memory like a mapped staging buffer
+		 - the row kernels use SSSE3 or AVX2 shuffles when the build targets them,
+		   SSE2 or byte swaps otherwise
+	 */
+	bmp_decode_rows(bmp, dst, stride, 0, bmp->height);
+}
+
+void bmp_decode_rows(const BmpImage* bmp, void* dst, uint32_t stride,
+					 uint32_t first_row, uint32_t num_rows)
+{
+	/*
+		USAGE:
+		for (u32 y = 0; y < bmp.height; y += band) {
+			u32 rows = MIN(band, bmp.height - y);
+			bmp_decode_rows(&bmp, staging, 4 * bmp.width, y, rows);
+			bmp_release_rows(&bmp, y, rows);
+			// upload rows [y, y + rows) before 'staging' is reused
+		}
+
+		NOTE:
+		 - rows [first_row, first_row + num_rows) counted from the top, the first
+		   one goes to the start of 'dst', as bmp_decode() otherwise
+		 - rows past the bottom of the image are ignored
+	 */
+	if (first_row >= bmp->height) { return; }
+	num_rows = MIN(num_rows, bmp->height - first_row);
+	for (uint32_t y = 0; y < num_rows; y++) {
+		uint32_t row = bmp->top_down ? first_row + y : bmp->height - 1 - first_row - y;
+		const u8* src = bmp->pixels + (u64) row * bmp->row_size;
+		uint32_t* out = (uint32_t*) ((u8*) dst + (u64) y * stride);
+
+		if (bmp->bits_per_pixel == 24) {
+			bmp_bgr_to_rgba(src, out, bmp->width);
+		} else if (bmp->bits_per_pixel == 32) {
+			bmp_swap_red_blue(src, (u8*) out, bmp->width, bmp->alpha ? 0 : BMP_ALPHA);
+		} else if (bmp->gray) {
+			bmp_gray_to_rgba(src, out, bmp->width);
+		} else {
+			bmp_index_to_rgba(src, out, bmp->width, bmp->palette);
+		}
+	}
+}
+
+void bmp_release_rows(const BmpImage* bmp, uint32_t first_row, uint32_t num_rows)
+{
+	// rows already decoded leave the working set, a band at a time the mapped
+	// file never holds more than a band or so of resident pages
+	if (first_row >= bmp->height) { return; }
+	num_rows = MIN(num_rows, bmp->height - first_row);
+	uint32_t row = bmp->top_down ? first_row : bmp->height - first_row - num_rows;
+	file_release(bmp->pixels + (u64) row * bmp->row_size, num_rows * bmp->row_size);
+}
+
+void bmp_close(BmpImage* bmp)
+{
+	file_unmap(bmp->view);
+	*bmp = (BmpImage) { 0 };
+}
+
+char* bmp_load(const char* file, uint32_t* width, uint32_t* height)
+{
+	// R8G8B8A8 in a buffer of its own, bmp_decode() skips that copy
+	BmpImage bmp;
+	if (bmp_open(&bmp, file) != 1) { return NULL; }
+
+	*width = bmp.width;
+	*height = bmp.height;
+	char* bmp_buffer = (char*) malloc(4 * (u64) bmp.width * bmp.height);
+	bmp_decode(&bmp, bmp_buffer, 4 * bmp.width);
+	bmp_close(&bmp);
+
 	return bmp_buffer;
 }
 
@@ -190,67 +380,70 @@ void bmp_free(char* bmp_buffer)
 
 void bmp_save(const char* file, char* bmp, u32 width, u32 height, i32 bytes_per_pixel)
 {
-	u32 padding = width % 4;
-	u32 file_size = width * height * 3 + 14 + 40 + height * padding;
-	char* buffer = (char*) malloc(file_size);
-
-	switch (bytes_per_pixel) {
-		case 1:
-		{
-			strcpy(buffer, "BM");
-			memcpy(buffer + 2, &file_size, sizeof(u32));
-			memset(buffer + 6, 0, sizeof(u32));
-			u32 data_offset = 14 + 40;
-			memcpy(buffer + 10, &data_offset, sizeof(u32));
-
-			bmp_info_header bmp_header = {
-				40, width, height, 1, 24, 0, 0, 2835, 2835, 0, 0
-			};
-			// TODO: get proper resolution values
-			
-			memcpy(buffer + 14, &bmp_header.size, sizeof(u32));
-			memcpy(buffer + 18, &bmp_header.width, sizeof(u32));
-			memcpy(buffer + 22, &bmp_header.height, sizeof(u32));
-			
-			memcpy(buffer + 26, &bmp_header.planes, sizeof(i16));
-			memcpy(buffer + 28, &bmp_header.bits_per_pixel, sizeof(i16));
-
-			memcpy(buffer + 30, &bmp_header.compression, sizeof(u32));
-			memcpy(buffer + 34, &bmp_header.image_size, sizeof(u32));
-			memcpy(buffer + 38, &bmp_header.xpixel_per_m, sizeof(u32));
-			memcpy(buffer + 42, &bmp_header.ypixel_per_m, sizeof(u32));
-			memcpy(buffer + 46, &bmp_header.colors_used, sizeof(u32));
-			memcpy(buffer + 50, &bmp_header.important_colors, sizeof(u32));
-
-			char* data = buffer + 54;
-			char* p_bmp = bmp + width * height;
-			p_bmp--;
-			
-			for (u32 i = 0; i < height; i++) {
-				for (u32 j = 0; j < width; j++) {
-					*data = *p_bmp;
-					data++;
-					*data = *p_bmp;
-					data++;
-					*data = *p_bmp;
-					data++;
-					p_bmp--;
-				}
-				data += padding;
-			}
-
-			FILE* f;
-			f = fopen(file, "wb");
-			fwrite(buffer, sizeof(char), file_size, f);
-			fclose(f);
-		
-			break;
-		}
-		default:
-		{
-			// UNSOPPORTED
-			return;
+	/*
+		NOTE:
+		 - 'bmp' holds tightly packed rows top to bottom, 1 byte per pixel is
+		   saved as 8 bits with a gray color table, 3 as 24 bit rgb and 4 as
+		   32 bit rgba with an alpha mask in a version 4 header
+		 - rows are stored bottom up, padded to 4 bytes
+	 */
+	if (bytes_per_pixel != 1 && bytes_per_pixel != 3 && bytes_per_pixel != 4) {
+		printf("bmp_save(%s) --- %d bytes per pixel unsupported\n", file, bytes_per_pixel);
+		return;
+	}
+
+	u32 info_size = (bytes_per_pixel == 4) ? BMP_V4_HEADER_SIZE : BMP_INFO_HEADER_SIZE;
+	u32 table_size = (bytes_per_pixel == 1) ? 256 * sizeof(u32) : 0;
+	u32 data_offset = BMP_HEADER_SIZE + info_size + table_size;
+	u32 row_size = (width * bytes_per_pixel + 3) & ~3u;
+	u64 file_size = data_offset + (u64) row_size * height;
+	if (0xffffffff < file_size) {
+		printf("bmp_save(%s) --- %ux%u is too large\n", file, width, height);
+		return;
+	}
+	u8* buffer = (u8*) calloc(file_size, 1);
+
+	buffer[0] = 'B';
+	buffer[1] = 'M';
+	bmp_put_u32(buffer + 2, (u32) file_size);
+	bmp_put_u32(buffer + 10, data_offset);
+
+	u8* info = buffer + BMP_HEADER_SIZE;
+	bmp_put_u32(info, info_size);
+	bmp_put_u32(info + 4, width);
+	bmp_put_u32(info + 8, height);
+	bmp_put_u16(info + 12, 1);
+	bmp_put_u16(info + 14, 8 * bytes_per_pixel);
+	bmp_put_u32(info + 16, (bytes_per_pixel == 4) ? BMP_BITFIELDS : BMP_RGB);
+	bmp_put_u32(info + 20, row_size * height);
+	bmp_put_u32(info + 24, BMP_PIXELS_PER_M);
+	bmp_put_u32(info + 28, BMP_PIXELS_PER_M);
+	if (bytes_per_pixel == 4) {
+		bmp_put_u32(info + 40, 0x00ff0000);
+		bmp_put_u32(info + 44, 0x0000ff00);
+		bmp_put_u32(info + 48, 0x000000ff);
+		bmp_put_u32(info + 52, BMP_ALPHA);
+		bmp_put_u32(info + 56, BMP_SRGB);
+	}
+	for (u32 i = 0; i < table_size / sizeof(u32); i++) {
+		bmp_put_u32(info + info_size + 4 * i, i * 0x00010101u);
+	}
+
+	const u8* src = (const u8*) bmp;
+	for (u32 y = 0; y < height; y++) {
+		const u8* row = src + (u64) (height - 1 - y) * width * bytes_per_pixel;
+		u8* out = buffer + data_offset + (u64) y * row_size;
+		if (bytes_per_pixel == 1) {
+			memcpy(out, row, width);
+		} else if (bytes_per_pixel == 3) {
+			bmp_rgb_to_bgr(row, out, width);
+		} else {
+			bmp_swap_red_blue(row, out, width, 0);
 		}
 	}
+
+	if (!file_write(file, buffer, (u32) file_size)) {
+		printf("bmp_save(%s) --- could not write the file\n", file);
+	}
 	free(buffer);
 }
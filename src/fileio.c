@@ -37,3 +37,83 @@ void file_free(void* buffer)
 		free(buffer);
 	}
 }
+
+int file_write(const char* path, const void* data, uint32_t size)
+{
+	FILE* file;
+	file = fopen(path, "wb");
+
+	if (!file)
+	{
+		fprintf(stderr, "unable to create file %s", path);
+		return 0;
+	}
+
+	size_t written = fwrite(data, size, 1, file);
+	fclose(file);
+
+	return written == 1 || size == 0;
+}
+
+void* file_map(const char* path, uint32_t* file_size)
+{
+	// copy on write view, pages written to become private to the process
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return NULL;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.HighPart != 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+
+	// the view keeps the mapping alive, neither handle is needed afterwards
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+	{
+		fprintf(stderr, "unable to map file %s", path);
+		return NULL;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+	{
+		fprintf(stderr, "unable to map file %s", path);
+		return NULL;
+	}
+
+	*file_size = size.LowPart;
+	return view;
+}
+
+void file_unmap(void* view)
+{
+	if (view)
+	{
+		UnmapViewOfFile(view);
+	}
+}
+
+void file_release(const void* data, uint32_t size)
+{
+	// drops the whole pages of a mapped range from the working set, they stay
+	// in the file cache and fault back in if touched again
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	uintptr_t page = info.dwPageSize;
+	uintptr_t begin = ((uintptr_t) data + page - 1) & ~(page - 1);
+	uintptr_t end = ((uintptr_t) data + size) & ~(page - 1);
+	if (begin < end)
+	{
+		// unlocking pages that were never locked trims them instead, the
+		// call reports ERROR_NOT_LOCKED which is the expected outcome here
+		VirtualUnlock((void*) begin, end - begin);
+	}
+}
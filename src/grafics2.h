@@ -139,6 +139,10 @@ void log_close();
 
 char* file_read(const char* path, uint32_t* file_size);
 void file_free(void* buffer);
+int file_write(const char* path, const void* data, uint32_t size);
+void* file_map(const char* path, uint32_t* file_size);
+void file_unmap(void* view);
+void file_release(const void* data, uint32_t size);
 
 // ---------------------------------------------------------------------------------
 /*
@@ -146,10 +150,60 @@ void file_free(void* buffer);
  */
 // ---------------------------------------------------------------------------------
 
+typedef struct BmpImage_t
+{
+	u32 width;
+	u32 height;
+	u32 bits_per_pixel;				// 8, 24 or 32
+	u32 row_size;					// bytes between rows in the file
+	bool top_down;					// first row in the file is the top one
+	bool alpha;						// 32 bits with an alpha mask, else alpha is 0xff
+	bool gray;						// 8 bits with the identity gray color table
+	u32 palette[256];				// 8 bits, the color table as R8G8B8A8
+	const u8* pixels;				// first row in the file
+	void* view;						// mapped file
+} BmpImage;
+
+int bmp_open(BmpImage* bmp, const char* file);
+void bmp_decode(const BmpImage* bmp, void* dst, u32 stride);
+void bmp_decode_rows(const BmpImage* bmp, void* dst, u32 stride, u32 first_row, u32 num_rows);
+void bmp_release_rows(const BmpImage* bmp, u32 first_row, u32 num_rows);
+void bmp_close(BmpImage* bmp);
 char* bmp_load(const char* file, uint32_t* width, uint32_t* height);
 void bmp_free(char* buffer);
 void bmp_save(const char* file, char* bmp, u32 width, u32 height, i32 bytes_per_pixel);
 
+// ---------------------------------------------------------------------------------
+/*
+  		qoiloader.c
+ */
+// ---------------------------------------------------------------------------------
+
+typedef struct QoiImage_t
+{
+	u32 width;
+	u32 height;
+	u32 channels;					// 3 or 4, alpha is 0xff with 3
+	u32 colorspace;					// 0 srgb with linear alpha, 1 all linear
+	const u8* data;					// first chunk
+	const u8* end;					// end of the chunks, the padding follows
+	const u8* next;					// next chunk to decode
+	const u8* released;				// chunks before it left the working set
+	u32 row;						// next row to decode
+	u32 run;						// pixels left in the current run
+	u32 px;							// last pixel, R8G8B8A8
+	u32 index[64];					// previously seen pixels by hash
+	void* view;						// mapped file
+} QoiImage;
+
+int qoi_open(QoiImage* qoi, const char* file);
+void qoi_decode_rows(QoiImage* qoi, void* dst, u32 stride, u32 num_rows);
+void qoi_release(QoiImage* qoi);
+void qoi_close(QoiImage* qoi);
+char* qoi_load(const char* file, uint32_t* width, uint32_t* height);
+int qoi_save(const char* file, const char* pixels, u32 width, u32 height, i32 bytes_per_pixel);
+int qoi_convert_bmp(const char* bmp_file, const char* qoi_file);
+
 // ---------------------------------------------------------------------------------
 /*
   		ttf.c
@@ -162,29 +216,113 @@ typedef struct TrueTypeFontTable_t
 	u32 length;
 } TrueTypeFontTable;
 
+// plain header, the outline itself lives in TrueTypeFont.outlines
 typedef struct TrueTypeFontGlyph_t
 {
-	i16 parsed;
+	u32 first_point;		// index into the outline point arrays
+	u32 first_contour;		// index into TrueTypeFontOutlines.end_pts
+	u16 num_points;
 	i16 num_contours;
 	i16 x_min;
 	i16 y_min;
 	i16 x_max;
 	i16 y_max;
-	u16* end_pts_of_contours;
-	u16 num_points;
-	u8* flags;
-	i16* pts_x;
-	i16* pts_y;
 	u16 aw;
 	i16 lsb;
+	i16 parsed;
 } TrueTypeFontGlyph;
 
+// every decoded point of the font, glyphs are contiguous ranges of these arrays
+typedef struct TrueTypeFontOutlines_t
+{
+	u32 num_points;
+	u32 max_points;
+	u32 num_contours;
+	u32 max_contours;
+	i16* pts_x;
+	i16* pts_y;
+	u8* on_curve;			// 1 if the point is on the curve, 0 for control points
+	u16* end_pts;			// contour ends, relative to the glyph's first point
+} TrueTypeFontOutlines;
+
+// code points start_code..end_code map to glyphs start_glyph..
+typedef struct TrueTypeFontCmapGroup_t
+{
+	u32 start_code;
+	u32 end_code;
+	u32 start_glyph;
+} TrueTypeFontCmapGroup;
+
 typedef struct TrueTypeFontMetric_t
 {
 	u16 aw;
 	i16 lsb;
 } TrueTypeFontMetric;
 
+typedef struct TrueTypeFontKernPair_t
+{
+	u32 glyphs;						// left glyph << 16 | right glyph
+	i16 value;						// font units, added to the left glyph's advance
+} TrueTypeFontKernPair;
+
+// pixels, lines are ascent - descent apart
+typedef struct TrueTypeFontTextMetrics_t
+{
+	s32 width;						// widest line
+	s32 height;
+	u32 num_lines;
+} TrueTypeFontTextMetrics;
+
+typedef enum TrueTypeFontLoadFlagBits_t
+{
+	// only parse the table directory, cmap, loca and hmtx, glyph outlines are
+	// decoded the first time ttf_glyph_get() touches them
+	TTF_LOAD_LAZY = 0x01
+} TrueTypeFontLoadFlagBits;
+typedef u32 TrueTypeFontLoadFlags;
+
+typedef enum TrueTypeFontRasterFlagBits_t
+{
+	// 8-bit analytic coverage instead of hard 0x00/0xff pixels
+	TTF_RASTER_AA = 0x01,
+	// atlases only, signed distance to the outline, 0.5 on the edge, see shaders/sdf.frag
+	TTF_RASTER_SDF = 0x02
+} TrueTypeFontRasterFlagBits;
+typedef u32 TrueTypeFontRasterFlags;
+
+typedef struct TrueTypeFontEdgeList_t
+{
+	u32 glyph_index;				// ~0u marks an empty slot
+	u32 bucket;
+	u32 num_lines;
+	line2f* lines;					// flattened outline in font units
+} TrueTypeFontEdgeList;
+
+typedef struct TrueTypeFontEdgeCache_t
+{
+	u32 capacity;					// power of two, direct mapped
+	TrueTypeFontEdgeList* entries;
+	u64 hits;
+	u64 misses;
+	u64 evictions;
+} TrueTypeFontEdgeCache;
+
+typedef struct TrueTypeFontMeshVertex_t
+{
+	s32 x;							// font units, y up
+	s32 y;
+	s32 u;							// Loop-Blinn coordinates, a fragment is ink when
+	s32 v;							// side * (u * u - v) < 0, solid triangles use 0, 1, 1
+	s32 side;
+} TrueTypeFontMeshVertex;
+
+typedef struct TrueTypeFontMesh_t
+{
+	u32 num_vertices;				// triangle list, ~0u until the glyph was meshed
+	u32 num_curves;					// curve triangles, after the solid ones
+	TrueTypeFontMeshVertex* vertices;
+} TrueTypeFontMesh;
+
 typedef struct TrueTypeFont_t
 {
 	u16 units_per_em;
@@ -199,26 +337,143 @@ typedef struct TrueTypeFont_t
 	TrueTypeFontMetric* hmtx;
 	u16 num_lsb;
 	i16* lsbs;
+	u16* advances;					// advance width of every glyph, num_glyphs entries
 	u16 num_glyphs;
-	u16 seg_count_2;
-	u16* end_code;
-	u16* start_code;
-	u16* id_delta;
-	u16* id_range_offset;
-	u32* loca;
+	u32 num_cmap_groups;
+	TrueTypeFontCmapGroup* cmap_groups;		// sorted by code point
+	u32 cmap_dense_size;
+	u16* cmap_dense;						// glyph index of code points < cmap_dense_size
+	u32 num_kern_pairs;
+	TrueTypeFontKernPair* kern_pairs;		// sorted by glyphs
+	u32* kern_first;				// first pair of every left glyph, num_glyphs + 1 entries
+	u32* loca;						// num_glyphs + 1 entries
 	TrueTypeFontGlyph* glyphs;
+	TrueTypeFontOutlines outlines;
+	char* data;						// font file, kept only while glyphs can be decoded
+	u32 data_size;
+	u32 glyf_offset;
+	void* mapping;					// cache file view when loaded by ttf_cache_load
+	u64 source_hash;				// of the font file, keys atlas caches, 0 until needed
+	TrueTypeFontEdgeCache edge_cache;
+	TrueTypeFontMesh* meshes;		// num_glyphs entries once a mesh was asked for
 } TrueTypeFont;
 
-int ttf_load(TrueTypeFont** true_type_font, const char* font_path);
+typedef struct TrueTypeFontAtlasCreateInfo_t
+{
+	const char* characters;			// utf-8, duplicates are packed once
+	u32 point_size;					// pixels per em
+	u32 padding;					// empty pixels around every glyph
+	u32 max_size;					// largest width or height, 0 for 4096
+	s32 sdf_spread;					// pixels mapped to 0 and 255, 0 for point_size / 8
+	TrueTypeFontRasterFlags flags;
+	u32 thread_count;				// 0 or 1 rasterizes on the calling thread
+	const char* cache_dir;			// atlases are saved to and loaded from, NULL for none
+} TrueTypeFontAtlasCreateInfo;
+
+typedef struct TrueTypeFontAtlasGlyph_t
+{
+	u32 code_point;
+	u32 glyph_index;
+	u32 x;							// pixel rect in the atlas, padding included
+	u32 y;
+	u32 width;
+	u32 height;
+	s32 u0;							// uv rect
+	s32 v0;
+	s32 u1;
+	s32 v1;
+	s32 bearing_x;					// pen position to the rect's left edge, in pixels
+	s32 bearing_y;					// baseline to the rect's top edge, y up
+	s32 advance;
+} TrueTypeFontAtlasGlyph;
+
+typedef struct TrueTypeFontAtlas_t
+{
+	u32 width;						// powers of two
+	u32 height;
+	u8* bitmap;						// r8, rows top to bottom
+	s32 scale;						// pixels per font unit
+	s32 ascent;
+	s32 descent;
+	s32 sdf_spread;					// 0 unless TTF_RASTER_SDF
+	u32 num_glyphs;
+	TrueTypeFontAtlasGlyph* glyphs;	// sorted by code point
+	void* mapping;					// cache file view bitmap and glyphs live in, or NULL
+} TrueTypeFontAtlas;
+
+typedef struct TrueTypeFontGlyphBitmap_t
+{
+	u32 width;
+	u32 height;
+	s32 bearing_x;					// same as TrueTypeFontAtlasGlyph
+	s32 bearing_y;
+	s32 advance;
+	u8* pixels;						// r8, rows top to bottom, NULL if empty
+} TrueTypeFontGlyphBitmap;
+
+typedef struct TrueTypeFontRasterTarget_t
+{
+	u8* pixels;						// r8, where the cell's top left pixel goes
+	u32 stride;						// bytes between rows
+	u32 clip_x;						// window of the cell that is written,
+	u32 clip_y;						// 0x0 writes the whole cell
+	u32 clip_width;
+	u32 clip_height;
+} TrueTypeFontRasterTarget;
+
+typedef struct TrueTypeFontArena_t
+{
+	u8* base;						// owned by the caller
+	u64 size;
+	u64 offset;						// bytes in use
+} TrueTypeFontArena;
+
+int ttf_load(TrueTypeFont** true_type_font, const char* font_path,
+			 TrueTypeFontLoadFlags flags);
 void ttf_free(TrueTypeFont** true_type_font);
-void ttf_glyph_load(TrueTypeFont* ttf, u32 glyph_index, void* buffer,
-					u64* ttf_buffer_tail_offset);
+int ttf_cache_save(TrueTypeFont* ttf, const char* font_path, const char* cache_path);
+int ttf_cache_load(TrueTypeFont** true_type_font, const char* font_path,
+				   const char* cache_path);
+TrueTypeFontGlyph* ttf_glyph_get(TrueTypeFont* ttf, u32 glyph_index);
+void ttf_glyph_load(TrueTypeFont* ttf, u32 glyph_index);
 void ttf_glyph_get_hmtc(TrueTypeFont* ttf, TrueTypeFontGlyph* glyph, u32 glyph_index);
-void ttf_glyph_create_deep_copy(TrueTypeFont* ttf, u32 src_index, TrueTypeFontGlyph** dst);
-i32 ttf_glyph_index_get(TrueTypeFont* ttf, u16 code_point);
-void* ttf_create_bitmap(TrueTypeFont* ttf, char c, u32 width, u32 height);
-// TODO: user needs character specific info like aw and lsb, also bitmap width and height
-void* ttf_create_font_atlas(TrueTypeFont* ttf, const char* characters, u32 point_size);
+i32 ttf_glyph_index_get(TrueTypeFont* ttf, u32 code_point);
+u32 ttf_glyph_indices_utf8(TrueTypeFont* ttf, const char* text, u32 length,
+						   u32* glyph_indices);
+void ttf_glyph_indices_utf32(TrueTypeFont* ttf, const u32* text, u32 length,
+							 u32* glyph_indices);
+i16 ttf_kerning_get(TrueTypeFont* ttf, u32 left_glyph, u32 right_glyph);
+void ttf_measure_text(TrueTypeFont* ttf, const char* text, u32 length, u32 point_size,
+					  s32 max_width, TrueTypeFontTextMetrics* metrics);
+void ttf_measure_texts(TrueTypeFont* ttf, u32 count, const char** texts, const u32* lengths,
+					   u32 point_size, s32 max_width, TrueTypeFontTextMetrics* metrics);
+u32 ttf_text_fit(TrueTypeFont* ttf, const char* text, u32 length, u32 point_size,
+				 s32 max_width, s32* width);
+TrueTypeFontEdgeList* ttf_glyph_edges_get(TrueTypeFont* ttf, u32 glyph_index, s32 scale);
+void ttf_edge_cache_reset(TrueTypeFont* ttf, u32 capacity);
+TrueTypeFontMesh* ttf_glyph_mesh_get(TrueTypeFont* ttf, u32 glyph_index);
+void ttf_mesh_cache_reset(TrueTypeFont* ttf);
+void* ttf_create_bitmap(TrueTypeFont* ttf, char c, u32 width, u32 height,
+						TrueTypeFontRasterFlags flags);
+int ttf_create_font_atlas(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info,
+						  TrueTypeFontAtlas* atlas);
+int ttf_create_font_atlases(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info, u32 count,
+							const u32* point_sizes, TrueTypeFontAtlas* atlases);
+void ttf_font_atlas_free(TrueTypeFontAtlas* atlas);
+TrueTypeFontAtlasGlyph* ttf_font_atlas_glyph_get(TrueTypeFontAtlas* atlas, u32 code_point);
+void ttf_glyph_bitmap_create(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+							 TrueTypeFontRasterFlags flags, TrueTypeFontGlyphBitmap* bitmap);
+void ttf_glyph_bitmap_free(TrueTypeFontGlyphBitmap* bitmap);
+void ttf_arena_init(TrueTypeFontArena* arena, void* memory, u64 size);
+void ttf_glyph_bitmap_metrics(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+							  TrueTypeFontRasterFlags flags, TrueTypeFontGlyphBitmap* bitmap);
+u64 ttf_glyph_scratch_size(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						   TrueTypeFontRasterFlags flags);
+int ttf_glyph_rasterize(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						TrueTypeFontRasterFlags flags, const TrueTypeFontRasterTarget* target,
+						TrueTypeFontArena* scratch);
+u32 ttf_glyph_raster_lines(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						   TrueTypeFontRasterFlags flags, line2f* lines, s32* sdf_spread);
 
 // ---------------------------------------------------------------------------------
 /*
@@ -503,14 +758,16 @@ typedef struct VkdsManagerCreateInfo_t
 typedef enum VkdsBindingType_t
 {
 	VKDS_BINDING_TYPE_IMAGE_SAMPLER = 1,
-	VKDS_BINDING_TYPE_UNIFORM_BUFFER = 2
+	VKDS_BINDING_TYPE_UNIFORM_BUFFER = 2,
+	VKDS_BINDING_TYPE_STORAGE_BUFFER = 4
 } VkdsBindingType;
 typedef VkFlags VkdsBindingTypeFlags;
 
 typedef enum VkdsBindingStage_t
 {
 	VKDS_BINDING_STAGE_VERTEX = 1,
-	VKDS_BINDING_STAGE_FRAGMENT = 2
+	VKDS_BINDING_STAGE_FRAGMENT = 2,
+	VKDS_BINDING_STAGE_COMPUTE = 4
 } VkdsBindingStage;
 typedef VkFlags VkdsBindingStageFlags;
 
@@ -525,10 +782,16 @@ typedef struct VkdsBindingUniformData_t
 	VkbaVirtualBuffer* vbuffers;
 } VkdsBindingUniformData;
 
+typedef struct VkdsBindingStorageData_t
+{
+	VkbaVirtualBuffer* vbuffers;	// the whole VkBuffer is bound, index with locale.offset
+} VkdsBindingStorageData;
+
 typedef union VkdsBindingData_t
 {
 	VkdsBindingImageSamplerData imageSampler;
 	VkdsBindingUniformData uniformBuffer;
+	VkdsBindingStorageData storageBuffer;
 } VkdsBindingData;
 
 typedef struct VkdsBinding_t
@@ -574,6 +837,192 @@ void vktransitionimglayout(VkImage* image, VkBoilerplate* bp, VkCore* core,
 						  VkImageLayout new_layout);
 void vkcopybuftoimg(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
 					VkbaVirtualBuffer* vBuffer, uint32_t width, uint32_t height);
+void vkblanktexturec(VkTexture* texture, VkBoilerplate* bp, VkmaAllocator* mAllocator,
+					 VkFormat format, uint32_t width, uint32_t height);
+VkResult vkbmptexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
+					   VkmaAllocator* mAllocator, VkbaAllocator* bAllocator, const char* path);
+VkResult vkqoitexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
+					   VkmaAllocator* mAllocator, VkbaAllocator* bAllocator, const char* path);
+void vkcmdtransitionimglayout(VkCommandBuffer cmdbuf, VkImage image,
+							  VkImageLayout old_layout, VkImageLayout new_layout);
+
+// ---------------------------------------------------------------------------------
+/*
+  		VULKAN ENHANCED PIPELINE
+  		vken_pipeline.c
+ */
+// ---------------------------------------------------------------------------------
+
+typedef struct VkenPipeline_t
+{
+	VkDevice device_copy;
+	VkPipeline pipe;
+	VkPipelineLayout layout;
+} VkenPipeline;
+
+typedef enum VkenPipelineCreateFlagBits_t
+{
+	VKEN_PIPELINE_CREATE_ALPHA_BLEND_BIT = 0x00000001
+} VkenPipelineCreateFlagBits;
+typedef VkFlags VkenPipelineCreateFlags;
+
+typedef struct VkenPipelineCreateInfo_t
+{
+	char* vertex_shader_path;
+	char* fragment_shader_path;
+	u32 vertex_input_binding_description_count;
+	VkVertexInputBindingDescription* vertex_input_binding_descriptions;
+	u32 vertex_input_attribute_description_count;
+	VkVertexInputAttributeDescription* vertex_input_attribute_descriptions;
+	u32 descriptor_set_layout_count;
+	VkDescriptorSetLayout* layouts;
+	VkExtent2D extent;
+	VkDevice device;
+	VkRenderPass renderpass;
+	u32 subpass_index;
+	VkenPipelineCreateFlags flags;
+} VkenPipelineCreateInfo;
+
+typedef struct VkenComputePipelineCreateInfo_t
+{
+	char* compute_shader_path;
+	u32 descriptor_set_layout_count;
+	VkDescriptorSetLayout* layouts;
+	u32 push_constant_size;			// bytes, 0 for none
+	VkDevice device;
+} VkenComputePipelineCreateInfo;
+
+typedef struct VkenPipelineCache_t VkenPipelineCache;
+
+// void vkenInitializeCache();
+VkResult vkenCreatePipelines(u32 pipeline_count, VkenPipeline* pipelines,
+							 VkenPipelineCreateInfo* infos);
+VkResult vkenCreateComputePipelines(u32 pipeline_count, VkenPipeline* pipelines,
+									VkenComputePipelineCreateInfo* infos);
+void vkenDestroyPipeline(VkenPipeline* pipeline);
+
+// ---------------------------------------------------------------------------------
+/*
+  		VULKAN GLYPH CACHE
+  		vkgc_cache.c
+ */
+// ---------------------------------------------------------------------------------
+
+typedef enum VkgcCacheCreateFlagBits_t
+{
+	VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT = 0x00000001
+} VkgcCacheCreateFlagBits;
+typedef VkFlags VkgcCacheCreateFlags;
+
+typedef struct VkgcCacheCreateInfo_t
+{
+	VkBoilerplate* boilerplate;
+	VkmaAllocator* mAllocator;
+	VkbaAllocator* bAllocator;	// staging, from the host page
+	TrueTypeFont* font;
+	u32 pageSize;				// width and height, 0 for 1024
+	u32 maxPages;				// 0 for 4
+	u32 maxGlyphs;				// initial lookup capacity, 0 for 4096
+	u64 stagingSize;			// upload bytes per frame in flight, 0 for 64 KB
+	u32 padding;				// empty pixels around every glyph
+	TrueTypeFontRasterFlags rasterFlags;
+	VkgcCacheCreateFlags flags;
+	VkdsManager* dsManager;		// only for VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT
+} VkgcCacheCreateInfo;
+
+typedef struct VkgcGlyph_t
+{
+	u32 glyphIndex;				// 0xffffffff for empty slots
+	u32 pointSize;
+	u32 page;
+	u32 shelf;					// 0xffffffff for glyphs without pixels
+	u32 generation;				// stale once the shelf's generation moves on
+	u32 x;						// pixel rect in the page, padding included
+	u32 y;
+	u32 width;
+	u32 height;
+	float u0;
+	float v0;
+	float u1;
+	float v1;
+	s32 bearingX;				// same as TrueTypeFontAtlasGlyph
+	s32 bearingY;
+	s32 advance;
+} VkgcGlyph;
+
+typedef struct VkgcShelf_t
+{
+	u32 page;
+	u32 y;
+	u32 height;
+	u32 x;						// first free column
+	u32 generation;
+	u64 lastUsed;				// VkgcCache.frame
+} VkgcShelf;
+
+typedef struct VkgcPage_t
+{
+	VkTexture texture;			// R8_UNORM
+	u32 top;					// first row without a shelf
+	bool initialized;			// cleared and in SHADER_READ_ONLY_OPTIMAL
+	Array copies;				// VkBufferImageCopy, pending until vkgcRecordUploads
+} VkgcPage;
+
+typedef struct VkgcRasterJob_t
+{
+	u32 pixelWord;				// 4 byte words into the staging buffer's VkBuffer
+	u32 lineWord;				// line2f, in pixels from the glyph's top left
+	u32 numLines;
+	u32 width;
+	u32 height;
+	float sdfSpread;
+	u32 unused[2];
+} VkgcRasterJob;
+
+typedef struct VkgcStats_t
+{
+	u64 hits;
+	u64 misses;
+	u64 deferred;				// misses without room in staging or the pages
+	u64 evictions;				// shelves
+	u64 bytesUploaded;
+} VkgcStats;
+
+typedef struct VkgcCache_t
+{
+	VkBoilerplate* bp;
+	VkmaAllocator* mAllocator;
+	VkbaAllocator* bAllocator;
+	TrueTypeFont* font;
+	u32 pageSize;
+	u32 maxPages;
+	u32 padding;
+	TrueTypeFontRasterFlags rasterFlags;
+	u32 numPages;
+	VkgcPage* pages;
+	Array shelves;				// VkgcShelf
+	u32 capacity;				// power of two, open addressing
+	u32 numGlyphs;				// occupied slots, evicted ones included
+	VkgcGlyph* glyphs;
+	VkbaVirtualBuffer staging[MAX_FRAMES_IN_FLIGHT];
+	u64 stagingOffset;
+	TrueTypeFontArena scratch;	// rasterizer temporaries, grows to the largest glyph
+	VkgcCacheCreateFlags flags;
+	VkenPipeline rasterPipeline;	// shaders/glyph_raster.comp
+	VkDescriptorSet rasterSets[MAX_FRAMES_IN_FLIGHT];
+	Array rasterJobs;			// VkgcRasterJob, pending until vkgcRecordUploads
+	u32 frameIndex;
+	u64 frame;					// vkgcBeginFrame calls
+	VkgcStats frameStats;		// since the last vkgcBeginFrame
+	VkgcStats totalStats;		// every frame before that
+} VkgcCache;
+
+VkResult vkgcCreateCache(VkgcCache* cache, VkgcCacheCreateInfo* info);
+void vkgcDestroyCache(VkgcCache* cache);
+void vkgcBeginFrame(VkgcCache* cache, u32 frameIndex);
+VkgcGlyph* vkgcGetGlyph(VkgcCache* cache, u32 glyphIndex, u32 pointSize);
+void vkgcRecordUploads(VkgcCache* cache, VkCommandBuffer cmdBuffer);
+float vkgcHitRate(VkgcStats* stats);
 
 // ---------------------------------------------------------------------------------
 /*
@@ -598,7 +1047,9 @@ typedef enum VkbpInstruction_t
 	VKBP_INSTRUCTION_DRAW_INDEXED = 0x00000010,
 	VKBP_INSTRUCTION_START_PIPELINE = 0x00000020,
 	VKBP_INSTRUCTION_END_PIPELINE = 0x00000040,
-	VKBP_INSTRUCTION_BIND_INSTANCE_BUFFER = 0x00000080
+	VKBP_INSTRUCTION_BIND_INSTANCE_BUFFER = 0x00000080,
+	VKBP_INSTRUCTION_DRAW_INDEXED_PARAMS = 0x00000100,
+	VKBP_INSTRUCTION_DRAW_INDEXED_LIST = 0x00000200
 } VkbpInstruction;
 typedef u32 VkbpInstructionFlag;
 
@@ -608,7 +1059,6 @@ typedef struct VkbpBindingPipelineInfo_t
 		TODO:
 		 - implementation for other draws
 		 - implementation for multiple vertex buffers
-		 - implementation for instancing buffer
 	 */
 	
 	VkPipeline pipeline;
@@ -621,6 +1071,9 @@ typedef struct VkbpBindingPipelineInfo_t
 	VkDescriptorSet* descriptorSets;
 	u32 indexCount;
 	u32 instanceCount;
+	u64 instanceFrameStride;		// instance buffer offset added per frame in flight
+	VkDrawIndexedIndirectCommand* drawCommand;	// read when bound, replaces the counts
+	u32* drawCount;					// read when bound, drawCommand is then an array
 } VkbpBindingPipelineInfo;
 
 VkResult vkbpCreateMachine(VkbpMachine* machine, u64 size);
@@ -629,43 +1082,6 @@ u64 vkbpAddBindingPipeline(VkbpMachine* machine, VkbpBindingPipelineInfo* info);
 VkResult vkbpBindBindingPipeline(VkbpMachine* machine, VkCommandBuffer cmd, u32 frame,
 								  u64 offset);
 
-// ---------------------------------------------------------------------------------
-/*
-  		VULKAN ENHANCED PIPELINE
-  		vken_pipeline.c
- */
-// ---------------------------------------------------------------------------------
-
-typedef struct VkenPipeline_t
-{
-	VkDevice device_copy;
-	VkPipeline pipe;
-	VkPipelineLayout layout;
-} VkenPipeline;
-
-typedef struct VkenPipelineCreateInfo_t
-{
-	char* vertex_shader_path;
-	char* fragment_shader_path;
-	u32 vertex_input_binding_description_count;
-	VkVertexInputBindingDescription* vertex_input_binding_descriptions;
-	u32 vertex_input_attribute_description_count;
-	VkVertexInputAttributeDescription* vertex_input_attribute_descriptions;
-	u32 descriptor_set_layout_count;
-	VkDescriptorSetLayout* layouts;
-	VkExtent2D extent;
-	VkDevice device;
-	VkRenderPass renderpass;
-	u32 subpass_index;
-} VkenPipelineCreateInfo;
-
-typedef struct VkenPipelineCache_t VkenPipelineCache;
-
-// void vkenInitializeCache();
-VkResult vkenCreatePipelines(u32 pipeline_count, VkenPipeline* pipelines,
-							 VkenPipelineCreateInfo* infos);
-void vkenDestroyPipeline(VkenPipeline* pipeline);
-
 // ---------------------------------------------------------------------------------
 /*
   		vkdoodad.c
@@ -699,6 +1115,132 @@ void vkdoodadc(VkDoodad* doodad, VkbaAllocator* bAllocator, VkmaAllocator* mAllo
 void vkdoodadd(VkDoodad* doodad, VkbaAllocator* bAllocator,
 			   VkBoilerplate* bp, VkmaAllocator* mAllocator);
 
+// ---------------------------------------------------------------------------------
+/*
+  		VULKAN TEXT
+  		vktext.c
+ */
+// ---------------------------------------------------------------------------------
+
+typedef struct VktextInstance_t
+{
+	float rect[4];				// x, y, width, height in pixels, y down from the top left
+	float uv[4];				// u0, v0, u1, v1 in the glyph's cache page
+} VktextInstance;
+
+typedef struct VktextRendererCreateInfo_t
+{
+	VkBoilerplate* boilerplate;
+	VkCore* core;
+	VkbaAllocator* bAllocator;
+	VkdsManager* dsManager;
+	VkbpMachine* machine;
+	VkgcCache* cache;
+	u32 maxInstances;			// glyphs per frame, 0 for 4096
+} VktextRendererCreateInfo;
+
+typedef struct VktextPage_t
+{
+	u64 bindingId;
+	VkDescriptorSet dsets[MAX_FRAMES_IN_FLIGHT];
+	VkDrawIndexedIndirectCommand draw;	// this frame's instance range
+} VktextPage;
+
+typedef struct VktextRenderer_t
+{
+	VkBoilerplate* bp;
+	VkbaAllocator* bAllocator;
+	VkdsManager* dsManager;
+	VkbpMachine* machine;
+	VkgcCache* cache;
+	VkenPipeline pipeline;
+	VkDescriptorSetLayout dlayout;
+	VkbaVirtualBuffer vertexbuff;
+	VkbaVirtualBuffer indexbuff;
+	VkbaVirtualBuffer instbuff;		// maxInstances per frame in flight
+	float uboData[4];				// pixels to clip space, scale xy, offset zw
+	VkbaVirtualBuffer ubos[MAX_FRAMES_IN_FLIGHT];
+	u32 numPages;
+	VktextPage* pages;				// one per glyph cache page
+	u32 maxInstances;
+	u32 frameIndex;
+	Array instances;				// VktextInstance, laid out this frame
+	Array instancePages;			// u32
+	Array glyphIndices;				// u32, scratch
+} VktextRenderer;
+
+VkResult vktextCreateRenderer(VktextRenderer* renderer, VktextRendererCreateInfo* info);
+void vktextDestroyRenderer(VktextRenderer* renderer);
+void vktextBeginFrame(VktextRenderer* renderer, u32 frameIndex);
+u32 vktextAddText(VktextRenderer* renderer, const char* text, u32 length, u32 pointSize,
+				  float x, float y);
+void vktextEndFrame(VktextRenderer* renderer);
+void vktextDraw(VktextRenderer* renderer, VkCommandBuffer cmdBuffer);
+
+// ---------------------------------------------------------------------------------
+/*
+  		VULKAN VECTOR TEXT
+  		vkvt_text.c
+ */
+// ---------------------------------------------------------------------------------
+
+typedef struct VkvtInstance_t
+{
+	float pen[2];					// baseline origin in pixels, y down from the top left
+	float scale;					// pixels per font unit
+	float unused;
+} VkvtInstance;
+
+typedef struct VkvtRendererCreateInfo_t
+{
+	VkBoilerplate* boilerplate;
+	VkCore* core;
+	VkbaAllocator* bAllocator;
+	VkdsManager* dsManager;
+	VkbpMachine* machine;
+	TrueTypeFont* font;
+	u32 maxVertices;			// glyph mesh vertices kept on the gpu, 0 for 16384
+	u32 maxInstances;			// glyphs per frame, 0 for 2048
+} VkvtRendererCreateInfo;
+
+typedef struct VkvtRenderer_t
+{
+	VkBoilerplate* bp;
+	VkbaAllocator* bAllocator;
+	VkdsManager* dsManager;
+	VkbpMachine* machine;
+	TrueTypeFont* font;
+	VkenPipeline pipeline;
+	VkDescriptorSetLayout dlayout;
+	VkDescriptorSet dsets[MAX_FRAMES_IN_FLIGHT];
+	u64 bindingId;
+	VkbaVirtualBuffer vertexbuff;	// glyph meshes, appended on first use
+	VkbaVirtualBuffer indexbuff;	// 0, 1, 2, ... maxVertices - 1
+	VkbaVirtualBuffer instbuff;		// maxInstances per frame in flight
+	float uboData[4];				// pixels to clip space, scale xy, offset zw
+	VkbaVirtualBuffer ubos[MAX_FRAMES_IN_FLIGHT];
+	u32 maxVertices;
+	u32 numVertices;
+	u32 maxInstances;
+	u32 frameIndex;
+	u32* firstVertices;				// per glyph, ~0u until its mesh is uploaded
+	u32* glyphDraws;				// per glyph, its draw this frame or ~0u
+	u32* drawGlyphs;				// per draw, maxInstances
+	VkDrawIndexedIndirectCommand* draws;	// one per distinct glyph this frame
+	u32 drawCount;
+	Array instances;				// VkvtInstance, laid out this frame
+	Array instanceGlyphs;			// u32, glyph until vkvtEndFrame, then its draw
+	Array glyphIndices;				// u32, scratch
+} VkvtRenderer;
+
+VkResult vkvtCreateRenderer(VkvtRenderer* renderer, VkvtRendererCreateInfo* info);
+void vkvtDestroyRenderer(VkvtRenderer* renderer);
+void vkvtBeginFrame(VkvtRenderer* renderer, u32 frameIndex);
+u32 vkvtAddText(VkvtRenderer* renderer, const char* text, u32 length, float pointSize,
+				float x, float y);
+void vkvtEndFrame(VkvtRenderer* renderer);
+void vkvtDraw(VkvtRenderer* renderer, VkCommandBuffer cmdBuffer);
+
 // ---------------------------------------------------------------------------------
 /*
   		vkapp.c
@@ -714,6 +1256,10 @@ typedef struct
 	VkdsManager dsManager;
 	VkbpMachine machine;
 	VkDoodad doodad;
+	TrueTypeFont* font;
+	VkgcCache glyphCache;
+	VktextRenderer text;
+	VkvtRenderer vectorText;
 	uint32_t current_frame;
 } VkApp;
 
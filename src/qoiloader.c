@@ -0,0 +1,411 @@
+#include "grafics2.h"
+
+// header fields are big endian
+#if defined(_MSC_VER)
+#define QOI_BSWAP32(a) _byteswap_ulong(a)
+#else
+#define QOI_BSWAP32(a) __builtin_bswap32(a)
+#endif
+
+#define QOI_MAGIC "qoif"
+#define QOI_HEADER_SIZE 14
+#define QOI_PADDING 8					// 7 zero bytes and a one end the chunks
+#define QOI_MAX_PIXELS 400000000u
+
+#define QOI_OP_INDEX 0x00				// 00xxxxxx
+#define QOI_OP_DIFF 0x40				// 01xxxxxx
+#define QOI_OP_LUMA 0x80				// 10xxxxxx
+#define QOI_OP_RUN 0xc0					// 11xxxxxx
+#define QOI_OP_RGB 0xfe
+#define QOI_OP_RGBA 0xff
+#define QOI_MAX_RUN 62
+
+// pixels are R8G8B8A8 words, red in the low byte
+#define QOI_OPAQUE 0xff000000
+
+// rows for the encoder, 'dst' is R8G8B8A8 and tightly packed
+typedef void (*qoi_row_reader)(const void* user, uint32_t* dst, uint32_t first_row,
+							   uint32_t num_rows);
+
+typedef struct qoi_encoder
+{
+	uint32_t index[64];
+	uint32_t prev;
+	uint32_t run;
+} qoi_encoder;
+
+// pixels per band when encoding, the chunks of a band fit QOI_BAND_PIXELS * 5
+#define QOI_BAND_PIXELS (64 * 1024)
+
+static uint32_t qoi_u32(const u8* ptr)
+{
+	uint32_t value;
+	memcpy(&value, ptr, sizeof(uint32_t));
+	return QOI_BSWAP32(value);
+}
+
+static void qoi_put_u32(u8* ptr, uint32_t value)
+{
+	value = QOI_BSWAP32(value);
+	memcpy(ptr, &value, sizeof(uint32_t));
+}
+
+static uint32_t qoi_hash(uint32_t px)
+{
+	// (r * 3 + g * 5 + b * 7 + a * 11) % 64 with one multiply, the channels are
+	// spread to 16 bit lanes so that the top lane sums the weighted products
+	u64 lanes = ((u64) (px & 0xff00ff00) << 24) | (px & 0x00ff00ff);
+	return (uint32_t) ((lanes * 0x000300070005000bull) >> 48) & 63;
+}
+
+static uint32_t qoi_add_rgb(uint32_t px, uint32_t delta)
+{
+	// 'delta' holds a signed byte per color channel, each channel wraps on its
+	// own and alpha is kept
+	uint32_t sum = ((px & 0x007f7f7f) + (delta & 0x007f7f7f)) ^ ((px ^ delta) & 0x00808080);
+	return (px & QOI_OPAQUE) | sum;
+}
+
+static uint32_t qoi_delta(int32_t dr, int32_t dg, int32_t db)
+{
+	return ((u8) dr) | ((u32) (u8) dg << 8) | ((u32) (u8) db << 16);
+}
+
+static u8* qoi_encode(qoi_encoder* encoder, const uint32_t* src, uint32_t count,
+					  bool last, u8* out)
+{
+	/*
+		NOTE:
+		 - one op per pixel that isn't the previous one, runs carry over to the
+		   next call and end when they reach QOI_MAX_RUN or 'last' is set
+		 - at most 5 bytes per pixel
+	 */
+	uint32_t prev = encoder->prev;
+	uint32_t run = encoder->run;
+	for (uint32_t i = 0; i < count; i++) {
+		uint32_t px = src[i];
+		if (px == prev) {
+			if (++run == QOI_MAX_RUN) {
+				*out++ = QOI_OP_RUN | (run - 1);
+				run = 0;
+			}
+			continue;
+		}
+		if (run) {
+			*out++ = QOI_OP_RUN | (run - 1);
+			run = 0;
+		}
+
+		uint32_t hash = qoi_hash(px);
+		if (encoder->index[hash] == px) {
+			*out++ = QOI_OP_INDEX | hash;
+			prev = px;
+			continue;
+		}
+		encoder->index[hash] = px;
+
+		if ((px ^ prev) >> 24) {
+			*out++ = QOI_OP_RGBA;
+			memcpy(out, &px, sizeof(uint32_t));
+			out += 4;
+			prev = px;
+			continue;
+		}
+
+		int8_t dr = (int8_t) ((px & 0xff) - (prev & 0xff));
+		int8_t dg = (int8_t) (((px >> 8) & 0xff) - ((prev >> 8) & 0xff));
+		int8_t db = (int8_t) (((px >> 16) & 0xff) - ((prev >> 16) & 0xff));
+		int8_t dr_dg = dr - dg;
+		int8_t db_dg = db - dg;
+		if (-2 <= dr && dr <= 1 && -2 <= dg && dg <= 1 && -2 <= db && db <= 1) {
+			*out++ = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+		} else if (-32 <= dg && dg <= 31 && -8 <= dr_dg && dr_dg <= 7 &&
+				   -8 <= db_dg && db_dg <= 7) {
+			*out++ = QOI_OP_LUMA | (dg + 32);
+			*out++ = (dr_dg + 8) << 4 | (db_dg + 8);
+		} else {
+			*out++ = QOI_OP_RGB;
+			*out++ = px & 0xff;
+			*out++ = (px >> 8) & 0xff;
+			*out++ = (px >> 16) & 0xff;
+		}
+		prev = px;
+	}
+	if (last && run) {
+		*out++ = QOI_OP_RUN | (run - 1);
+		run = 0;
+	}
+	encoder->prev = prev;
+	encoder->run = run;
+	return out;
+}
+
+static int qoi_write(const char* file, uint32_t width, uint32_t height, uint32_t channels,
+					 qoi_row_reader read_rows, const void* user)
+{
+	// the image goes through a band of rows at a time, neither it nor the
+	// encoded file are ever whole in memory
+	if (width == 0 || height == 0 || QOI_MAX_PIXELS / width < height) {
+		printf("qoi_save(%s) --- %ux%u is unsupported\n", file, width, height);
+		return 0;
+	}
+
+	FILE* out = fopen(file, "wb");
+	if (!out) {
+		printf("qoi_save(%s) --- unable to open\n", file);
+		return 0;
+	}
+
+	u8 header[QOI_HEADER_SIZE];
+	memcpy(header, QOI_MAGIC, 4);
+	qoi_put_u32(header + 4, width);
+	qoi_put_u32(header + 8, height);
+	header[12] = (u8) channels;
+	header[13] = 0;							// srgb with linear alpha
+	bool written = fwrite(header, QOI_HEADER_SIZE, 1, out) == 1;
+
+	uint32_t band_rows = MAX(QOI_BAND_PIXELS / width, 1);
+	uint32_t* pixels = (uint32_t*) malloc((u64) band_rows * width * sizeof(uint32_t));
+	u8* chunks = (u8*) malloc((u64) band_rows * width * 5);
+
+	qoi_encoder encoder = (qoi_encoder) { .prev = QOI_OPAQUE };
+	for (uint32_t y = 0; y < height && written; y += band_rows) {
+		uint32_t rows = MIN(band_rows, height - y);
+		read_rows(user, pixels, y, rows);
+		u8* end = qoi_encode(&encoder, pixels, rows * width, y + rows == height, chunks);
+		written = fwrite(chunks, end - chunks, 1, out) == 1;
+	}
+
+	static const u8 padding[QOI_PADDING] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	written = written && fwrite(padding, QOI_PADDING, 1, out) == 1;
+	written = (fclose(out) == 0) && written;
+
+	free(chunks);
+	free(pixels);
+	if (!written) {
+		printf("qoi_save(%s) --- write failed\n", file);
+	}
+	return written;
+}
+
+typedef struct qoi_buffer
+{
+	const u8* pixels;
+	uint32_t width;
+	uint32_t bytes_per_pixel;
+} qoi_buffer;
+
+static void qoi_buffer_rows(const void* user, uint32_t* dst, uint32_t first_row,
+							uint32_t num_rows)
+{
+	const qoi_buffer* buffer = (const qoi_buffer*) user;
+	uint32_t count = num_rows * buffer->width;
+	const u8* src = buffer->pixels + (u64) first_row * buffer->width * buffer->bytes_per_pixel;
+	if (buffer->bytes_per_pixel == 4) {
+		memcpy(dst, src, count * sizeof(uint32_t));
+		return;
+	}
+	for (uint32_t i = 0; i < count; i++, src += 3) {
+		dst[i] = src[0] | (u32) src[1] << 8 | (u32) src[2] << 16 | QOI_OPAQUE;
+	}
+}
+
+static void qoi_bmp_rows(const void* user, uint32_t* dst, uint32_t first_row,
+						 uint32_t num_rows)
+{
+	const BmpImage* bmp = (const BmpImage*) user;
+	bmp_decode_rows(bmp, dst, 4 * bmp->width, first_row, num_rows);
+	bmp_release_rows(bmp, first_row, num_rows);
+}
+
+int qoi_open(QoiImage* qoi, const char* file)
+{
+	/*
+		USAGE:
+		QoiImage qoi;
+		if (qoi_open(&qoi, "image.qoi") == 1) {
+			qoi_decode_rows(&qoi, staging.dst, 4 * qoi.width, qoi.height);
+			qoi_close(&qoi);
+		}
+
+		NOTE:
+		 - the file is mapped and only its header is read, 1 on success, 0 if it
+		   can't be opened and -1 if it is not a qoi image
+		 - chunks are decoded in order, qoi_decode_rows() carries on from where
+		   the last call stopped
+	 */
+	*qoi = (QoiImage) { 0 };
+
+	uint32_t size;
+	u8* view = file_map(file, &size);
+	if (view == NULL) { return 0; }
+
+	bool valid = QOI_HEADER_SIZE + QOI_PADDING <= size && memcmp(view, QOI_MAGIC, 4) == 0;
+	if (valid) {
+		qoi->width = qoi_u32(view + 4);
+		qoi->height = qoi_u32(view + 8);
+		qoi->channels = view[12];
+		qoi->colorspace = view[13];
+		valid = qoi->width != 0 && qoi->height != 0 &&
+			QOI_MAX_PIXELS / qoi->width >= qoi->height &&
+			(qoi->channels == 3 || qoi->channels == 4) && qoi->colorspace <= 1;
+	}
+	if (!valid) {
+		printf("qoi_open(%s) --- not a qoi image\n", file);
+		file_unmap(view);
+		*qoi = (QoiImage) { 0 };
+		return -1;
+	}
+
+	qoi->data = view + QOI_HEADER_SIZE;
+	qoi->end = view + size - QOI_PADDING;
+	qoi->next = qoi->data;
+	qoi->released = qoi->data;
+	qoi->px = QOI_OPAQUE;
+	qoi->view = view;
+	return 1;
+}
+
+void qoi_decode_rows(QoiImage* qoi, void* dst, uint32_t stride, uint32_t num_rows)
+{
+	/*
+		NOTE:
+		 - R8G8B8A8, the next 'num_rows' rows top to bottom and 'stride' bytes
+		   apart, 'dst' is only written, in order, so it can be write combined
+		 - 3 channel images decode with an opaque alpha
+		 - a truncated file repeats the last pixel, the ops only read up to the
+		   padding so a bad file can't read past the mapping
+	 */
+	const u8* next = qoi->next;
+	const u8* end = qoi->end;
+	uint32_t px = qoi->px;
+	uint32_t run = qoi->run;
+	uint32_t* index = qoi->index;
+
+	num_rows = MIN(num_rows, qoi->height - qoi->row);
+	for (uint32_t y = 0; y < num_rows; y++) {
+		uint32_t* out = (uint32_t*) ((u8*) dst + (u64) y * stride);
+		uint32_t width = qoi->width;
+		uint32_t x = 0;
+		// a run can carry over from the previous row, it's the only one that can
+		// start a row, every other run ends in the row it's read for
+		if (run) {
+			uint32_t count = MIN(run, width);
+			for (uint32_t i = 0; i < count; i++) {
+				out[i] = px;
+			}
+			x = count;
+			run -= count;
+		}
+		while (x < width) {
+			if (next >= end) {
+				// no chunks left, the rest of the image is the last pixel
+				run = ~0u;
+				for (; x < width; x++) {
+					out[x] = px;
+				}
+				break;
+			}
+
+			u8 op = *next++;
+			if (op < QOI_OP_DIFF) {
+				px = index[op];
+				out[x++] = px;
+				continue;
+			}
+			if (op < QOI_OP_LUMA) {
+				px = qoi_add_rgb(px, qoi_delta(((op >> 4) & 3) - 2, ((op >> 2) & 3) - 2,
+											   (op & 3) - 2));
+			} else if (op < QOI_OP_RUN) {
+				int32_t dg = (op & 0x3f) - 32;
+				u8 drb = *next++;
+				px = qoi_add_rgb(px, qoi_delta(dg - 8 + (drb >> 4), dg, dg - 8 + (drb & 0xf)));
+			} else if (op < QOI_OP_RGB) {
+				// the run includes the pixel it is read for
+				uint32_t length = (op & 0x3f) + 1;
+				uint32_t count = MIN(length, width - x);
+				for (uint32_t i = 0; i < count; i++) {
+					out[x + i] = px;
+				}
+				x += count;
+				run = length - count;
+				index[qoi_hash(px)] = px;
+				continue;
+			} else if (op == QOI_OP_RGB) {
+				px = (px & QOI_OPAQUE) | next[0] | (u32) next[1] << 8 | (u32) next[2] << 16;
+				next += 3;
+			} else {
+				memcpy(&px, next, sizeof(uint32_t));
+				next += 4;
+			}
+			index[qoi_hash(px)] = px;
+			out[x++] = px;
+		}
+	}
+
+	qoi->next = next;
+	qoi->px = px;
+	qoi->run = run;
+	qoi->row += num_rows;
+}
+
+void qoi_release(QoiImage* qoi)
+{
+	// chunks already decoded leave the working set, see bmp_release_rows()
+	file_release(qoi->released, (uint32_t) (qoi->next - qoi->released));
+	qoi->released = qoi->next;
+}
+
+void qoi_close(QoiImage* qoi)
+{
+	file_unmap(qoi->view);
+	*qoi = (QoiImage) { 0 };
+}
+
+char* qoi_load(const char* file, uint32_t* width, uint32_t* height)
+{
+	// R8G8B8A8 in a buffer of its own, free it with bmp_free()
+	QoiImage qoi;
+	if (qoi_open(&qoi, file) != 1) { return NULL; }
+
+	*width = qoi.width;
+	*height = qoi.height;
+	char* buffer = (char*) malloc(4 * (u64) qoi.width * qoi.height);
+	qoi_decode_rows(&qoi, buffer, 4 * qoi.width, qoi.height);
+	qoi_close(&qoi);
+
+	return buffer;
+}
+
+int qoi_save(const char* file, const char* pixels, u32 width, u32 height, i32 bytes_per_pixel)
+{
+	/*
+		NOTE:
+		 - 'pixels' holds tightly packed rgb or rgba rows top to bottom, 3 or 4
+		   bytes per pixel, saved with as many channels
+		 - 1 on success, 0 otherwise
+	 */
+	if (bytes_per_pixel != 3 && bytes_per_pixel != 4) {
+		printf("qoi_save(%s) --- %d bytes per pixel unsupported\n", file, bytes_per_pixel);
+		return 0;
+	}
+	qoi_buffer buffer = { (const u8*) pixels, width, (u32) bytes_per_pixel };
+	return qoi_write(file, width, height, bytes_per_pixel, qoi_buffer_rows, &buffer);
+}
+
+int qoi_convert_bmp(const char* bmp_file, const char* qoi_file)
+{
+	/*
+		NOTE:
+		 - decodes and encodes a band of rows at a time, any size of bmp converts
+		   in a few hundred kilobytes
+		 - 4 channels only when the bmp keeps an alpha mask, 1 on success
+	 */
+	BmpImage bmp;
+	if (bmp_open(&bmp, bmp_file) != 1) { return 0; }
+
+	int result = qoi_write(qoi_file, bmp.width, bmp.height, bmp.alpha ? 4 : 3,
+						   qoi_bmp_rows, &bmp);
+	bmp_close(&bmp);
+	return result;
+}
@@ -1,9 +1,17 @@
 #include "grafics2.h"
 
-#define ENDIAN_WORD(a) ((((0xFF00 & a) >> 8) | ((0x00FF & a) << 8)))
-#define ENDIAN_DWORD(a) \
-	(((0xFF000000 & a) >> 24) | ((0x00FF0000 & a) >> 8) |		\
-	 ((0x0000FF00 & a) << 8) | ((0x000000FF & a) << 24))
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// font files are big endian, both compile to a single instruction
+#if defined(_MSC_VER)
+#define TTF_BSWAP16(a) _byteswap_ushort(a)
+#define TTF_BSWAP32(a) _byteswap_ulong(a)
+#else
+#define TTF_BSWAP16(a) __builtin_bswap16(a)
+#define TTF_BSWAP32(a) __builtin_bswap32(a)
+#endif
 
 #define U64_SIZE sizeof(u64)
 #define U32_SIZE sizeof(u32)
@@ -16,22 +24,389 @@
 #define TTF_GLYF_TAG 0x676c7966
 #define TTF_HHEA_TAG 0x68686561
 #define TTF_HMTX_TAG 0x686d7478
+#define TTF_KERN_TAG 0x6b65726e
 
+#define TTF_UNICODE_PLATFORM_ID 0
 #define TTF_WIN_PLATFORM_ID 3
+#define TTF_WIN_UCS4_ID 10
 #define TTF_FLAG_REPEAT 0x08
 
+// compound glyph component flags
+#define TTF_COMPOUND_ARG_WORDS 0x0001
+#define TTF_COMPOUND_ARGS_XY 0x0002
+#define TTF_COMPOUND_SCALE 0x0008
+#define TTF_COMPOUND_MORE 0x0020
+#define TTF_COMPOUND_XY_SCALE 0x0040
+#define TTF_COMPOUND_2X2 0x0080
+#define TTF_COMPOUND_MY_METRICS 0x0200
+#define TTF_COMPOUND_SCALED_OFFSET 0x0800
+#define TTF_COMPOUND_UNSCALED_OFFSET 0x1000
+// compound glyphs made of compound glyphs, deeper components are left out
+#define TTF_COMPOUND_MAX_DEPTH 16
+
+// flattened curves stay this close to the true outline, in pixels
+#define TTF_FLATTEN_TOLERANCE 0.2f
+#define TTF_FLATTEN_MAX_SEGMENTS 64
+// edge lists are cached per power of two pixels per em up to 2^15
+#define TTF_EDGE_CACHE_BUCKETS 16
+#define TTF_EDGE_CACHE_SIZE 512
+// mesh curves are probed this many font units to either side for their ink
+#define TTF_MESH_PROBE 0.5f
+// rounds of halving curves whose control triangles overlap the rest of the outline
+#define TTF_MESH_MAX_SPLITS 4
+#define TTF_ATLAS_MAX_THREADS MAXIMUM_WAIT_OBJECTS
+#define TTF_ATLAS_MAX_SIZE 4096
+// a glyph cell is never wider or taller, past it a glyph rasterizes to nothing
+#define TTF_GLYPH_MAX_CELL 4096
+
+// code points below this are looked up in a direct table, Latin, Greek, Cyrillic,
+// Hebrew, Arabic, ... fit, everything else binary searches the cmap groups
+#define TTF_CMAP_DENSE_SIZE 0x2000
+
+// 'TTFC', bump the version whenever the cached structs change
+// sub-arrays of the font block start 8 byte aligned, like in the cache file
+#define TTF_ALIGN8(size) (((size) + 7) & ~7ull)
+
+#define TTF_CACHE_MAGIC 0x43465454
+#define TTF_CACHE_VERSION 3
+#define TTF_CACHE_BYTE_ORDER 0x01020304
+// 'TTFA', bump the version whenever rasterized pixels or TrueTypeFontAtlasGlyph change
+#define TTF_ATLAS_CACHE_MAGIC 0x41465454
+#define TTF_ATLAS_CACHE_VERSION 1
+
+// a window of the font file, a read past its end fails the reader, returns 0 and
+// so does every read after it, a table is read first and checked once
+typedef struct TrueTypeFontReader_t
+{
+	const u8* data;
+	u32 size;
+	u32 offset;
+	bool error;
+} TrueTypeFontReader;
+
+typedef struct TrueTypeFontCmapBuilder_t
+{
+	u32 num_glyphs;					// ranges are cut to the font's glyphs
+	u32 count;
+	TrueTypeFontCmapGroup last;
+	TrueTypeFontCmapGroup* groups;		// NULL to only count groups
+} TrueTypeFontCmapBuilder;
+
+// x' = a * x + c * y + dx, y' = b * x + d * y + dy with transform { a, b, c, d }
+typedef struct TrueTypeFontComponent_t
+{
+	u16 flags;
+	u16 glyph_index;
+	i32 args[2];					// offset, or parent and component point to match
+	s32 transform[4];
+} TrueTypeFontComponent;
+
+typedef struct TrueTypeFontCacheHeader_t
+{
+	u32 magic;
+	u32 version;
+	u32 byte_order;					// reads back differently on the other endianness
+	u32 font_size;					// sizeof(TrueTypeFont) of the writer
+	u64 source_hash;
+	u32 source_size;
+	u32 file_size;
+} TrueTypeFontCacheHeader;
+
+// everything an atlas depends on besides the rasterizer, hashed into the file name
+typedef struct TrueTypeFontAtlasCacheKey_t
+{
+	u32 version;
+	u32 byte_order;
+	u64 source_hash;
+	u64 charset_hash;				// of the unique code points in ascending order
+	u32 num_code_points;
+	u32 point_size;
+	u32 padding;
+	u32 max_size;
+	s32 sdf_spread;					// as asked for, 0 for the default
+	TrueTypeFontRasterFlags flags;
+} TrueTypeFontAtlasCacheKey;
+
+typedef struct TrueTypeFontAtlasCacheHeader_t
+{
+	u32 magic;
+	u32 file_size;
+	TrueTypeFontAtlasCacheKey key;
+	u32 width;
+	u32 height;
+	s32 scale;
+	s32 ascent;
+	s32 descent;
+	s32 sdf_spread;
+	u32 num_glyphs;
+	u32 unused;
+} TrueTypeFontAtlasCacheHeader;
+
+typedef struct TrueTypeFontAtlasCell_t
+{
+	u32 x;
+	u32 y;
+	u32 width;
+	u32 height;
+	u32 first_line;
+	u32 num_lines;
+	u32 atlas;						// index into TrueTypeFontAtlasJob.atlases
+} TrueTypeFontAtlasCell;
+
+typedef struct TrueTypeFontAtlasJob_t
+{
+	const line2f* lines;			// cell coordinates
+	TrueTypeFontAtlasCell* cells;
+	u32 num_cells;
+	TrueTypeFontAtlas* atlases;		// bitmap, width and sdf_spread of every cell
+	TrueTypeFontRasterFlags flags;
+	u64 scratch_size;				// per worker
+	volatile LONG next_cell;
+} TrueTypeFontAtlasJob;
+
+typedef struct TrueTypeFontSkylineNode_t
+{
+	u32 x;
+	u32 y;							// top of what is packed below the segment
+	u32 width;
+} TrueTypeFontSkylineNode;
+
+typedef struct TrueTypeFontEdge_t
+{
+	s32 y_min;
+	s32 y_max;
+	s32 x0;
+	s32 y0;
+	s32 dxdy;
+} TrueTypeFontEdge;
+
+typedef struct TrueTypeFontCrossing_t
+{
+	s32 x;
+	i32 winding;
+} TrueTypeFontCrossing;
+
+typedef struct TrueTypeFontMeshEdge_t
+{
+	vec2f p0;						// p0.y < p1.y
+	vec2f p1;
+	i32 winding;					// +1 when the outline goes up
+} TrueTypeFontMeshEdge;
+
+typedef struct TrueTypeFontMeshSegment_t
+{
+	vec2f p0;
+	vec2f c;						// unused by lines
+	vec2f p1;
+	bool curve;
+} TrueTypeFontMeshSegment;
+
+typedef struct TrueTypeFontMeshSpan_t
+{
+	u32 left;						// edges
+	u32 right;
+	s32 y;							// bottom of the trapezoid so far
+} TrueTypeFontMeshSpan;
+
 s32 f2fot14_to_float_2(u16 f2dot14);
+static int ttf_load_invalid(char* buffer, const char* font_path, const char* table);
+static void ttf_cmap_build(TrueTypeFontCmapBuilder* builder, TrueTypeFontReader subtable);
+static bool ttf_component_read(TrueTypeFontReader* reader, TrueTypeFontComponent* component);
+static u32 ttf_kern_build(TrueTypeFontReader table, TrueTypeFontKernPair* pairs);
+static void ttf_glyph_decode(TrueTypeFont* ttf, u32 glyph_index, u32 depth);
+
+static void ttf_outlines_reserve(TrueTypeFontOutlines* outlines, u32 num_points,
+								 u32 num_contours);
+static void ttf_outlines_shrink(TrueTypeFontOutlines* outlines);
+static void ttf_outlines_free(TrueTypeFontOutlines* outlines);
+
+static void* ttf_arena_push(TrueTypeFontArena* arena, u64 size);
+static u32 ttf_edge_bucket(TrueTypeFont* ttf, s32 scale);
+static u32 ttf_glyph_lines(const TrueTypeFontEdgeList* edges, s32 scale, s32 offset_x,
+						   s32 offset_y, bool mirror_x, line2f* lines);
+static u64 ttf_fill_scratch_size(u32 num_lines, u32 span, u32 height,
+								 TrueTypeFontRasterFlags flags);
+static void ttf_fill_lines(const line2f* lines, u32 num_lines, u8* bmp, u32 stride,
+						   u32 span, u32 x0, u32 y0, u32 width, u32 height,
+						   TrueTypeFontRasterFlags flags, s32 sdf_spread,
+						   TrueTypeFontArena* scratch);
+static s32 ttf_glyph_raster_scale(TrueTypeFont* ttf, u32 point_size,
+								  TrueTypeFontRasterFlags flags, u32* padding, s32* spread);
+static void ttf_glyph_cell_measure(TrueTypeFont* ttf, TrueTypeFontAtlasGlyph* entry,
+								   s32 scale, u32 padding, TrueTypeFontAtlasCell* cell);
+static u32 ttf_atlas_code_points(const char* characters, u32** code_points);
+static int ttf_atlases_rasterize(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info,
+								 u32 count, const u32* point_sizes, const u32* code_points,
+								 u32 num_glyphs, TrueTypeFontAtlas* atlases);
+static bool ttf_atlas_cache_path(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 char* path, u32 size);
+static bool ttf_atlas_cache_load(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 TrueTypeFontAtlas* atlas);
+static void ttf_atlas_cache_save(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 const TrueTypeFontAtlas* atlas);
+static DWORD WINAPI ttf_atlas_worker(LPVOID user_data);
+static bool ttf_skyline_pack(TrueTypeFontAtlasCell* cells, u64* order, u32 num_cells,
+							 u32 width, u32 height, TrueTypeFontSkylineNode* nodes);
+static void ttf_mesh_outline(TrueTypeFont* ttf, u32 glyph_index, Array* edges,
+							 Array* vertices);
+static void ttf_mesh_fill(const TrueTypeFontMeshEdge* edges, u32 num_edges, Array* vertices);
+static u32 ttf_utf8_next(const u8** text, const u8* end);
+static i32 ttf_u32_cmp(const void* a, const void* b);
+static i32 ttf_u64_cmp(const void* a, const void* b);
+static u64 ttf_hash(const void* data, u64 size);
+static void* ttf_cache_put(void* font, u64* tail, const void* src, u64 size);
+static bool ttf_cache_relocate(TrueTypeFont* ttf, u64 limit, void** ptr, u64 size);
+
+static inline u16 ttf_be16(const u8* ptr)
+{
+	// memcpy keeps unaligned loads legal, it becomes a plain load
+	u16 value;
+	memcpy(&value, ptr, U16_SIZE);
+	return TTF_BSWAP16(value);
+}
+
+static inline u32 ttf_be32(const u8* ptr)
+{
+	u32 value;
+	memcpy(&value, ptr, U32_SIZE);
+	return TTF_BSWAP32(value);
+}
+
+static TrueTypeFontReader ttf_reader(const void* data, u64 size, u64 offset, u64 length)
+{
+	// offset..offset + length of data, a failed empty reader if it does not fit
+	if (size < offset || size - offset < length) {
+		return (TrueTypeFontReader) { (const u8*) data, 0, 0, true };
+	}
+	return (TrueTypeFontReader) { (const u8*) data + offset, (u32) length, 0, false };
+}
+
+static TrueTypeFontReader ttf_reader_at(const TrueTypeFontReader* reader, u64 offset)
+{
+	// from offset to the end of reader's window
+	if (reader->size < offset) { return ttf_reader(reader->data, 0, 1, 0); }
+	return ttf_reader(reader->data, reader->size, offset, reader->size - offset);
+}
+
+static inline bool ttf_reader_check(TrueTypeFontReader* reader, u64 size)
+{
+	if (reader->error || reader->size - reader->offset < size) {
+		reader->error = true;
+		reader->offset = reader->size;
+		return false;
+	}
+	return true;
+}
+
+static inline const u8* ttf_read_bytes(TrueTypeFontReader* reader, u64 size)
+{
+	// NULL if the window is shorter than size
+	if (!ttf_reader_check(reader, size)) { return NULL; }
+	const u8* ptr = reader->data + reader->offset;
+	reader->offset += size;
+	return ptr;
+}
+
+static inline void ttf_reader_skip(TrueTypeFontReader* reader, u64 size)
+{
+	if (ttf_reader_check(reader, size)) { reader->offset += size; }
+}
+
+static inline u8 ttf_read_u8(TrueTypeFontReader* reader)
+{
+	if (!ttf_reader_check(reader, 1)) { return 0; }
+	return reader->data[reader->offset++];
+}
+
+static inline u16 ttf_read_u16(TrueTypeFontReader* reader)
+{
+	if (!ttf_reader_check(reader, U16_SIZE)) { return 0; }
+	u16 value = ttf_be16(reader->data + reader->offset);
+	reader->offset += U16_SIZE;
+	return value;
+}
+
+static inline u32 ttf_read_u32(TrueTypeFontReader* reader)
+{
+	if (!ttf_reader_check(reader, U32_SIZE)) { return 0; }
+	u32 value = ttf_be32(reader->data + reader->offset);
+	reader->offset += U32_SIZE;
+	return value;
+}
+
+static void ttf_swap16(u16* dst, const u8* src, u32 count)
+{
+	// big endian words to native ones, 8 at a time
+	u32 i = 0;
+#if defined(__SSE2__)
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + i * U16_SIZE));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*) (dst + i), v);
+	}
+#endif
+	for (; i < count; i++) { dst[i] = ttf_be16(src + i * U16_SIZE); }
+}
+
+static void ttf_swap32(u32* dst, const u8* src, u32 count)
+{
+	// the bytes of every word, then the words of every dword
+	u32 i = 0;
+#if defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + i * U32_SIZE));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+		_mm_storeu_si128((__m128i*) (dst + i), v);
+	}
+#endif
+	for (; i < count; i++) { dst[i] = ttf_be32(src + i * U32_SIZE); }
+}
+
+static void ttf_swap16_loca(u32* dst, const u8* src, u32 count)
+{
+	// the short loca format, words that count 2 byte units
+	u32 i = 0;
+#if defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= count; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i*) (src + i * U16_SIZE));
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i*) (dst + i), _mm_slli_epi32(_mm_unpacklo_epi16(v, zero), 1));
+		_mm_storeu_si128((__m128i*) (dst + i + 4),
+						 _mm_slli_epi32(_mm_unpackhi_epi16(v, zero), 1));
+	}
+#endif
+	for (; i < count; i++) { dst[i] = (u32) ttf_be16(src + i * U16_SIZE) << 1; }
+}
 
-int ttf_load(TrueTypeFont** true_type_font, const char* font_path)
+static bool ttf_read_u16s(TrueTypeFontReader* reader, u16* dst, u32 count)
 {
+	const u8* src = ttf_read_bytes(reader, (u64) count * U16_SIZE);
+	if (src == NULL) { return false; }
+	ttf_swap16(dst, src, count);
+	return true;
+}
+
+int ttf_load(TrueTypeFont** true_type_font, const char* font_path,
+			 TrueTypeFontLoadFlags flags)
+{
+	/*
+	  	NOTE:
+		 - returns 1 on success, 0 if the file can't be read and -1 for anything
+		   that is not a font this parser handles, every read is checked against
+		   the table it belongs to so malformed files fail here instead of crashing
+		 - glyphs with broken outline data load as empty glyphs with metrics
+	 */
 	u32 buffer_size;
 	char* buffer = file_read(font_path, &buffer_size);
 	if (buffer == NULL) { return 0; }
 
-	u16 num_tables = ENDIAN_WORD(*((u16*) (buffer + U32_SIZE)));
+	TrueTypeFontReader file = ttf_reader(buffer, buffer_size, 0, buffer_size);
+	ttf_reader_skip(&file, U32_SIZE);		// sfnt version
+	u16 num_tables = ttf_read_u16(&file);
+	ttf_reader_skip(&file, 3 * U16_SIZE);	// rest of the 'offset subtable'
 
-	u64 table_size = 4 * U32_SIZE;
-	u64 offset = U32_SIZE + 4 * U16_SIZE;	// sizeof 'offset subtable'
 	TrueTypeFontTable tables[] = {
 		(TrueTypeFontTable) { 0, 0 },	// head
 		(TrueTypeFontTable) { 0, 0 },	// maxp
@@ -41,846 +416,3092 @@ int ttf_load(TrueTypeFont** true_type_font, const char* font_path)
 		(TrueTypeFontTable) { 0, 0 },	// hhea
 		(TrueTypeFontTable) { 0, 0 }	// hmtx
 	};
-	u32 tables_found = 0;
-	for (u16 i = 0; i < num_tables; i++) {
-		u32 tag = ENDIAN_DWORD(*((u32*) (buffer + offset)));
-		// u32 checksum = ENDIAN_DWORD(*((u32*) (buffer + offset + U32_SIZE)));
-		u32 table_offset = ENDIAN_DWORD(*((u32*) (buffer + offset + 2 * U32_SIZE)));
-		u32 table_length = ENDIAN_DWORD(*((u32*) (buffer + offset + 3 * U32_SIZE)));
-
+	TrueTypeFontTable kern_table = (TrueTypeFontTable) { 0, 0 };
+	u32 tables_found = 0;				// one bit per entry of tables
+	for (u16 i = 0; i < num_tables && !file.error; i++) {
+		u32 tag = ttf_read_u32(&file);
+		ttf_reader_skip(&file, U32_SIZE);	// checksum
+		u32 table_offset = ttf_read_u32(&file);
+		u32 table_length = ttf_read_u32(&file);
+		// tables that do not fit the file are treated as missing
+		if (file.error || buffer_size < (u64) table_offset + table_length) { continue; }
+
+		u32 index = ~0u;
 		switch (tag) {
-		case TTF_HEAD_TAG:
-			tables[0] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_MAXP_TAG:
-			tables[1] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_CMAP_TAG:
-			tables[2] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_LOCA_TAG:
-			tables[3] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_GLYF_TAG:
-			tables[4] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_HHEA_TAG:
-			tables[5] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
-			break;
-		case TTF_HMTX_TAG:
-			tables[6] = (TrueTypeFontTable) { table_offset, table_length };
-			tables_found++;
+		case TTF_HEAD_TAG: index = 0; break;
+		case TTF_MAXP_TAG: index = 1; break;
+		case TTF_CMAP_TAG: index = 2; break;
+		case TTF_LOCA_TAG: index = 3; break;
+		case TTF_GLYF_TAG: index = 4; break;
+		case TTF_HHEA_TAG: index = 5; break;
+		case TTF_HMTX_TAG: index = 6; break;
+		case TTF_KERN_TAG:
+			// optional, fonts without one simply do not kern
+			kern_table = (TrueTypeFontTable) { table_offset, table_length };
 			break;
 		}
-		offset += table_size;
+		if (index != ~0u) {
+			tables[index] = (TrueTypeFontTable) { table_offset, table_length };
+			tables_found |= 1u << index;
+		}
 	}
 
-	if (tables_found != 7) { return -1; }
-
-	// calculate allocation size
-	/*
-		size = sizeof(ttf) +							// sizeof of ttf struct
-			   sizeof(u16) * 4 * seg_count +			// sizeof cmap stuff
-			   sizeof(u32) * num_glyfs +				// sizeof loca
-			   sizeof(glyf) * num_glyf +				// sizeof glyf array
-			   ng * max_points * 3 * sizeof(u16)		// sizeof of glyf arrays * length
-			   ng * max_points;
-
+	if (tables_found != 0x7f) { return ttf_load_invalid(buffer, font_path, "table directory"); }
+
+	TrueTypeFontReader head = ttf_reader(buffer, buffer_size, tables[0].offset,
+										 tables[0].length);
+	ttf_reader_skip(&head, 4 * U32_SIZE + U16_SIZE);
+	u16 units_per_em = ttf_read_u16(&head);
+	ttf_reader_skip(&head, 2 * U64_SIZE);	// created, modified
+	i16 x_min = (i16) ttf_read_u16(&head);
+	i16 y_min = (i16) ttf_read_u16(&head);
+	i16 x_max = (i16) ttf_read_u16(&head);
+	i16 y_max = (i16) ttf_read_u16(&head);
+	ttf_reader_skip(&head, U16_SIZE);		// mac style
+	u16 lowest_rec_ppem = ttf_read_u16(&head);
+	ttf_reader_skip(&head, U16_SIZE);		// font direction hint
+	i16 index_to_loc_format = (i16) ttf_read_u16(&head);
+	if (head.error || units_per_em < 16 || 16384 < units_per_em ||
+		(index_to_loc_format != 0 && index_to_loc_format != 1)) {
+		return ttf_load_invalid(buffer, font_path, "head");
+	}
 
-		NOTE:
-		 - this is not very precise, because you allocate more than you need in terms of
-		   glyf specific arrays, for example this implementation does not care about
-		   intruction etc. So allocation will always be too big, don't know how big the
-		   margin is going to be. You could go and parse all glyf num_points and sum
-		   them together, but that might be too time consuming
-	*/
+	TrueTypeFontReader maxp = ttf_reader(buffer, buffer_size, tables[1].offset,
+										 tables[1].length);
+	ttf_reader_skip(&maxp, U32_SIZE);		// version
+	u16 tmp_num_glyphs = ttf_read_u16(&maxp);
+
+	TrueTypeFontReader hhea = ttf_reader(buffer, buffer_size, tables[5].offset,
+										 tables[5].length);
+	ttf_reader_skip(&hhea, U32_SIZE);		// version
+	i16 ascent = (i16) ttf_read_u16(&hhea);
+	i16 descent = (i16) ttf_read_u16(&hhea);
+	ttf_reader_skip(&hhea, 13 * U16_SIZE);	// line gap up to the metric data format
+	u16 tmp_num_hmtx = ttf_read_u16(&hhea);
+	if (maxp.error || hhea.error || tmp_num_glyphs == 0 || tmp_num_hmtx == 0 ||
+		tmp_num_glyphs < tmp_num_hmtx) {
+		return ttf_load_invalid(buffer, font_path, "maxp or hhea");
+	}
 
-	u16 tmp_num_glyphs = ENDIAN_WORD(*((u16*) (buffer + tables[1].offset + U32_SIZE)));
-	u16 max_points = ENDIAN_WORD(*((u16*) (buffer + tables[1].offset + U32_SIZE + U16_SIZE)));
+	// the trailing lsbs may be cut short, missing ones are 0
+	if (tables[6].length < tmp_num_hmtx * sizeof(TrueTypeFontMetric)) {
+		return ttf_load_invalid(buffer, font_path, "hmtx");
+	}
+	u64 loca_stride = index_to_loc_format ? U32_SIZE : U16_SIZE;
+	if (tables[3].length < (tmp_num_glyphs + 1) * loca_stride) {
+		return ttf_load_invalid(buffer, font_path, "loca");
+	}
 
-	void* format4_ptr = NULL;
-	u16 seg_count;
+	TrueTypeFontReader cmap = ttf_reader(buffer, buffer_size, tables[2].offset,
+										 tables[2].length);
+	TrueTypeFontReader format4 = (TrueTypeFontReader) { 0 };	// data is NULL until found
+	TrueTypeFontReader format12 = (TrueTypeFontReader) { 0 };
 	{
-		u16 num_subtables = ENDIAN_WORD(*((u16*) (buffer + tables[2].offset + U16_SIZE)));
-		u64 cmap_offset = tables[2].offset + 2 * U16_SIZE;
-		u64 subtable_size = 2 * U16_SIZE + U32_SIZE;
-		for (u16 i = 0; i < num_subtables; i++) {
-			u16 platform_id = ENDIAN_WORD(
-					  *((u16*) (buffer + cmap_offset + subtable_size * i + 0)));
-			/*
-			u16 platform_specific_id = ENDIAN_WORD(
- 					   *((u16*) (buffer + cmap_offset + subtable_size * i + U16_SIZE)));
-		   */
-			u32 format_offset = ENDIAN_DWORD(
-					   *((u32*) (buffer + cmap_offset + subtable_size * i + 2 * U16_SIZE)));
-			u16 format = ENDIAN_WORD(*((u16*) (buffer + tables[2].offset + format_offset)));
+		ttf_reader_skip(&cmap, U16_SIZE);	// version
+		u16 num_subtables = ttf_read_u16(&cmap);
+		for (u16 i = 0; i < num_subtables && !cmap.error; i++) {
+			u16 platform_id = ttf_read_u16(&cmap);
+			u16 platform_specific_id = ttf_read_u16(&cmap);
+			u32 format_offset = ttf_read_u32(&cmap);
+			TrueTypeFontReader subtable = ttf_reader_at(&cmap, format_offset);
+			u16 format = ttf_read_u16(&subtable);
+			subtable.offset = 0;
+
+			if (cmap.error || subtable.error) { continue; }
+			if (platform_id != TTF_WIN_PLATFORM_ID && platform_id != TTF_UNICODE_PLATFORM_ID) {
+				continue;
+			}
 
-			if (platform_id == TTF_WIN_PLATFORM_ID && format == 4) {
-				format4_ptr = (void*) (buffer + tables[2].offset + format_offset);
-				seg_count = (u16) *((u16*) (format4_ptr + 3 * U16_SIZE));
-				seg_count = ENDIAN_WORD(seg_count);
-				seg_count /= 2;
+			if (format == 4) {
+				format4 = subtable;
+			} else if (format == 12 && (platform_id == TTF_UNICODE_PLATFORM_ID ||
+										platform_specific_id == TTF_WIN_UCS4_ID)) {
+				format12 = subtable;
 			}
 		}
 	}
 
-	if (format4_ptr == NULL) { return -1; }
+	if (format4.data == NULL && format12.data == NULL) {
+		return ttf_load_invalid(buffer, font_path, "cmap");
+	}
+
+	// format 12 covers every plane and is a superset of format 4 when both exist
+	TrueTypeFontReader cmap_subtable = (format12.data != NULL) ? format12 : format4;
+	TrueTypeFontCmapBuilder cmap_builder = (TrueTypeFontCmapBuilder) { 0 };
+	cmap_builder.num_glyphs = tmp_num_glyphs;
+	ttf_cmap_build(&cmap_builder, cmap_subtable);
+	u32 num_cmap_groups = cmap_builder.count;
+	u32 cmap_dense_size = 0;
+	if (num_cmap_groups != 0) {
+		cmap_dense_size = MIN((u64) cmap_builder.last.end_code + 1, TTF_CMAP_DENSE_SIZE);
+	}
+
+	TrueTypeFontReader kern = ttf_reader(buffer, buffer_size, kern_table.offset,
+										 kern_table.length);
+	u32 num_kern_pairs = ttf_kern_build(kern, NULL);
+
+	/*
+		Everything with a size known up front lives in one allocation:
+
+		size = sizeof(ttf) +
+			   sizeof(glyf) * num_glyphs +				// glyph headers
+			   sizeof(u32) * (num_glyphs + 1) +			// loca
+			   sizeof(metric) * num_hmtx +				// hmtx
+			   sizeof(u16) * (num_glyphs - num_hmtx) +	// trailing lsbs
+			   sizeof(u16) * num_glyphs +				// dense advances
+			   sizeof(cmap_group) * num_cmap_groups +	// code point ranges
+			   sizeof(u16) * cmap_dense_size +			// direct lookup for hot range
+			   sizeof(kern_pair) * num_kern_pairs +		// horizontal kerning
+			   sizeof(u32) * (num_glyphs + 1)			// kerning pairs per left glyph
+
+		NOTE:
+		 - every array is padded to 8 bytes, the u16 ones have odd lengths and
+		   would leave the u32 fields of the next misaligned
+		 - glyph outlines are not part of this block, they are decoded into
+		   'ttf->outlines' when a glyph is first needed (or all at once when
+		   TTF_LOAD_LAZY is not set), so memory is sized by actual point counts
+		   instead of num_glyphs * max_points
+	*/
 
-	// TODO: recalculate all of this, 50MB allocated, 2MB needed
 	u64 size = 0;
 	size += sizeof(TrueTypeFont);
-	size += U16_SIZE * seg_count * 4;
-	size += U32_SIZE * tmp_num_glyphs;
-	size += sizeof(TrueTypeFontGlyph) * tmp_num_glyphs;
-	size += U16_SIZE * 3 * tmp_num_glyphs * max_points;
-	size += tmp_num_glyphs * max_points;
+	size += TTF_ALIGN8(sizeof(TrueTypeFontGlyph) * tmp_num_glyphs);
+	size += TTF_ALIGN8(U32_SIZE * (tmp_num_glyphs + 1));
+	size += TTF_ALIGN8(sizeof(TrueTypeFontMetric) * tmp_num_hmtx);
+	size += TTF_ALIGN8(U16_SIZE * (tmp_num_glyphs - tmp_num_hmtx));
+	size += TTF_ALIGN8(U16_SIZE * tmp_num_glyphs);
+	size += TTF_ALIGN8(sizeof(TrueTypeFontCmapGroup) * num_cmap_groups);
+	size += TTF_ALIGN8(U16_SIZE * cmap_dense_size);
+	size += TTF_ALIGN8(sizeof(TrueTypeFontKernPair) * num_kern_pairs);
+	size += TTF_ALIGN8(U32_SIZE * (tmp_num_glyphs + 1));
 
 	TrueTypeFont* ttf = (TrueTypeFont*) malloc(size);
+	memset(ttf, 0, sizeof(TrueTypeFont));
 	*true_type_font = ttf;
 	u64 alloc_tail_offset = sizeof(TrueTypeFont);
 
-	i16 index_to_loc_format = -1;
-	// fill ttf with data
 	{
 		// head
-		u64 head_offset = tables[0].offset + 4 * U32_SIZE + U16_SIZE;
-		ttf->units_per_em = ENDIAN_WORD(*((u16*) (buffer + head_offset)));
-		head_offset += U16_SIZE + 2 * U64_SIZE;
-		ttf->x_min = ENDIAN_WORD(*((i16*) (buffer + head_offset)));
-		head_offset += U16_SIZE;
-		ttf->y_min = ENDIAN_WORD(*((i16*) (buffer + head_offset)));
-		head_offset += U16_SIZE;
-		ttf->x_max = ENDIAN_WORD(*((i16*) (buffer + head_offset)));
-		head_offset += U16_SIZE;
-		ttf->y_max = ENDIAN_WORD(*((i16*) (buffer + head_offset)));
-		head_offset += 2 * U16_SIZE;
-		ttf->lowest_rec_ppem = ENDIAN_WORD(*((u16*) (buffer + head_offset)));
-		head_offset += 2 * U16_SIZE;
-		index_to_loc_format = ENDIAN_WORD(*((i16*) (buffer + head_offset)));
-	}
-
-	if (index_to_loc_format == -1) { return -1; }
+		ttf->units_per_em = units_per_em;
+		ttf->x_min = x_min;
+		ttf->y_min = y_min;
+		ttf->x_max = x_max;
+		ttf->y_max = y_max;
+		ttf->lowest_rec_ppem = lowest_rec_ppem;
+	}
 
 	{
-		// hhea
-		u64 hhea_offset = tables[5].offset + U32_SIZE;
-		ttf->ascent = ENDIAN_WORD(*((i16*) (buffer + hhea_offset)));
-		hhea_offset += U16_SIZE;
-		ttf->descent = ENDIAN_WORD(*((i16*) (buffer + hhea_offset)));
-		hhea_offset += 14 * U16_SIZE;
-		ttf->num_hmtx = ENDIAN_WORD(*((u16*) (buffer + hhea_offset)));
+		// maxp
+		ttf->num_glyphs = tmp_num_glyphs;
 	}
 
 	{
-		// hmtx
-		u64 hmtx_offset = tables[6].offset;
-		ttf->hmtx = ((void*) ttf) + alloc_tail_offset;
-		memcpy(ttf->hmtx, buffer + hmtx_offset, ttf->num_hmtx * sizeof(TrueTypeFontMetric));
-		alloc_tail_offset += ttf->num_hmtx * sizeof(TrueTypeFontMetric);
-		hmtx_offset += ttf->num_hmtx * sizeof(TrueTypeFontMetric);
-		
-		ttf->num_lsb = tmp_num_glyphs - ttf->num_hmtx;
-		ttf->lsbs = NULL;
-		if (ttf->num_lsb != 0) {
-			ttf->lsbs = ((void*) ttf) + alloc_tail_offset;
-			memcpy(ttf->lsbs, buffer + hmtx_offset, ttf->num_lsb * U16_SIZE);
-			alloc_tail_offset += ttf->num_lsb * U16_SIZE;
-		}
+		// glyph headers, outlines are decoded later by ttf_glyph_load()
+		ttf->glyphs = (TrueTypeFontGlyph*) (((void*) ttf) + alloc_tail_offset);
+		alloc_tail_offset += TTF_ALIGN8(ttf->num_glyphs * sizeof(TrueTypeFontGlyph));
+		memset(ttf->glyphs, 0, ttf->num_glyphs * sizeof(TrueTypeFontGlyph));
+	}
 
-		for (u16 i = 0; i < ttf->num_hmtx; i++) {
-			ttf->hmtx[i].aw = ENDIAN_WORD(ttf->hmtx[i].aw);
-			ttf->hmtx[i].lsb = ENDIAN_WORD(ttf->hmtx[i].lsb);
-		}
+	{
+		// loca, has num_glyphs + 1 entries so the last glyph has an end offset too,
+		// offsets past the glyf table are pulled back to its end
+		const u8* loca = (const u8*) buffer + tables[3].offset;
+		ttf->loca = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8((ttf->num_glyphs + 1) * U32_SIZE);
 
-		for (u16 i = 0; i < ttf->num_lsb; i++) {
-			ttf->lsbs[i] = ENDIAN_WORD(ttf->lsbs[i]);
+		if (index_to_loc_format) {
+			ttf_swap32(ttf->loca, loca, ttf->num_glyphs + 1);
+		} else {
+			ttf_swap16_loca(ttf->loca, loca, ttf->num_glyphs + 1);
+		}
+		for (u32 i = 0; i <= ttf->num_glyphs; i++) {
+			ttf->loca[i] = MIN(ttf->loca[i], tables[4].length);
 		}
 	}
 
 	{
-		// maxp
-		ttf->num_glyphs = tmp_num_glyphs;
+		// cmap, the groups are sorted by code point so lookups can binary search
+		// them, the most common code points also get a direct table
+		ttf->num_cmap_groups = num_cmap_groups;
+		ttf->cmap_groups = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8(num_cmap_groups * sizeof(TrueTypeFontCmapGroup));
+		cmap_builder = (TrueTypeFontCmapBuilder) { 0 };
+		cmap_builder.num_glyphs = tmp_num_glyphs;
+		cmap_builder.groups = ttf->cmap_groups;
+		ttf_cmap_build(&cmap_builder, cmap_subtable);
 	}
 
 	{
-		// cmap
-		u16 length = ENDIAN_WORD(*((u16*) (format4_ptr + U16_SIZE)));
-		ttf->seg_count_2 = seg_count * 2;
-		u64 cmap_offset = 7 * U16_SIZE;
-
-		// end_code
-		ttf->end_code = ((void*) ttf) + alloc_tail_offset;
-		memcpy(ttf->end_code, format4_ptr + cmap_offset, seg_count * U16_SIZE);
-		alloc_tail_offset += seg_count * U16_SIZE;
-		cmap_offset += seg_count * U16_SIZE + U16_SIZE;
-
-		// start_code
-		ttf->start_code = ((void*) ttf) + alloc_tail_offset;
-		memcpy(ttf->start_code, format4_ptr + cmap_offset, seg_count * U16_SIZE);
-		alloc_tail_offset += seg_count * U16_SIZE;
-		cmap_offset += seg_count * U16_SIZE;
-
-		// id_delta
-		ttf->id_delta = ((void*) ttf) + alloc_tail_offset;
-		memcpy(ttf->id_delta, format4_ptr + cmap_offset, seg_count * U16_SIZE);
-		alloc_tail_offset += seg_count * U16_SIZE;
-		cmap_offset += seg_count * U16_SIZE;
+		// hhea
+		ttf->ascent = ascent;
+		ttf->descent = descent;
+		ttf->num_hmtx = tmp_num_hmtx;
+	}
 
-		// id_range_offset
-		u64 len = length - 3 * 2 * seg_count;
-		ttf->id_range_offset = ((void*) ttf) + alloc_tail_offset;
-		memcpy(ttf->id_range_offset, format4_ptr + cmap_offset, len);
-		alloc_tail_offset += len;
+	{
+		// hmtx, advance and lsb pairs are swapped as one array of words
+		TrueTypeFontReader hmtx = ttf_reader(buffer, buffer_size, tables[6].offset,
+											 tables[6].length);
+		ttf->hmtx = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8(ttf->num_hmtx * sizeof(TrueTypeFontMetric));
+		ttf_read_u16s(&hmtx, (u16*) ttf->hmtx, 2 * ttf->num_hmtx);
 
-		for (u16 i = 0; i < seg_count; i++) {
-			ttf->end_code[i] = ENDIAN_WORD(ttf->end_code[i]);
-			ttf->start_code[i] = ENDIAN_WORD(ttf->start_code[i]);
-			ttf->id_delta[i] = ENDIAN_WORD(ttf->id_delta[i]);
+		ttf->num_lsb = tmp_num_glyphs - ttf->num_hmtx;
+		ttf->lsbs = NULL;
+		if (ttf->num_lsb != 0) {
+			ttf->lsbs = ((void*) ttf) + alloc_tail_offset;
+			alloc_tail_offset += TTF_ALIGN8(ttf->num_lsb * U16_SIZE);
+			u32 num_lsb = MIN(ttf->num_lsb, (hmtx.size - hmtx.offset) / U16_SIZE);
+			ttf_read_u16s(&hmtx, (u16*) ttf->lsbs, num_lsb);
+			memset(ttf->lsbs + num_lsb, 0, (ttf->num_lsb - num_lsb) * U16_SIZE);
 		}
 
-		for (u64 i = 0; i < len / 2; i++) {
-			ttf->id_range_offset[i] = ENDIAN_WORD(ttf->id_range_offset[i]);
+		// glyphs past the last metric share its advance, measuring text only
+		// ever needs this array
+		ttf->advances = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8(ttf->num_glyphs * U16_SIZE);
+		for (u32 i = 0; i < ttf->num_glyphs; i++) {
+			ttf->advances[i] = ttf->hmtx[MIN(i, ttf->num_hmtx - 1u)].aw;
 		}
 	}
 
 	{
-		// loca
-		u64 loca_offset = tables[3].offset;
-		ttf->loca = ((void*) ttf) + alloc_tail_offset;
-		alloc_tail_offset += ttf->num_glyphs * U32_SIZE;
-
-		if (index_to_loc_format) {
-			for (u16 i = 0; i < ttf->num_glyphs; i++) {
-				u32* location = (u32*) (buffer + loca_offset + i * U32_SIZE);
-				ttf->loca[i] = ENDIAN_DWORD(*location);
+		// cmap, direct table
+		ttf->cmap_dense_size = cmap_dense_size;
+		ttf->cmap_dense = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8(cmap_dense_size * U16_SIZE);
+		memset(ttf->cmap_dense, 0, cmap_dense_size * U16_SIZE);
+
+		for (u32 i = 0; i < num_cmap_groups; i++) {
+			TrueTypeFontCmapGroup* group = ttf->cmap_groups + i;
+			if (cmap_dense_size <= group->start_code) { break; }
+			u32 end_code = MIN(group->end_code, cmap_dense_size - 1);
+			for (u32 c = group->start_code; c <= end_code; c++) {
+				ttf->cmap_dense[c] = (u16) (group->start_glyph + (c - group->start_code));
 			}
-		} else {
-			for (u16 i = 0; i < ttf->num_glyphs; i++) {
-				u16 tmp_location = *((u16*) (buffer + loca_offset + i * U16_SIZE));
-				tmp_location = ENDIAN_WORD(tmp_location);
-				ttf->loca[i] = (u32) tmp_location;
-				ttf->loca[i] = ttf->loca[i] << 1;
+		}
+	}
+
+	{
+		// kern, pairs of every usable subtable sorted so lookups can binary search,
+		// a pair listed twice adds up
+		ttf->kern_pairs = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8(num_kern_pairs * sizeof(TrueTypeFontKernPair));
+		ttf_kern_build(kern, ttf->kern_pairs);
+		qsort(ttf->kern_pairs, num_kern_pairs, sizeof(TrueTypeFontKernPair), ttf_u32_cmp);
+		u32 num_unique = 0;
+		for (u32 i = 0; i < num_kern_pairs; i++) {
+			TrueTypeFontKernPair* pair = ttf->kern_pairs + i;
+			if (num_unique != 0 && ttf->kern_pairs[num_unique - 1].glyphs == pair->glyphs) {
+				ttf->kern_pairs[num_unique - 1].value += pair->value;
+			} else {
+				ttf->kern_pairs[num_unique++] = *pair;
 			}
 		}
-		
+		ttf->num_kern_pairs = num_unique;
+
+		// lookups only search the pairs of their left glyph
+		ttf->kern_first = ((void*) ttf) + alloc_tail_offset;
+		alloc_tail_offset += TTF_ALIGN8((ttf->num_glyphs + 1) * U32_SIZE);
+		u32 pair = 0;
+		for (u32 i = 0; i <= ttf->num_glyphs; i++) {
+			while (pair < num_unique && (ttf->kern_pairs[pair].glyphs >> 16) < i) { pair++; }
+			ttf->kern_first[i] = pair;
+		}
 	}
 
+	assert(alloc_tail_offset == size);
+
 	{
 		// glyf
-		u64 glyf_offset = tables[4].offset;
-		ttf->glyphs = (TrueTypeFontGlyph*) (((void*) ttf) + alloc_tail_offset);
-		alloc_tail_offset += ttf->num_glyphs * sizeof(TrueTypeFontGlyph);
-		// memset everything to 0
-		memset(ttf->glyphs, 0, ttf->num_glyphs * sizeof(TrueTypeFontGlyph));
-
-		for (u16 i = 0; i < ttf->num_glyphs - 1; i++) {
-			u32 offset = ttf->loca[i];
-			u32 next_offset = ttf->loca[i + 1];
+		ttf->data = buffer;
+		ttf->data_size = buffer_size;
+		ttf->glyf_offset = tables[4].offset;
+
+		if (!(flags & TTF_LOAD_LAZY)) {
+			// simple glyphs know their point count from the last contour end, so
+			// the outline arrays can be sized once, compound glyphs grow them
+			u32 total_points = 0;
+			u32 total_contours = 0;
+			for (u32 i = 0; i < ttf->num_glyphs; i++) {
+				if (ttf->loca[i + 1] <= ttf->loca[i]) { continue; }
+				TrueTypeFontReader glyph = ttf_reader(buffer + ttf->glyf_offset,
+													  ttf->loca[i + 1], ttf->loca[i],
+													  ttf->loca[i + 1] - ttf->loca[i]);
+				i16 num_contours = (i16) ttf_read_u16(&glyph);
+				if (num_contours <= 0) { continue; }
+				ttf_reader_skip(&glyph, 4 * U16_SIZE + (num_contours - 1) * U16_SIZE);
+				u16 last_end_pt = ttf_read_u16(&glyph);
+				if (glyph.error) { continue; }
+				total_points += last_end_pt + 1;
+				total_contours += num_contours;
+			}
+			ttf_outlines_reserve(&ttf->outlines, total_points, total_contours);
 
-			if (offset - next_offset == 0) {
-				ttf->glyphs[i] = (TrueTypeFontGlyph) {
-					0, 0, 0, 0, 0, 0, NULL, 0, NULL, NULL, NULL
-				};
-				continue;
+			for (u32 i = 0; i < ttf->num_glyphs; i++) {
+				ttf_glyph_load(ttf, i);
 			}
-			
-			// load glyph
-			ttf_glyph_load(ttf, i, buffer + glyf_offset, &alloc_tail_offset);
+			ttf_outlines_shrink(&ttf->outlines);
+
+			// every outline is decoded, the font file is not needed anymore, lazy
+			// fonts hash it once an atlas cache asks
+			ttf->source_hash = ttf_hash(buffer, buffer_size);
+			file_free(ttf->data);
+			ttf->data = NULL;
+			ttf->data_size = 0;
 		}
 	}
 
-	assert(alloc_tail_offset < size);
-	file_free(buffer);
+	ttf_edge_cache_reset(ttf, TTF_EDGE_CACHE_SIZE);
+
 	return 1;
 }
 
+static int ttf_load_invalid(char* buffer, const char* font_path, const char* table)
+{
+	loge("[ttf] %s: missing or malformed %s\n", font_path, table);
+	file_free(buffer);
+	return -1;
+}
+
 void ttf_free(TrueTypeFont** true_type_font)
 {
 	TrueTypeFont* ttf = *true_type_font;
-	if (ttf) { free(ttf); }
+	if (ttf) {
+		ttf_edge_cache_reset(ttf, 0);
+		ttf_mesh_cache_reset(ttf);
+		if (ttf->mapping) {
+			// everything but the edge and mesh caches lives in the view
+			file_unmap(ttf->mapping);
+			return;
+		}
+		ttf_outlines_free(&ttf->outlines);
+		file_free(ttf->data);
+		free(ttf);
+	}
 }
 
-void ttf_glyph_load(TrueTypeFont* ttf, u32 glyph_index, void* buffer,
-					u64* ttf_buffer_tail_offset)
+int ttf_cache_save(TrueTypeFont* ttf, const char* font_path, const char* cache_path)
 {
-	u32 glyph_offset = ttf->loca[glyph_index];
-	TrueTypeFontGlyph* glyph = ttf->glyphs + glyph_index;
+	/*
+		A parsed font as it sits in memory, native endian, pointers stored as
+		offsets from the font:
 
-	if (glyph->parsed == 1) return;
+		header								// magic, version, source hash
+		TrueTypeFont
+		glyphs, loca, hmtx, lsbs, advances, cmap groups, cmap dense, kern pairs,
+		kern first
+		outline points x, y, on curve, contour ends
 
-	glyph->parsed = 1;
-	glyph->num_contours = ENDIAN_WORD(*((i16*) (buffer + glyph_offset)));
-	glyph_offset += U16_SIZE;
-	glyph->x_min = ENDIAN_WORD(*((i16*) (buffer + glyph_offset)));
-	glyph_offset += U16_SIZE;
-	glyph->y_min = ENDIAN_WORD(*((i16*) (buffer + glyph_offset)));
-	glyph_offset += U16_SIZE;
-	glyph->x_max = ENDIAN_WORD(*((i16*) (buffer + glyph_offset)));
-	glyph_offset += U16_SIZE;
-	glyph->y_max = ENDIAN_WORD(*((i16*) (buffer + glyph_offset)));
-	glyph_offset += U16_SIZE;
-
-	if (0 < glyph->num_contours) {
-		// simple glyph
-		glyph->end_pts_of_contours = ((void*) ttf) + *ttf_buffer_tail_offset;
-		memcpy(glyph->end_pts_of_contours, buffer + glyph_offset,
-			   glyph->num_contours * U16_SIZE);
-		glyph_offset += glyph->num_contours * U16_SIZE;
-		*ttf_buffer_tail_offset += glyph->num_contours * U16_SIZE;
-		
-		for (i16 i = 0; i < glyph->num_contours; i++) {
-			glyph->end_pts_of_contours[i] = ENDIAN_WORD(glyph->end_pts_of_contours[i]);
-		}
-
-		{
-			// skip intructions
-			u16 instruction_len = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-			glyph_offset += U16_SIZE;
-			glyph_offset += instruction_len;
-		}
-
-		glyph->num_points = glyph->end_pts_of_contours[glyph->num_contours - 1];
-		glyph->num_points++;
-
-		glyph->flags = ((void*) ttf) + *ttf_buffer_tail_offset;
-		*ttf_buffer_tail_offset += glyph->num_points;
-		u8* tmp_flags = (u8*) (buffer + glyph_offset);
-		u64 flags_len = 0;
-		u8 tmp_flag0, repeat_count;
-		for (u16 i = 0; i < glyph->num_points; i++) {
-			tmp_flag0 = *(tmp_flags + flags_len);
-			flags_len++;
-			glyph->flags[i] = tmp_flag0;
-			// if (tmp_flag0 & TTF_FLAG_REPEAT) {
-			if (tmp_flag0 & 0x08) {
-				repeat_count = *(tmp_flags + flags_len);
-				flags_len++;
-				for (u8 j = 0; j < repeat_count; j++) {
-					i++;
-					glyph->flags[i] = tmp_flag0;
-					// assert(i < glyph->num_points);
-				}
-			}
-		}
-		glyph_offset += flags_len;
+		NOTE:
+		 - every array starts 8 byte aligned
+		 - lazily loaded fonts get every glyph decoded first, a font loaded from
+		   the cache never needs the source file
+		 - 'font_path' has to be the file 'ttf' was loaded from, its hash is
+		   what ttf_cache_load() checks against
+	 */
+	assert(ttf != NULL);
 
-		glyph->pts_x = ((void*) ttf) + *ttf_buffer_tail_offset;
-		*ttf_buffer_tail_offset += glyph->num_points * U16_SIZE;
-		glyph->pts_y = ((void*) ttf) + *ttf_buffer_tail_offset;
-		*ttf_buffer_tail_offset += glyph->num_points * U16_SIZE;
+	u32 source_size;
+	void* source = file_map(font_path, &source_size);
+	if (source == NULL) { return 0; }
+	u64 source_hash = ttf_hash(source, source_size);
+	file_unmap(source);
 
-		i16 prev_pts = 0;
-		i16 tmp_pts = 0;
-		for (uint16_t i = 0; i < glyph->num_points; i++) {
-			if (glyph->flags[i] & 0x10) {
-				if (glyph->flags[i] & 0x02) {
-					tmp_pts = (int16_t) *((uint8_t*) (buffer + glyph_offset));
-					prev_pts += tmp_pts;
-					glyph_offset++;
-					glyph->pts_x[i] = prev_pts;
-				} else {
-					glyph->pts_x[i] = prev_pts;
-				}
-			} else {
-				if (glyph->flags[i] & 0x02) {
-					tmp_pts = (int16_t) *((uint8_t*) (buffer + glyph_offset));
-					prev_pts -= tmp_pts;
-					glyph_offset++;
-					glyph->pts_x[i] = prev_pts;
-				} else {
-					tmp_pts = *((int16_t*) (buffer + glyph_offset));
-					tmp_pts = ENDIAN_WORD(tmp_pts);
-					prev_pts += tmp_pts;
-					glyph_offset += 2;
-					glyph->pts_x[i] = prev_pts;
-				}
-			}
-		}
+	for (u32 i = 0; i < ttf->num_glyphs; i++) { ttf_glyph_get(ttf, i); }
+	TrueTypeFontOutlines* outlines = &ttf->outlines;
 
-		prev_pts = 0;
-		tmp_pts = 0;
-		for (uint16_t i = 0; i < glyph->num_points; i++) {
-			if (glyph->flags[i] & 0x20) {
-				if (glyph->flags[i] & 0x04) {
-					tmp_pts = (int16_t) *((uint8_t*) (buffer + glyph_offset));
-					prev_pts += tmp_pts;
-					glyph_offset++;
-					glyph->pts_y[i] = prev_pts;
-				}
-				else {
-					glyph->pts_y[i] = prev_pts;
-				}
-			}
-			else {
-				if (glyph->flags[i] & 0x04) {
-					tmp_pts = (int16_t) *((uint8_t*) (buffer + glyph_offset));
-					prev_pts -= tmp_pts;
-					glyph_offset++;
-					glyph->pts_y[i] = prev_pts;
-				}
-				else {
-					tmp_pts = *((int16_t*) (buffer + glyph_offset));
-					tmp_pts = ENDIAN_WORD(tmp_pts);
-					prev_pts += tmp_pts;
-					glyph_offset += 2;
-					glyph->pts_y[i] = prev_pts;
-				}
-			}
+	// the first pass only measures, the second copies behind the header
+	u64 size = 0;
+	void* image = NULL;
+	TrueTypeFont font;
+	for (u32 pass = 0; pass < 2; pass++) {
+		void* base = image ? image + sizeof(TrueTypeFontCacheHeader) : NULL;
+		u64 tail = sizeof(TrueTypeFont);
+		font = *ttf;
+		font.glyphs = ttf_cache_put(base, &tail, ttf->glyphs,
+									sizeof(TrueTypeFontGlyph) * ttf->num_glyphs);
+		font.loca = ttf_cache_put(base, &tail, ttf->loca, U32_SIZE * (ttf->num_glyphs + 1));
+		font.hmtx = ttf_cache_put(base, &tail, ttf->hmtx,
+								  sizeof(TrueTypeFontMetric) * ttf->num_hmtx);
+		font.lsbs = ttf_cache_put(base, &tail, ttf->lsbs, U16_SIZE * ttf->num_lsb);
+		font.advances = ttf_cache_put(base, &tail, ttf->advances, U16_SIZE * ttf->num_glyphs);
+		font.cmap_groups = ttf_cache_put(base, &tail, ttf->cmap_groups,
+										 sizeof(TrueTypeFontCmapGroup) * ttf->num_cmap_groups);
+		font.cmap_dense = ttf_cache_put(base, &tail, ttf->cmap_dense,
+										U16_SIZE * ttf->cmap_dense_size);
+		font.kern_pairs = ttf_cache_put(base, &tail, ttf->kern_pairs,
+										sizeof(TrueTypeFontKernPair) * ttf->num_kern_pairs);
+		font.kern_first = ttf_cache_put(base, &tail, ttf->kern_first,
+										U32_SIZE * (ttf->num_glyphs + 1));
+		font.outlines.pts_x = ttf_cache_put(base, &tail, outlines->pts_x,
+											U16_SIZE * outlines->num_points);
+		font.outlines.pts_y = ttf_cache_put(base, &tail, outlines->pts_y,
+											U16_SIZE * outlines->num_points);
+		font.outlines.on_curve = ttf_cache_put(base, &tail, outlines->on_curve,
+											   outlines->num_points);
+		font.outlines.end_pts = ttf_cache_put(base, &tail, outlines->end_pts,
+											  U16_SIZE * outlines->num_contours);
+		font.outlines.max_points = outlines->num_points;
+		font.outlines.max_contours = outlines->num_contours;
+		font.data = NULL;
+		font.data_size = 0;
+		font.mapping = NULL;
+		font.source_hash = source_hash;
+		font.edge_cache = (TrueTypeFontEdgeCache) { 0 };
+		font.meshes = NULL;
+
+		size = sizeof(TrueTypeFontCacheHeader) + tail;
+		if (image == NULL) {
+			if (0xffffffff < size) { return -1; }
+			image = calloc(1, size);
 		}
+	}
 
-		// set hmtx
-		ttf_glyph_get_hmtc(ttf, glyph, glyph_index);
-	} else if (glyph->num_contours < 0) {
-		// compound glyph
-
-		// TODO: fix stuff involving aw, lsb
-		u16 flags, tmp_glyph_index, x, y, f2dot14;
-		i16 total_num_contours = 0;
-		i16 total_num_points = 0;
-		i32 set_hmtc = 0;
-		Array glyphs;
-		arr_init(&glyphs, sizeof(TrueTypeFontGlyph*));
-
-		do {
-			flags = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-			glyph_offset += U16_SIZE;
-			
-			tmp_glyph_index = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-			glyph_offset += U16_SIZE;
-
-			// TODO: change the way new glyphs are loaded, because this function need a copy
-			// TODO: do a deep copy of the glyf
-			ttf_glyph_load(ttf, tmp_glyph_index, buffer, ttf_buffer_tail_offset);
-			TrueTypeFontGlyph* component = NULL;
-			ttf_glyph_create_deep_copy(ttf, tmp_glyph_index, &component);
-			arr_add(&glyphs, &component);
-			
-			total_num_contours += component->num_contours;
-			total_num_points += component->num_points;
-
-			if (flags & 0x0001) {
-				x = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				y = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-			} else {
-				x = (u16) *((u8*) (buffer + glyph_offset));
-				glyph_offset++;
-				y = (u16) *((u8*) (buffer + glyph_offset));
-				glyph_offset++;
-			}
-
-			if (flags & 0x0002) {
-				for (u16 i = 0; i < component->num_points; i++) {
-					component->pts_x[i] += x;
-					component->pts_y[i] += y;
-				}
-			}
-
-			if (flags & 0x0008) {
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				// deal with f2dot14
-				s32 scale = f2fot14_to_float_2(f2dot14);
-				for (u16 i = 0; i < component->num_points; i++) {
-					component->pts_x[i] = (i16) component->pts_y[i] * scale;
-					component->pts_y[i] = (i16) component->pts_y[i] * scale;
-				}
-			} else if (flags & 0x0040) {
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 x_scale = f2fot14_to_float_2(f2dot14);
-			
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 y_scale = f2fot14_to_float_2(f2dot14);
-
-				for (u16 i = 0; i < component->num_points; i++) {
-					component->pts_x[i] = (i16) component->pts_x[i] * x_scale;
-					component->pts_y[i] = (i16) component->pts_y[i] * y_scale;
-				}
-			} else if (flags & 0x0080) {
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 transform_x = f2fot14_to_float_2(f2dot14);
-
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 transform_01 = f2fot14_to_float_2(f2dot14);
-
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 transform_10 = f2fot14_to_float_2(f2dot14);
-
-				f2dot14 = ENDIAN_WORD(*((u16*) (buffer + glyph_offset)));
-				glyph_offset += U16_SIZE;
-				s32 transform_y = f2fot14_to_float_2(f2dot14);
-
-				for (u16 i = 0; i < component->num_points; i++) {
-					component->pts_x[i] = (i16) component->pts_x[i] * transform_x +
-						                  component->pts_y[i] * transform_01;
-					component->pts_y[i] = (i16) component->pts_y[i] * transform_y +
-						                  component->pts_x[i] * transform_10;
-				}
-			}
+	TrueTypeFontCacheHeader* header = image;
+	*header = (TrueTypeFontCacheHeader) {
+		TTF_CACHE_MAGIC, TTF_CACHE_VERSION, TTF_CACHE_BYTE_ORDER, sizeof(TrueTypeFont),
+		source_hash, source_size, size
+	};
+	memcpy(image + sizeof(TrueTypeFontCacheHeader), &font, sizeof(TrueTypeFont));
 
-			if (flags & 0x0200) {
-				set_hmtc = 1;
-				ttf_glyph_get_hmtc(ttf, glyph, glyph_index);
-			}
-		} while (flags & 0x0020);
-
-		// update num_contours
-		// update num_points
-		glyph->num_contours = total_num_contours;
-		glyph->end_pts_of_contours = (u16*) (((void*) ttf) + *ttf_buffer_tail_offset);
-		*ttf_buffer_tail_offset += glyph->num_contours * U16_SIZE;
-		
-		glyph->num_points = total_num_points;
-		glyph->flags = (u8*) (((void*) ttf) + *ttf_buffer_tail_offset);
-		*ttf_buffer_tail_offset += glyph->num_points;
-		glyph->pts_x = (i16*) (((void*) ttf) + *ttf_buffer_tail_offset);
-		*ttf_buffer_tail_offset += glyph->num_points * U16_SIZE;
-		glyph->pts_y = (i16*) (((void*) ttf) + *ttf_buffer_tail_offset);
-		*ttf_buffer_tail_offset += glyph->num_points * U16_SIZE;
-
-		i16 prev_num_contours = 0;
-		u16 prev_num_points = 0;
-		for (u32 i = 0; i < glyphs.size; i++) {
-			TrueTypeFontGlyph* component = *((TrueTypeFontGlyph**) arr_get(&glyphs, i));
-
-			for (i16 j = 0; j < component->num_contours; j++) {
-				component->end_pts_of_contours[j] += prev_num_points;
-			}
-			memcpy(glyph->end_pts_of_contours + prev_num_contours,
-				   component->end_pts_of_contours,
-				   component->num_contours * U16_SIZE);
-			
-			memcpy(glyph->flags + prev_num_points, component->flags, component->num_points);
-			memcpy(glyph->pts_x + prev_num_points, component->pts_x,
-				   component->num_points * U16_SIZE);
-			memcpy(glyph->pts_y + prev_num_points, component->pts_y,
-				   component->num_points * U16_SIZE);
-			prev_num_contours += component->num_contours;
-			prev_num_points += component->num_points;
-
-			free(component);
-		}
-		arr_free(&glyphs);
-
-		if (set_hmtc) return;
-		ttf_glyph_get_hmtc(ttf, glyph, glyph_index);
-	} else if (glyph->num_contours == 0) {
-		return;
-	}
+	i32 result = file_write(cache_path, image, size) ? 1 : -1;
+	free(image);
+	return result;
 }
 
-void ttf_glyph_get_hmtc(TrueTypeFont* ttf, TrueTypeFontGlyph* glyph, u32 glyph_index)
+int ttf_cache_load(TrueTypeFont** true_type_font, const char* font_path,
+				   const char* cache_path)
 {
-	if (glyph_index < ttf->num_hmtx) {
-		glyph->aw = ttf->hmtx[glyph_index].aw;
-		glyph->lsb = ttf->hmtx[glyph_index].lsb;
-		return;
+	/*
+		NOTE:
+		 - 1 returns a font that lives in the mapped cache file, 0 means either
+		   file is missing, -1 a cache that is stale or from another build, the
+		   caller falls back to ttf_load() and ttf_cache_save()
+		 - besides hashing the source the only work is relocating a dozen
+		   pointers, the view is copy on write so only that page becomes private
+		 - the font is used and freed like any other, ttf_free() unmaps it
+	 */
+	*true_type_font = NULL;
+
+	u32 cache_size;
+	void* view = file_map(cache_path, &cache_size);
+	if (view == NULL) { return 0; }
+
+	TrueTypeFontCacheHeader* header = view;
+	if (cache_size < sizeof(TrueTypeFontCacheHeader) + sizeof(TrueTypeFont) ||
+		header->magic != TTF_CACHE_MAGIC || header->version != TTF_CACHE_VERSION ||
+		header->byte_order != TTF_CACHE_BYTE_ORDER ||
+		header->font_size != sizeof(TrueTypeFont) || header->file_size != cache_size) {
+		logw("[ttf] %s is not a font cache of this build\n", cache_path);
+		file_unmap(view);
+		return -1;
 	}
-	glyph->aw = ttf->hmtx[ttf->num_hmtx - 1].aw;
-	glyph->lsb = ttf->lsbs[glyph_index - ttf->num_hmtx];
-}
-
-void ttf_glyph_create_deep_copy(TrueTypeFont* ttf, u32 src_index, TrueTypeFontGlyph** dst)
-{
-	TrueTypeFontGlyph* src_glyph = ttf->glyphs + src_index;
-	if (src_glyph->parsed != 1) { exit(0); }
-	
-	u64 size = sizeof(TrueTypeFontGlyph);
-	size += src_glyph->num_contours * U16_SIZE;
-	size += 2 * src_glyph->num_points * U16_SIZE + src_glyph->num_points;
-	// assert(size != 0);
 
-	(*dst) = (TrueTypeFontGlyph*) malloc(size);
+	u32 source_size;
+	void* source = file_map(font_path, &source_size);
+	if (source == NULL) { file_unmap(view); return 0; }
+	u64 source_hash = ttf_hash(source, source_size);
+	file_unmap(source);
 
-	if (src_glyph->num_contours == 0) { memset((*dst), 0, size); (*dst)->parsed = 1; return; }
-	
-	void* tmp_dst = (void*) (*dst);
-	u64 glyph_tail_offset = sizeof(TrueTypeFontGlyph);
+	if (header->source_size != source_size || header->source_hash != source_hash) {
+		logw("[ttf] %s is stale, %s changed\n", cache_path, font_path);
+		file_unmap(view);
+		return -1;
+	}
 
-	(*dst)->parsed = src_glyph->parsed;
-	(*dst)->num_contours = src_glyph->num_contours;
-	(*dst)->x_min = src_glyph->x_min;
-	(*dst)->y_min = src_glyph->y_min;
-	(*dst)->x_max = src_glyph->x_max;
-	(*dst)->y_max = src_glyph->y_max;
+	TrueTypeFont* ttf = view + sizeof(TrueTypeFontCacheHeader);
+	TrueTypeFontOutlines* outlines = &ttf->outlines;
+	u64 limit = cache_size - sizeof(TrueTypeFontCacheHeader);
+	bool valid = true;
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->glyphs,
+								sizeof(TrueTypeFontGlyph) * ttf->num_glyphs);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->loca,
+								U32_SIZE * (ttf->num_glyphs + 1));
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->hmtx,
+								sizeof(TrueTypeFontMetric) * ttf->num_hmtx);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->lsbs, U16_SIZE * ttf->num_lsb);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->advances,
+								U16_SIZE * ttf->num_glyphs);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->cmap_groups,
+								sizeof(TrueTypeFontCmapGroup) * ttf->num_cmap_groups);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->cmap_dense,
+								U16_SIZE * ttf->cmap_dense_size);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->kern_pairs,
+								sizeof(TrueTypeFontKernPair) * ttf->num_kern_pairs);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &ttf->kern_first,
+								U32_SIZE * (ttf->num_glyphs + 1));
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &outlines->pts_x,
+								U16_SIZE * outlines->num_points);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &outlines->pts_y,
+								U16_SIZE * outlines->num_points);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &outlines->on_curve,
+								outlines->num_points);
+	valid &= ttf_cache_relocate(ttf, limit, (void**) &outlines->end_pts,
+								U16_SIZE * outlines->num_contours);
+
+	// every glyph was decoded before saving, its outline has to lie within the saved
+	// arrays and its contours within its own points, like ttf_glyph_decode() leaves them
+	for (u32 i = 0; valid && i < ttf->num_glyphs; i++) {
+		TrueTypeFontGlyph* glyph = ttf->glyphs + i;
+		u32 num_contours = MAX(glyph->num_contours, 0);
+		valid &= glyph->parsed == 1 &&
+			glyph->x_min <= glyph->x_max && glyph->y_min <= glyph->y_max &&
+			(u64) glyph->first_point + glyph->num_points <= outlines->num_points &&
+			(u64) glyph->first_contour + num_contours <= outlines->num_contours;
+
+		const u16* end_pts = outlines->end_pts + glyph->first_contour;
+		for (u32 c = 0; valid && c < num_contours; c++) {
+			valid &= end_pts[c] < glyph->num_points && (c == 0 || end_pts[c - 1] < end_pts[c]);
+		}
+	}
+	if (!valid || ttf->data != NULL) {
+		logw("[ttf] %s is corrupt\n", cache_path);
+		file_unmap(view);
+		return -1;
+	}
 
-	(*dst)->end_pts_of_contours = (u16*) (tmp_dst + glyph_tail_offset);
-	glyph_tail_offset += src_glyph->num_contours * U16_SIZE;
-	memcpy((*dst)->end_pts_of_contours, src_glyph->end_pts_of_contours,
-		   src_glyph->num_contours * U16_SIZE);
+	ttf->mapping = view;
+	ttf->meshes = NULL;
+	ttf_edge_cache_reset(ttf, TTF_EDGE_CACHE_SIZE);
+	*true_type_font = ttf;
+	return 1;
+}
 
-	(*dst)->num_points = src_glyph->num_points;
+TrueTypeFontGlyph* ttf_glyph_get(TrueTypeFont* ttf, u32 glyph_index)
+{
+	assert(ttf != NULL);
+	if (ttf->num_glyphs <= glyph_index) { glyph_index = 0; }
 
-	(*dst)->flags = (u8*) (tmp_dst + glyph_tail_offset);
-	glyph_tail_offset += src_glyph->num_points;
-	memcpy((*dst)->flags, src_glyph->flags, src_glyph->num_points);
+	TrueTypeFontGlyph* glyph = ttf->glyphs + glyph_index;
+	if (glyph->parsed != 1) { ttf_glyph_load(ttf, glyph_index); }
+	return glyph;
+}
 
-	(*dst)->pts_x = (i16*) (tmp_dst + glyph_tail_offset);
-	glyph_tail_offset += src_glyph->num_points * U16_SIZE;
-	memcpy((*dst)->pts_x, src_glyph->pts_x, src_glyph->num_points * U16_SIZE);
+static void ttf_outlines_reserve(TrueTypeFontOutlines* outlines, u32 num_points,
+								 u32 num_contours)
+{
+	/*
+	  	NOTE:
+		 - glyphs only store offsets into the outline arrays, so growing them with
+		   realloc does not invalidate anything
+	 */
 
-	(*dst)->pts_y = (i16*) (tmp_dst + glyph_tail_offset);
-	glyph_tail_offset += src_glyph->num_points * U16_SIZE;
-	memcpy((*dst)->pts_y, src_glyph->pts_y, src_glyph->num_points * U16_SIZE);
+	if (outlines->max_points < outlines->num_points + num_points) {
+		u32 max_points = MAX(outlines->max_points * 2, outlines->num_points + num_points);
+		outlines->pts_x = (i16*) realloc(outlines->pts_x, max_points * U16_SIZE);
+		outlines->pts_y = (i16*) realloc(outlines->pts_y, max_points * U16_SIZE);
+		outlines->on_curve = (u8*) realloc(outlines->on_curve, max_points);
+		outlines->max_points = max_points;
+	}
 
-	(*dst)->aw = src_glyph->aw;
-	(*dst)->lsb = src_glyph->lsb;
+	if (outlines->max_contours < outlines->num_contours + num_contours) {
+		u32 max_contours = MAX(outlines->max_contours * 2,
+							   outlines->num_contours + num_contours);
+		outlines->end_pts = (u16*) realloc(outlines->end_pts, max_contours * U16_SIZE);
+		outlines->max_contours = max_contours;
+	}
 }
 
-i32 ttf_glyph_index_get(TrueTypeFont* ttf, u16 code_point)
+static void ttf_outlines_shrink(TrueTypeFontOutlines* outlines)
 {
-	assert(ttf != NULL);
-	
-	u16 seg_count = ttf->seg_count_2 / 2;
-	i32 index = -1;
-	u16* ptr;
-	for (u16 i = 0; i < seg_count; i++) {
-		if (code_point <= ttf->end_code[i]) { index = i; break; }
-	}
-	if (index == -1) { return 0; }	// ERROR, NO SUCH CODE POINT
-	if (ttf->start_code[index] < code_point) {
-		if (ttf->id_range_offset != 0) {
-			ptr = &ttf->id_range_offset[index] + ttf->id_range_offset[index] / 2;
-			ptr += (code_point - ttf->start_code[index]);
-			if (ptr == NULL) { return 0; }
-			return (*ptr + ttf->id_delta[index]) % 65536;
-		}
-		else {
-			return (code_point + ttf->id_delta[index]) % 65536;
-		}
+	if (outlines->num_points != 0 && outlines->num_points < outlines->max_points) {
+		outlines->pts_x = (i16*) realloc(outlines->pts_x, outlines->num_points * U16_SIZE);
+		outlines->pts_y = (i16*) realloc(outlines->pts_y, outlines->num_points * U16_SIZE);
+		outlines->on_curve = (u8*) realloc(outlines->on_curve, outlines->num_points);
+		outlines->max_points = outlines->num_points;
 	}
 
-	return 0;
+	if (outlines->num_contours != 0 && outlines->num_contours < outlines->max_contours) {
+		outlines->end_pts = (u16*) realloc(outlines->end_pts,
+										   outlines->num_contours * U16_SIZE);
+		outlines->max_contours = outlines->num_contours;
+	}
 }
 
-void* ttf_create_bitmap(TrueTypeFont* ttf, char c, u32 width, u32 height)
+static void ttf_outlines_free(TrueTypeFontOutlines* outlines)
 {
-	assert(ttf != NULL);
-	assert(width != 0 && height != 0);
-	
-	char* bmp = (char*) malloc(width * height);
-	memset(bmp, 0, width * height);
-
-	i32 glyph_index = ttf_glyph_index_get(ttf, c);
-	TrueTypeFontGlyph* glyph = ttf->glyphs + glyph_index;
-	i16 bbox = MAX(ttf->x_max - ttf->x_min, ttf->y_max - ttf->y_min);
-	// s32 scale = (float) height / (float) ttf->units_per_em;
-	s32 scale = (float) height / (float) bbox;
-	// s32 descent = scale * ttf->descent;
-	s32 descent = scale * ttf->x_min;
-	s32 lsb = (width / 2.0f) + 0.5f * scale * glyph->aw;
+	free(outlines->pts_x);
+	free(outlines->pts_y);
+	free(outlines->on_curve);
+	free(outlines->end_pts);
+	memset(outlines, 0, sizeof(TrueTypeFontOutlines));
+}
 
-	Array lines, points;
-	arr_init(&lines, sizeof(line2f));
-	arr_init(&points, sizeof(vec2f));
-	
-	s32 x0, y0, mx, my;
-	u32 min_y = height;
-	u32 max_y = 0;
-	u32 contour_counter = 0;
-	for (u16 i = 0; i < glyph->num_points; i++) {
-		x0 = width - (scale * glyph->pts_x[i]) + lsb;
-		y0 = height - (scale * glyph->pts_y[i]) + descent;
-		if (y0 < min_y) min_y = y0;
-		if (max_y < y0) max_y = y0;
-		vec2f tmp_point0 = { x0, y0 };
-		if (glyph->flags[i] &0x01) { arr_add(&points, &tmp_point0); }
-		else if (!(glyph->flags[i] & 0x01) && !(glyph->flags[i + 1] & 0x01)) {
-			mx = (glyph->pts_x[i] + glyph->pts_x[i + 1]) / 2;
-			my = (glyph->pts_y[i] + glyph->pts_y[i + 1]) / 2;
-			x0 = width - (scale * mx) + lsb;
-			y0 = height - (scale * my) + descent;
-			vec2f tmp_point1 = { x0, y0 };
-			arr_add(&points, &tmp_point1);
-		}
-
-		if (glyph->end_pts_of_contours[contour_counter] == i) {
-			contour_counter++;
-			for (u32 j = 0; j < points.size; j++) {
-				vec2f* point0 = (vec2f*) arr_get(&points, j);
-				vec2f* point1 = (vec2f*) arr_get(&points, j + 1);
-				line2f line = { *point0, *point1 };
-				/*
-				logd("[ttf] line : { %f, %f }, { %f, %f }\n",
-					 point0->x, point0->y, point1->x, point1->y);
-				*/
-				arr_add(&lines, &line);
-			}
-			arr_clean(&points);
-		}
-	}
-	arr_free(&points);
-
-	s32 dx, dy, intersection, smaller_y, bigger_y, m0, m1;
-	Array intersections;
-	arr_init(&intersections, sizeof(s32));
-	for (u32 i = min_y; i < max_y; i++) {
-		for (u32 j = 0; j < lines.size; j++) {
-			line2f* line = (line2f*) arr_get(&lines, j);
-			
-			smaller_y = MIN(line->p0.y, line->p1.y);
-			bigger_y = MAX(line->p0.y, line->p1.y);
-			if (i <= smaller_y) continue;
-			if (i > bigger_y) continue;
-
-			dx = line->p1.x - line->p0.x;
-			dy = line->p1.y - line->p0.y;
-			if (dy == 0) continue;
-
-			if (dx == 0) { intersection = line->p0.x; }
-			else { intersection = (i - line->p0.y) * (dx / dy) + line->p0.x; }
-			arr_add(&intersections, &intersection);
-		}
-
-		qsort(intersections.data, intersections.size, sizeof(s32), cmp_floats_callback);
-		for (u32 k = 0; k < intersections.size; k += 2) {
-			m0 = *((s32*) arr_get(&intersections, k));
-			m1 = *((s32*) arr_get(&intersections, k + 1));
-			for (u32 m = m0; m < m1; m++) {
-				bmp[m + i * width] = 0xff;
-			}
-		}
-		arr_clean(&intersections);
-	}
-	arr_free(&intersections);
-	arr_free(&lines);
-	
-	return bmp;
+void ttf_glyph_load(TrueTypeFont* ttf, u32 glyph_index)
+{
+	ttf_glyph_decode(ttf, glyph_index, 0);
 }
 
-void* ttf_create_font_atlas(TrueTypeFont* ttf, const char* characters, u32 point_size)
+static void ttf_glyph_decode(TrueTypeFont* ttf, u32 glyph_index, u32 depth)
 {
 	/*
-	  	USAGE:
-
-		// TODO
-		
+	  	NOTE:
+		 - ttf_load pulls loca back into the glyf table, every read below is
+		   checked against the glyph's own bytes
+		 - a glyph that does not decode is left empty, with its metrics
+		 - compound glyphs nest TTF_COMPOUND_MAX_DEPTH deep at most, a component
+		   that refers back to a glyph being decoded adds nothing
 	 */
-	
-	u32 width = 0;
-	u32 height = point_size;
+	TrueTypeFontGlyph* glyph = ttf->glyphs + glyph_index;
 
-	s32 scale = (s32) point_size / (s32) ttf->units_per_em;
-	s32 descent = scale * ttf->descent;
-	s32 x0, y0, mx, my;
-	u32 min_y = height;
-	u32 max_y = 0;
-	u32 contour_counter;
-	u32 total_aw = 0;
-
-	Array lines, points, p_glyphs;
-	arr_init(&lines, sizeof(line2f));
-	arr_init(&points, sizeof(vec2f));
-	arr_init(&p_glyphs, sizeof(TrueTypeFontGlyph*));
-	
-	for (u32 i = 0; i < strlen(characters); i++) {
-		TrueTypeFontGlyph* glyph = ttf->glyphs + ttf_glyph_index_get(ttf, characters[i]);
-		arr_add(&p_glyphs, &glyph);
-		width += glyph->aw;
+	if (glyph->parsed == 1) return;
+	assert(ttf->data != NULL);
+
+	glyph->parsed = 1;
+	ttf_glyph_get_hmtc(ttf, glyph, glyph_index);
+
+	u32 glyph_start = ttf->loca[glyph_index];
+	u32 glyph_end = ttf->loca[glyph_index + 1];
+	if (glyph_end <= glyph_start) {
+		// empty glyph, e.g. space, only has metrics
+		return;
+	}
+	TrueTypeFontReader reader = ttf_reader(ttf->data + ttf->glyf_offset, glyph_end,
+										   glyph_start, glyph_end - glyph_start);
+
+	i16 num_contours = (i16) ttf_read_u16(&reader);
+	glyph->x_min = (i16) ttf_read_u16(&reader);
+	glyph->y_min = (i16) ttf_read_u16(&reader);
+	glyph->x_max = (i16) ttf_read_u16(&reader);
+	glyph->y_max = (i16) ttf_read_u16(&reader);
+	if (reader.error || glyph->x_max < glyph->x_min || glyph->y_max < glyph->y_min) {
+		// cells are sized from the box, an inverted one would wrap around to
+		// gigabytes, the glyph is drawn as nothing and keeps its metrics
+		if (!reader.error) {
+			logw("[ttf] glyph %u has an inverted bounding box, it stays empty\n",
+				 glyph_index);
+		}
+		glyph->x_min = glyph->y_min = glyph->x_max = glyph->y_max = 0;
+		return;
 	}
-	width = width * scale;
 
-	for (u32 i = 0; i < p_glyphs.size; i++) {
-		contour_counter = 0;
-		TrueTypeFontGlyph* glyph = *((TrueTypeFontGlyph**) arr_get(&p_glyphs, i));
+	if (0 < num_contours) {
+		// simple glyph, the last contour end gives the point count, so the
+		// outline can be reserved at its exact size before anything is decoded
+		const u8* end_pts_data = ttf_read_bytes(&reader, num_contours * U16_SIZE);
+		if (end_pts_data == NULL) { return; }
+		u16 last_end_pt = ttf_be16(end_pts_data + (num_contours - 1) * U16_SIZE);
+		if (last_end_pt == 0xffff) { return; }
+		glyph->num_points = last_end_pt + 1;
+		glyph->num_contours = num_contours;
+
+		TrueTypeFontOutlines* outlines = &ttf->outlines;
+		ttf_outlines_reserve(outlines, glyph->num_points, glyph->num_contours);
+		glyph->first_point = outlines->num_points;
+		glyph->first_contour = outlines->num_contours;
+		outlines->num_points += glyph->num_points;
+		outlines->num_contours += glyph->num_contours;
+
+		u16* end_pts = outlines->end_pts + glyph->first_contour;
+		i16* pts_x = outlines->pts_x + glyph->first_point;
+		i16* pts_y = outlines->pts_y + glyph->first_point;
+		// holds the full flags while decoding, reduced to the on-curve bit at the end
+		u8* flags = outlines->on_curve + glyph->first_point;
+
+		// contours have at least one point each, the flattening walks from one
+		// end to the next
+		ttf_swap16(end_pts, end_pts_data, glyph->num_contours);
+		bool valid = true;
+		for (i16 i = 1; i < glyph->num_contours; i++) {
+			valid &= end_pts[i - 1] < end_pts[i];
+		}
+
+		// skip intructions
+		u16 instruction_len = ttf_read_u16(&reader);
+		ttf_reader_skip(&reader, instruction_len);
+
+		// runs of repeated flags are cut at the point count, the flags are read
+		// straight from the glyph's bytes with one end check per byte, the sizes
+		// of both coordinate arrays are summed up per run so they are checked once
+		// coordinate bytes by short flag | same flag << 1
+		static const u8 coord_sizes[4] = { 2, 1, 0, 1 };
+		const u8* flag_ptr = reader.data + reader.offset;
+		const u8* flag_end = reader.data + reader.size;
+		if (reader.error) { flag_ptr = flag_end; }
+		u32 num_flags = 0;
+		u32 x_size = 0;
+		u32 y_size = 0;
+		while (num_flags < glyph->num_points && flag_ptr < flag_end) {
+			u8 flag = *flag_ptr++;
+			u32 count = 1;
+			if ((flag & TTF_FLAG_REPEAT) && flag_ptr < flag_end) {
+				count += MIN((u32) *flag_ptr, glyph->num_points - num_flags - 1);
+				flag_ptr++;
+			}
+			for (u32 j = 0; j < count; j++) { flags[num_flags + j] = flag; }
+			num_flags += count;
+			x_size += count * coord_sizes[((flag >> 1) & 0x01) | ((flag >> 3) & 0x02)];
+			y_size += count * coord_sizes[((flag >> 2) & 0x01) | ((flag >> 4) & 0x02)];
+		}
+		ttf_reader_skip(&reader, flag_ptr - (reader.data + reader.offset));
+		valid &= num_flags == glyph->num_points;
+		const u8* ptr = ttf_read_bytes(&reader, (u64) x_size + y_size);
+
+		if (!valid || ptr == NULL) {
+			// nothing else was added to the outlines since the reserve
+			logw("[ttf] glyph %u is malformed, it stays empty\n", glyph_index);
+			outlines->num_points = glyph->first_point;
+			outlines->num_contours = glyph->first_contour;
+			glyph->num_points = 0;
+			glyph->num_contours = 0;
+			return;
+		}
+
+		// 0x02 / 0x04 one byte, its sign in 0x10 / 0x20, otherwise 0x10 / 0x20
+		// repeat the previous coordinate or a signed word follows
+		i16 value = 0;
+		for (u32 i = 0; i < glyph->num_points; i++) {
+			u8 flag = flags[i];
+			if (flag & 0x02) {
+				value += (flag & 0x10) ? (i16) *ptr : -(i16) *ptr;
+				ptr++;
+			} else if (!(flag & 0x10)) {
+				value += (i16) ttf_be16(ptr);
+				ptr += 2;
+			}
+			pts_x[i] = value;
+		}
+
+		value = 0;
+		for (u32 i = 0; i < glyph->num_points; i++) {
+			u8 flag = flags[i];
+			if (flag & 0x04) {
+				value += (flag & 0x20) ? (i16) *ptr : -(i16) *ptr;
+				ptr++;
+			} else if (!(flag & 0x20)) {
+				value += (i16) ttf_be16(ptr);
+				ptr += 2;
+			}
+			pts_y[i] = value;
+		}
 
 		for (u16 i = 0; i < glyph->num_points; i++) {
-			x0 = (width - total_aw) - (scale * glyph->pts_x[i]) + (scale * glyph->x_min);
-			y0 = height - (scale * glyph->pts_y[i]) + descent;
-			if (y0 < min_y) min_y = y0;
-			if (max_y < y0) max_y = y0;
-			vec2f tmp_point0 = { x0, y0 };
-			if (glyph->flags[i] &0x01) { arr_add(&points, &tmp_point0); }
-			else if (!(glyph->flags[i] & 0x01) && !(glyph->flags[i + 1] & 0x01)) {
-				mx = (glyph->pts_x[i] + glyph->pts_x[i + 1]) / 2;
-				my = (glyph->pts_y[i] + glyph->pts_y[i + 1]) / 2;
-				x0 = (width - total_aw) - (scale * mx) + (scale * glyph->x_min);
-				y0 = height - (scale * my) + descent;
-				vec2f tmp_point1 = { x0, y0 };
-				arr_add(&points, &tmp_point1);
-			}
-
-			if (glyph->end_pts_of_contours[contour_counter] == i) {
-				contour_counter++;
-				for (u32 j = 0; j < points.size; j++) {
-					vec2f* point0 = (vec2f*) arr_get(&points, j);
-					vec2f* point1 = (vec2f*) arr_get(&points, j + 1);
-					line2f line = { *point0, *point1 };
-					arr_add(&lines, &line);
+			flags[i] &= 0x01;
+		}
+	} else if (num_contours < 0) {
+		// compound glyph, the first pass resolves every component and sizes the
+		// glyph, the second transforms the component outlines straight into the
+		// glyph's range of the outline arrays, both stop at the same broken record
+		TrueTypeFontReader components = reader;
+		TrueTypeFontComponent component;
+		u32 total_num_points = 0;
+		u32 total_num_contours = 0;
+		glyph->num_contours = num_contours;
+		while (ttf_component_read(&reader, &component)) {
+			if (ttf->num_glyphs <= component.glyph_index ||
+				component.glyph_index == glyph_index) {
+				if (component.flags & TTF_COMPOUND_MORE) { continue; }
+				break;
+			}
+			if (depth < TTF_COMPOUND_MAX_DEPTH) {
+				ttf_glyph_decode(ttf, component.glyph_index, depth + 1);
+			}
+			TrueTypeFontGlyph* src = ttf->glyphs + component.glyph_index;
+			total_num_points += src->num_points;
+			total_num_contours += MAX(src->num_contours, 0);
+			if (component.flags & TTF_COMPOUND_MY_METRICS) {
+				ttf_glyph_get_hmtc(ttf, glyph, component.glyph_index);
+			}
+			if (!(component.flags & TTF_COMPOUND_MORE)) { break; }
+		}
+
+		glyph->num_points = 0;
+		glyph->num_contours = 0;
+		if (total_num_points == 0 || 0xffff < total_num_points ||
+			0x7fff < total_num_contours) {
+			return;
+		}
+
+		TrueTypeFontOutlines* outlines = &ttf->outlines;
+		ttf_outlines_reserve(outlines, total_num_points, total_num_contours);
+		glyph->first_point = outlines->num_points;
+		glyph->first_contour = outlines->num_contours;
+		outlines->num_points += total_num_points;
+		outlines->num_contours += total_num_contours;
+
+		i16* pts_x = outlines->pts_x + glyph->first_point;
+		i16* pts_y = outlines->pts_y + glyph->first_point;
+		u8* on_curve = outlines->on_curve + glyph->first_point;
+		u16* end_pts = outlines->end_pts + glyph->first_contour;
+		reader = components;
+		while (ttf_component_read(&reader, &component)) {
+			if (ttf->num_glyphs <= component.glyph_index ||
+				component.glyph_index == glyph_index) {
+				if (component.flags & TTF_COMPOUND_MORE) { continue; }
+				break;
+			}
+			TrueTypeFontGlyph* src = ttf->glyphs + component.glyph_index;
+			i16* src_x = outlines->pts_x + src->first_point;
+			i16* src_y = outlines->pts_y + src->first_point;
+			s32 a = component.transform[0];
+			s32 b = component.transform[1];
+			s32 c = component.transform[2];
+			s32 d = component.transform[3];
+
+			// the offset is a vector, or a point of the glyph so far that a point
+			// of the transformed component is moved onto
+			s32 dx = 0;
+			s32 dy = 0;
+			if (component.flags & TTF_COMPOUND_ARGS_XY) {
+				dx = component.args[0];
+				dy = component.args[1];
+				if ((component.flags & TTF_COMPOUND_SCALED_OFFSET) &&
+					!(component.flags & TTF_COMPOUND_UNSCALED_OFFSET)) {
+					s32 x = dx;
+					dx = a * x + c * dy;
+					dy = b * x + d * dy;
 				}
-				arr_clean(&points);
+			} else if ((u32) component.args[0] < glyph->num_points &&
+					   (u32) component.args[1] < src->num_points) {
+				u32 parent = component.args[0];
+				u32 child = component.args[1];
+				dx = pts_x[parent] - (a * src_x[child] + c * src_y[child]);
+				dy = pts_y[parent] - (b * src_x[child] + d * src_y[child]);
+			}
+
+			i16* dst_x = pts_x + glyph->num_points;
+			i16* dst_y = pts_y + glyph->num_points;
+			for (u16 i = 0; i < src->num_points; i++) {
+				s32 x = src_x[i];
+				s32 y = src_y[i];
+				dst_x[i] = (i16) floorf(a * x + c * y + dx + 0.5f);
+				dst_y[i] = (i16) floorf(b * x + d * y + dy + 0.5f);
+			}
+			memcpy(on_curve + glyph->num_points, outlines->on_curve + src->first_point,
+				   src->num_points);
+			for (i16 i = 0; i < src->num_contours; i++) {
+				end_pts[glyph->num_contours + i] =
+					outlines->end_pts[src->first_contour + i] + glyph->num_points;
+			}
+			glyph->num_points += src->num_points;
+			glyph->num_contours += MAX(src->num_contours, 0);
+			if (!(component.flags & TTF_COMPOUND_MORE)) { break; }
+		}
+	}
+}
+
+static void ttf_cmap_add_range(TrueTypeFontCmapBuilder* builder, u32 start_code,
+							   u32 end_code, u32 start_glyph)
+{
+	// glyph 0 is the missing glyph, it never needs to be stored, glyphs past
+	// the font's last one are cut off
+	if (start_glyph == 0) {
+		if (start_code == end_code) { return; }
+		start_code++;
+		start_glyph++;
+	}
+	if (end_code < start_code || builder->num_glyphs <= start_glyph) { return; }
+	end_code = MIN(end_code, (u64) start_code + (builder->num_glyphs - 1 - start_glyph));
+
+	TrueTypeFontCmapGroup* last = &builder->last;
+	if (builder->count != 0 && last->end_code + 1 == start_code &&
+		last->start_glyph + (start_code - last->start_code) == start_glyph) {
+		last->end_code = end_code;
+	} else {
+		builder->count++;
+		*last = (TrueTypeFontCmapGroup) { start_code, end_code, start_glyph };
+	}
+
+	if (builder->groups) { builder->groups[builder->count - 1] = *last; }
+}
+
+static u32 ttf_kern_build(TrueTypeFontReader table, TrueTypeFontKernPair* pairs)
+{
+	/*
+	  	NOTE:
+		 - only the windows layout (version 0) with format 0 subtables, and only
+		   horizontal, non cross stream, non minimum subtables
+		 - counts the pairs when pairs is NULL, fills them otherwise
+		 - subtable lengths are 16 bit and overflow for big tables, format 0 is
+		   walked by its pair count instead
+	 */
+	if (ttf_read_u16(&table) != 0) { return 0; }
+	u16 num_subtables = ttf_read_u16(&table);
+
+	u32 count = 0;
+	for (u16 i = 0; i < num_subtables && !table.error; i++) {
+		TrueTypeFontReader subtable = ttf_reader_at(&table, table.offset);
+		ttf_reader_skip(&subtable, U16_SIZE);	// version
+		u16 length = ttf_read_u16(&subtable);
+		u16 coverage = ttf_read_u16(&subtable);
+		if (subtable.error) { break; }
+		if ((coverage >> 8) != 0) {
+			// other formats keep their own length
+			if (length < 3 * U16_SIZE) { break; }
+			ttf_reader_skip(&table, length);
+			continue;
+		}
+
+		u16 num_pairs = ttf_read_u16(&subtable);
+		ttf_reader_skip(&subtable, 3 * U16_SIZE);	// binary search hints
+		if (subtable.error) { break; }
+		num_pairs = MIN(num_pairs, (subtable.size - subtable.offset) / (3 * U16_SIZE));
+		const u8* pair = ttf_read_bytes(&subtable, num_pairs * 3 * U16_SIZE);
+		// bit 0 horizontal, bit 1 minimum values, bit 2 cross stream
+		if ((coverage & 0x07) == 0x01) {
+			for (u16 j = 0; pairs != NULL && j < num_pairs; j++) {
+				const u8* values = pair + j * 3 * U16_SIZE;
+				pairs[count + j] = (TrueTypeFontKernPair) {
+					((u32) ttf_be16(values) << 16) | ttf_be16(values + U16_SIZE),
+					(i16) ttf_be16(values + 2 * U16_SIZE)
+				};
+			}
+			count += num_pairs;
+		}
+		ttf_reader_skip(&table, subtable.offset);
+	}
+	return count;
+}
+
+static void ttf_cmap_build(TrueTypeFontCmapBuilder* builder, TrueTypeFontReader subtable)
+{
+	/*
+	  	NOTE:
+		 - both formats are turned into sorted, non overlapping ranges of code
+		   points that map to consecutive glyphs, format 12 already is one,
+		   format 4 segments with an id_range_offset are split into runs
+		 - the subtable reaches to the end of the cmap table, groups and glyph
+		   ids past it are dropped
+	 */
+
+	u16 format = ttf_read_u16(&subtable);
+
+	if (format == 12) {
+		ttf_reader_skip(&subtable, U16_SIZE + 2 * U32_SIZE);	// reserved, length, language
+		u32 num_groups = ttf_read_u32(&subtable);
+		num_groups = MIN(num_groups, (subtable.size - subtable.offset) / (3 * U32_SIZE));
+		const u8* group = ttf_read_bytes(&subtable, num_groups * 3 * U32_SIZE);
+		for (u32 i = 0; group != NULL && i < num_groups; i++) {
+			ttf_cmap_add_range(builder, ttf_be32(group), ttf_be32(group + U32_SIZE),
+							   ttf_be32(group + 2 * U32_SIZE));
+			group += 3 * U32_SIZE;
+		}
+		return;
+	}
+
+	ttf_reader_skip(&subtable, 2 * U16_SIZE);	// length, language
+	u16 seg_count = ttf_read_u16(&subtable) / 2;
+	ttf_reader_skip(&subtable, 3 * U16_SIZE);	// binary search hints
+	const u8* end_code = ttf_read_bytes(&subtable, seg_count * U16_SIZE);
+	ttf_reader_skip(&subtable, U16_SIZE);		// reserved pad
+	const u8* start_code = ttf_read_bytes(&subtable, seg_count * U16_SIZE);
+	const u8* id_delta = ttf_read_bytes(&subtable, seg_count * U16_SIZE);
+	u32 id_range_offset_at = subtable.offset;
+	const u8* id_range_offset = ttf_read_bytes(&subtable, seg_count * U16_SIZE);
+	if (subtable.error) { return; }
+
+	for (u16 i = 0; i < seg_count; i++) {
+		u32 start = ttf_be16(start_code + i * U16_SIZE);
+		u32 end = ttf_be16(end_code + i * U16_SIZE);
+		u16 delta = ttf_be16(id_delta + i * U16_SIZE);
+		u16 range_offset = ttf_be16(id_range_offset + i * U16_SIZE);
+		if (start == 0xffff || end < start) { continue; }
+
+		if (range_offset == 0) {
+			// glyph = code + delta modulo 65536, split where that wraps around
+			u32 start_glyph = (start + delta) & 0xffff;
+			u32 wrap_code = start + (0xffff - start_glyph);
+			if (end <= wrap_code) {
+				ttf_cmap_add_range(builder, start, end, start_glyph);
+			} else {
+				ttf_cmap_add_range(builder, start, wrap_code, start_glyph);
+				ttf_cmap_add_range(builder, wrap_code + 1, end, 0);
 			}
+			continue;
+		}
+
+		// the glyph ids are range_offset bytes after the segment's own entry
+		u64 glyph_ids = id_range_offset_at + (u64) (i + range_offset / 2) * U16_SIZE;
+		for (u32 c = start; c <= end; c++) {
+			u64 at = glyph_ids + (u64) (c - start) * U16_SIZE;
+			if (subtable.size < at + U16_SIZE) { break; }
+			u16 glyph = ttf_be16(subtable.data + at);
+			if (glyph != 0) { glyph = (glyph + delta) & 0xffff; }
+			ttf_cmap_add_range(builder, c, c, glyph);
+		}
+	}
+}
+
+static bool ttf_component_read(TrueTypeFontReader* reader, TrueTypeFontComponent* component)
+{
+	// one component record of a compound glyph, false once the glyph's data ends
+	u16 flags = ttf_read_u16(reader);
+	component->flags = flags;
+	component->glyph_index = ttf_read_u16(reader);
+
+	// offsets are signed, matched point numbers are not
+	if (flags & TTF_COMPOUND_ARG_WORDS) {
+		u16 arg0 = ttf_read_u16(reader);
+		u16 arg1 = ttf_read_u16(reader);
+		component->args[0] = (flags & TTF_COMPOUND_ARGS_XY) ? (i16) arg0 : arg0;
+		component->args[1] = (flags & TTF_COMPOUND_ARGS_XY) ? (i16) arg1 : arg1;
+	} else {
+		u8 arg0 = ttf_read_u8(reader);
+		u8 arg1 = ttf_read_u8(reader);
+		component->args[0] = (flags & TTF_COMPOUND_ARGS_XY) ? (i8) arg0 : arg0;
+		component->args[1] = (flags & TTF_COMPOUND_ARGS_XY) ? (i8) arg1 : arg1;
+	}
+
+	s32* transform = component->transform;
+	transform[0] = 1.0f;
+	transform[1] = 0.0f;
+	transform[2] = 0.0f;
+	transform[3] = 1.0f;
+	if (flags & TTF_COMPOUND_SCALE) {
+		transform[0] = f2fot14_to_float_2(ttf_read_u16(reader));
+		transform[3] = transform[0];
+	} else if (flags & TTF_COMPOUND_XY_SCALE) {
+		transform[0] = f2fot14_to_float_2(ttf_read_u16(reader));
+		transform[3] = f2fot14_to_float_2(ttf_read_u16(reader));
+	} else if (flags & TTF_COMPOUND_2X2) {
+		for (u32 i = 0; i < 4; i++) {
+			transform[i] = f2fot14_to_float_2(ttf_read_u16(reader));
+		}
+	}
+	return !reader->error;
+}
+
+void ttf_glyph_get_hmtc(TrueTypeFont* ttf, TrueTypeFontGlyph* glyph, u32 glyph_index)
+{
+	if (glyph_index < ttf->num_hmtx) {
+		glyph->aw = ttf->hmtx[glyph_index].aw;
+		glyph->lsb = ttf->hmtx[glyph_index].lsb;
+		return;
+	}
+	glyph->aw = ttf->hmtx[ttf->num_hmtx - 1].aw;
+	glyph->lsb = ttf->lsbs[glyph_index - ttf->num_hmtx];
+}
+
+i32 ttf_glyph_index_get(TrueTypeFont* ttf, u32 code_point)
+{
+	assert(ttf != NULL);
+
+	if (code_point < ttf->cmap_dense_size) { return ttf->cmap_dense[code_point]; }
+
+	// first group that ends at or after code_point
+	u32 low = 0;
+	u32 high = ttf->num_cmap_groups;
+	while (low < high) {
+		u32 mid = (low + high) / 2;
+		if (ttf->cmap_groups[mid].end_code < code_point) { low = mid + 1; }
+		else { high = mid; }
+	}
+
+	if (low == ttf->num_cmap_groups) { return 0; }	// ERROR, NO SUCH CODE POINT
+	TrueTypeFontCmapGroup* group = ttf->cmap_groups + low;
+	if (code_point < group->start_code) { return 0; }
+	return group->start_glyph + (code_point - group->start_code);
+}
+
+u32 ttf_glyph_indices_utf8(TrueTypeFont* ttf, const char* text, u32 length,
+						   u32* glyph_indices)
+{
+	assert(ttf != NULL);
+
+	/*
+	  	USAGE:
+
+		glyph_indices has to hold at least 'length' entries, returns the number of
+		code points decoded, malformed sequences map to U+FFFD
+	 */
+
+	const u8* ptr = (const u8*) text;
+	const u8* end = ptr + length;
+	u32 count = 0;
+	while (ptr < end) {
+		u32 c = *ptr;
+		if (c < 0x80) {
+			ptr++;
+			glyph_indices[count++] = c < ttf->cmap_dense_size ?
+				ttf->cmap_dense[c] : (u32) ttf_glyph_index_get(ttf, c);
+			continue;
+		}
+
+		glyph_indices[count++] = ttf_glyph_index_get(ttf, ttf_utf8_next(&ptr, end));
+	}
+
+	return count;
+}
+
+static u32 ttf_utf8_next(const u8** text, const u8* end)
+{
+	// decodes one code point and advances text past it, malformed input is U+FFFD
+	const u8* ptr = *text;
+	u32 c = *ptr++;
+	if (0x80 <= c) {
+		u32 extra;
+		if ((c & 0xe0) == 0xc0) { extra = 1; c &= 0x1f; }
+		else if ((c & 0xf0) == 0xe0) { extra = 2; c &= 0x0f; }
+		else if ((c & 0xf8) == 0xf0) { extra = 3; c &= 0x07; }
+		else { extra = 0; c = 0xfffd; }
+
+		for (u32 i = 0; i < extra; i++) {
+			if (end <= ptr || (*ptr & 0xc0) != 0x80) { c = 0xfffd; break; }
+			c = (c << 6) | (*ptr & 0x3f);
+			ptr++;
+		}
+
+		// overlong forms, utf-16 surrogates and anything past U+10FFFF are malformed
+		static const u32 smallest[4] = { 0, 0x80, 0x800, 0x10000 };
+		if (c < smallest[extra] || (0xd800 <= c && c <= 0xdfff) || 0x10ffff < c) {
+			c = 0xfffd;
 		}
-		arr_clean(&points);
-		total_aw += scale * glyph->aw;
 	}
-	arr_free(&p_glyphs);
-	arr_free(&points);
 
-	// width = width * scale;
+	*text = ptr;
+	return c;
+}
+
+void ttf_glyph_indices_utf32(TrueTypeFont* ttf, const u32* text, u32 length,
+							 u32* glyph_indices)
+{
+	assert(ttf != NULL);
+
+	for (u32 i = 0; i < length; i++) {
+		glyph_indices[i] = ttf_glyph_index_get(ttf, text[i]);
+	}
+}
+
+void* ttf_create_bitmap(TrueTypeFont* ttf, char c, u32 width, u32 height,
+						TrueTypeFontRasterFlags flags)
+{
+	assert(ttf != NULL);
+	assert(width != 0 && height != 0);
+	
 	char* bmp = (char*) malloc(width * height);
 
-	s32 dx, dy, intersection, smaller_y, bigger_y, m0, m1;
-	Array intersections;
-	arr_init(&intersections, sizeof(s32));
-	for (u32 i = min_y; i < max_y; i++) {
-		for (u32 j = 0; j < lines.size; j++) {
-			line2f* line = (line2f*) arr_get(&lines, j);
-			
-			smaller_y = MIN(line->p0.y, line->p1.y);
-			bigger_y = MAX(line->p0.y, line->p1.y);
-			if (i <= smaller_y) continue;
-			if (i > bigger_y) continue;
+	i32 glyph_index = ttf_glyph_index_get(ttf, (u8) c);
+	TrueTypeFontGlyph* glyph = ttf_glyph_get(ttf, glyph_index);
+	i16 bbox = MAX(ttf->x_max - ttf->x_min, ttf->y_max - ttf->y_min);
+	// s32 scale = (float) height / (float) ttf->units_per_em;
+	s32 scale = (float) height / (float) bbox;
+	// s32 descent = scale * ttf->descent;
+	s32 descent = scale * ttf->x_min;
+	// outlines are mirrored in x, this centres the advance on the bitmap
+	s32 lsb = (width / 2.0f) + 0.5f * scale * glyph->aw;
+
+	// lines and fill temporaries share one scratch block, there is no sdf here
+	flags &= ~TTF_RASTER_SDF;
+	TrueTypeFontEdgeList* edges = ttf_glyph_edges_get(ttf, glyph_index, scale);
+	u64 lines_size = edges->num_lines * sizeof(line2f) + 16;
+	u64 scratch_size = lines_size + ttf_fill_scratch_size(edges->num_lines, width, height,
+														  flags);
+	void* memory = malloc(scratch_size);
+	TrueTypeFontArena scratch;
+	ttf_arena_init(&scratch, memory, scratch_size);
+	line2f* lines = (line2f*) ttf_arena_push(&scratch, lines_size - 16);
+	u32 num_lines = ttf_glyph_lines(edges, scale, lsb, height + descent, true, lines);
+
+	ttf_fill_lines(lines, num_lines, (u8*) bmp, width, width, 0, 0, width, height, flags,
+				   0.0f, &scratch);
+	free(memory);
+	
+	return bmp;
+}
+
+int ttf_create_font_atlas(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info,
+						  TrueTypeFontAtlas* atlas)
+{
+	/*
+	  	USAGE:
+
+		TrueTypeFontAtlasCreateInfo info = {
+			.characters = "abc...",
+			.point_size = 32,
+			.padding = 1,
+			.flags = TTF_RASTER_AA,
+			.thread_count = 4
+		};
+		TrueTypeFontAtlas atlas;
+		if (ttf_create_font_atlas(ttf, &info, &atlas) == 1) {
+			TrueTypeFontAtlasGlyph* glyph = ttf_font_atlas_glyph_get(&atlas, 'a');
+			...
+			ttf_font_atlas_free(&atlas);
+		}
+
+	  	NOTE:
+		 - glyphs are skyline packed, tallest first, into the smallest power of two
+		   texture they fit, starting near square, returns 0 if that exceeds max_size
+		 - outlines are decoded, flattened and placed on the calling thread, the
+		   font and its caches are never touched by the workers
+		 - cells do not overlap, workers rasterize them straight into the atlas
+		   with one scratch block each and the result does not depend on thread_count
+	 */
+	assert(info != NULL);
+	return ttf_create_font_atlases(ttf, info, 1, &info->point_size, atlas);
+}
+
+int ttf_create_font_atlases(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info, u32 count,
+							const u32* point_sizes, TrueTypeFontAtlas* atlases)
+{
+	/*
+	  	USAGE:
+
+		u32 sizes[] = { 16, 24, 32, 48, 64 };
+		TrueTypeFontAtlas atlases[5];
+		if (ttf_create_font_atlases(ttf, &info, 5, sizes, atlases) == 1) {
+			...
+			for (u32 i = 0; i < 5; i++) { ttf_font_atlas_free(atlases + i); }
+		}
+
+	  	NOTE:
+		 - info->point_size is ignored, atlases[i] is byte for byte the atlas
+		   ttf_create_font_atlas builds at point_sizes[i]
+		 - the characters are decoded and looked up once, every glyph is flattened
+		   once per edge cache bucket the sizes fall in and only scaled per size
+		 - the cells of every atlas go to one set of workers
+		 - returns 0 and leaves every atlas empty if one does not fit max_size
+		 - with info->cache_dir every atlas is first looked for there, keyed by the
+		   font file's hash, its point size, the character set, everything else in
+		   info but thread_count and TTF_ATLAS_CACHE_VERSION, a hit maps the file
+		   and the atlas lives in the view, only misses are rasterized and saved
+	 */
+	assert(ttf != NULL);
+	assert(info != NULL && info->characters != NULL);
+	assert(point_sizes != NULL && atlases != NULL);
+
+	u32* code_points;
+	u32 num_glyphs = ttf_atlas_code_points(info->characters, &code_points);
+	// a font that has neither its file nor the file's hash can not be keyed
+	if (info->cache_dir == NULL || (ttf->source_hash == 0 && ttf->data == NULL)) {
+		i32 result = ttf_atlases_rasterize(ttf, info, count, point_sizes, code_points,
+										   num_glyphs, atlases);
+		free(code_points);
+		return result;
+	}
+
+	if (ttf->source_hash == 0) { ttf->source_hash = ttf_hash(ttf->data, ttf->data_size); }
+	TrueTypeFontAtlasCacheKey* keys = (TrueTypeFontAtlasCacheKey*)
+		calloc(MAX(count, 1), sizeof(TrueTypeFontAtlasCacheKey));
+	u32* misses = (u32*) malloc(MAX(count, 1) * U32_SIZE);
+	u32* miss_sizes = (u32*) malloc(MAX(count, 1) * U32_SIZE);
+	u32 num_misses = 0;
+	u64 charset_hash = ttf_hash(code_points, num_glyphs * U32_SIZE);
+	for (u32 a = 0; a < count; a++) {
+		TrueTypeFontAtlasCacheKey* key = keys + a;
+		key->version = TTF_ATLAS_CACHE_VERSION;
+		key->byte_order = TTF_CACHE_BYTE_ORDER;
+		key->source_hash = ttf->source_hash;
+		key->charset_hash = charset_hash;
+		key->num_code_points = num_glyphs;
+		key->point_size = point_sizes[a];
+		key->padding = info->padding;
+		key->max_size = (info->max_size != 0) ? info->max_size : TTF_ATLAS_MAX_SIZE;
+		key->sdf_spread = (info->flags & TTF_RASTER_SDF) ? info->sdf_spread : 0;
+		key->flags = info->flags;
+		if (!ttf_atlas_cache_load(info->cache_dir, key, atlases + a)) {
+			misses[num_misses] = a;
+			miss_sizes[num_misses++] = point_sizes[a];
+		}
+	}
+
+	i32 result = 1;
+	if (num_misses != 0) {
+		TrueTypeFontAtlas* built = (TrueTypeFontAtlas*)
+			malloc(num_misses * sizeof(TrueTypeFontAtlas));
+		result = ttf_atlases_rasterize(ttf, info, num_misses, miss_sizes, code_points,
+									   num_glyphs, built);
+		for (u32 i = 0; i < num_misses && result == 1; i++) {
+			atlases[misses[i]] = built[i];
+			ttf_atlas_cache_save(info->cache_dir, keys + misses[i], built + i);
+		}
+		if (result != 1) {
+			for (u32 a = 0; a < count; a++) { ttf_font_atlas_free(atlases + a); }
+		}
+		free(built);
+	}
+	free(miss_sizes);
+	free(misses);
+	free(keys);
+	free(code_points);
+	return result;
+}
+
+static int ttf_atlases_rasterize(TrueTypeFont* ttf, TrueTypeFontAtlasCreateInfo* info,
+								 u32 count, const u32* point_sizes, const u32* code_points,
+								 u32 num_glyphs, TrueTypeFontAtlas* atlases)
+{
+	// ttf_create_font_atlases() without the cache, code points are unique and sorted
+	u32 max_size = (info->max_size != 0) ? info->max_size : TTF_ATLAS_MAX_SIZE;
+	for (u32 a = 0; a < count; a++) { atlases[a] = (TrueTypeFontAtlas) { 0 }; }
+
+	u32* glyph_indices = (u32*) malloc(MAX(num_glyphs, 1) * U32_SIZE);
+	for (u32 i = 0; i < num_glyphs; i++) {
+		glyph_indices[i] = ttf_glyph_index_get(ttf, code_points[i]);
+	}
+
+	// sizes flattened for the same bucket share their font unit lines
+	u32* size_buckets = (u32*) malloc(MAX(count, 1) * U32_SIZE);
+	s32* bucket_scales = (s32*) malloc(MAX(count, 1) * sizeof(s32));
+	u32 num_buckets = 0;
+	for (u32 a = 0; a < count; a++) {
+		s32 scale = (s32) point_sizes[a] / (s32) ttf->units_per_em;
+		u32 b = 0;
+		while (b < num_buckets &&
+			   ttf_edge_bucket(ttf, bucket_scales[b]) != ttf_edge_bucket(ttf, scale)) {
+			b++;
+		}
+		if (b == num_buckets) { bucket_scales[num_buckets++] = scale; }
+		size_buckets[a] = b;
+	}
+	Array outlines;
+	arr_init(&outlines, sizeof(line2f));
+	u32* spans = (u32*) malloc(MAX(num_glyphs * num_buckets, 1) * 2 * U32_SIZE);
+	for (u32 i = 0; i < num_glyphs; i++) {
+		for (u32 b = 0; b < num_buckets; b++) {
+			TrueTypeFontEdgeList* edges = ttf_glyph_edges_get(ttf, glyph_indices[i],
+															  bucket_scales[b]);
+			u32* span = spans + 2 * (i * num_buckets + b);
+			span[0] = outlines.size;
+			span[1] = edges->num_lines;
+			for (u32 l = 0; l < edges->num_lines; l++) { arr_add(&outlines, edges->lines + l); }
+		}
+	}
 
-			dx = line->p1.x - line->p0.x;
-			dy = line->p1.y - line->p0.y;
-			if (dy == 0) continue;
+	TrueTypeFontAtlasCell* cells = (TrueTypeFontAtlasCell*)
+		calloc(MAX(count * num_glyphs, 1), sizeof(TrueTypeFontAtlasCell));
+	u64* order = (u64*) malloc(MAX(num_glyphs, 1) * U64_SIZE);
+	TrueTypeFontSkylineNode* nodes = (TrueTypeFontSkylineNode*)
+		malloc((num_glyphs + 1) * sizeof(TrueTypeFontSkylineNode));
+	Array lines;
+	arr_init(&lines, sizeof(line2f));
 
-			if (dx == 0) { intersection = line->p0.x; }
-			else { intersection = (i - line->p0.y) * (dx / dy) + line->p0.x; }
-			arr_add(&intersections, &intersection);
+	bool fits = true;
+	for (u32 a = 0; a < count && fits; a++) {
+		TrueTypeFontAtlas* atlas = atlases + a;
+		TrueTypeFontAtlasCell* atlas_cells = cells + a * num_glyphs;
+		atlas->scale = (s32) point_sizes[a] / (s32) ttf->units_per_em;
+		atlas->ascent = atlas->scale * ttf->ascent;
+		atlas->descent = atlas->scale * ttf->descent;
+		s32 scale = atlas->scale;
+		u32 padding = info->padding;
+		if (info->flags & TTF_RASTER_SDF) {
+			// the field has to fade out inside the cell
+			atlas->sdf_spread = (info->sdf_spread != 0) ?
+				info->sdf_spread : point_sizes[a] / 8.0f;
+			padding = MAX(padding, (u32) ceilf(atlas->sdf_spread));
 		}
 
-		qsort(intersections.data, intersections.size, sizeof(s32), cmp_floats_callback);
-		for (u32 k = 0; k < intersections.size; k += 2) {
-			m0 = *((s32*) arr_get(&intersections, k));
-			m1 = *((s32*) arr_get(&intersections, k + 1));
-			for (u32 m = m0; m < m1; m++) {
-				bmp[m + i * width] = 0xff;
+		atlas->num_glyphs = num_glyphs;
+		atlas->glyphs = (TrueTypeFontAtlasGlyph*)
+			calloc(MAX(num_glyphs, 1), sizeof(TrueTypeFontAtlasGlyph));
+		u64 area = 0;
+		for (u32 i = 0; i < num_glyphs; i++) {
+			TrueTypeFontAtlasGlyph* entry = atlas->glyphs + i;
+			TrueTypeFontAtlasCell* cell = atlas_cells + i;
+			entry->code_point = code_points[i];
+			entry->glyph_index = glyph_indices[i];
+			cell->atlas = a;
+			ttf_glyph_cell_measure(ttf, entry, scale, padding, cell);
+			if (cell->width != 0) {
+				// lines with the cell's top left corner at the origin
+				u32* span = spans + 2 * (i * num_buckets + size_buckets[a]);
+				TrueTypeFontEdgeList edges = (TrueTypeFontEdgeList) {
+					entry->glyph_index, size_buckets[a], span[1],
+					(line2f*) outlines.data + span[0]
+				};
+				cell->first_line = lines.size;
+				for (u32 l = 0; l < edges.num_lines; l++) { arr_push(&lines); }
+				cell->num_lines = ttf_glyph_lines(&edges, scale, -entry->bearing_x,
+												  entry->bearing_y, false,
+												  (line2f*) lines.data + cell->first_line);
 			}
+			area += cell->width * cell->height;
+
+			// tallest first, then widest, ties keep code point order
+			order[i] = ((u64) (0xfffff - MIN(cell->height, 0xfffff)) << 40) |
+				((u64) (0xfffff - MIN(cell->width, 0xfffff)) << 20) | i;
+		}
+		qsort(order, num_glyphs, U64_SIZE, ttf_u64_cmp);
+
+		u32 width = 1;
+		while ((u64) width * width < area) { width *= 2; }
+		u32 height = MAX(width / 2, 1);
+		while (!ttf_skyline_pack(atlas_cells, order, num_glyphs, width, height, nodes)) {
+			if (height < width) { height *= 2; }
+			else { width *= 2; }
+			if (max_size < width || max_size < height) { break; }
+		}
+		if (max_size < width || max_size < height) {
+			loge("[ttf] %u glyphs at %upx do not fit a %ux%u atlas\n", num_glyphs,
+				 point_sizes[a], max_size, max_size);
+			fits = false;
+			break;
+		}
+
+		atlas->width = width;
+		atlas->height = height;
+		atlas->bitmap = (u8*) calloc(width * height, 1);
+		for (u32 i = 0; i < num_glyphs; i++) {
+			TrueTypeFontAtlasGlyph* entry = atlas->glyphs + i;
+			TrueTypeFontAtlasCell* cell = atlas_cells + i;
+			entry->x = cell->x;
+			entry->y = cell->y;
+			entry->width = cell->width;
+			entry->height = cell->height;
+			entry->u0 = (s32) cell->x / (s32) width;
+			entry->v0 = (s32) cell->y / (s32) height;
+			entry->u1 = (s32) (cell->x + cell->width) / (s32) width;
+			entry->v1 = (s32) (cell->y + cell->height) / (s32) height;
+		}
+	}
+	free(nodes);
+	free(order);
+	free(spans);
+	arr_free(&outlines);
+	free(bucket_scales);
+	free(size_buckets);
+	free(glyph_indices);
+	if (!fits) {
+		arr_free(&lines);
+		free(cells);
+		for (u32 a = 0; a < count; a++) { ttf_font_atlas_free(atlases + a); }
+		return 0;
+	}
+
+	TrueTypeFontAtlasJob job = (TrueTypeFontAtlasJob) {
+		.lines = (line2f*) lines.data,
+		.cells = cells,
+		.num_cells = count * num_glyphs,
+		.atlases = atlases,
+		.flags = info->flags,
+		.scratch_size = 0,
+		.next_cell = 0
+	};
+	for (u32 i = 0; i < job.num_cells; i++) {
+		TrueTypeFontAtlasCell* cell = cells + i;
+		u64 scratch_size = ttf_fill_scratch_size(cell->num_lines, cell->width, cell->height,
+												 info->flags);
+		job.scratch_size = MAX(job.scratch_size, scratch_size);
+	}
+	u32 thread_count = MIN(info->thread_count, MIN(job.num_cells, TTF_ATLAS_MAX_THREADS));
+	HANDLE threads[TTF_ATLAS_MAX_THREADS];
+	u32 num_threads = 0;
+	for (u32 i = 1; i < thread_count; i++) {
+		threads[num_threads] = CreateThread(NULL, 0, ttf_atlas_worker, &job, 0, NULL);
+		if (threads[num_threads] == NULL) {
+			logw("[ttf] CreateThread failed, %u atlas threads\n", num_threads + 1);
+			break;
 		}
-		arr_clean(&intersections);
+		num_threads++;
+	}
+	ttf_atlas_worker(&job);
+	if (num_threads != 0) {
+		WaitForMultipleObjects(num_threads, threads, TRUE, INFINITE);
+		for (u32 i = 0; i < num_threads; i++) { CloseHandle(threads[i]); }
 	}
-	arr_free(&intersections);
 	arr_free(&lines);
+	free(cells);
+	return 1;
+}
 
-	// bmp_save("resources/atlas.bmp", bmp, width, height, 1);
-	return bmp;
+void ttf_font_atlas_free(TrueTypeFontAtlas* atlas)
+{
+	if (atlas->mapping) {
+		file_unmap(atlas->mapping);
+	} else {
+		free(atlas->bitmap);
+		free(atlas->glyphs);
+	}
+	*atlas = (TrueTypeFontAtlas) { 0 };
 }
 
-s32 f2fot14_to_float_2(u16 f2dot14) {
-	i8 tmp1 = (0xc000 & f2dot14) >> 14;
-	if (tmp1 == 2) {
-		tmp1 = -2;
+i16 ttf_kerning_get(TrueTypeFont* ttf, u32 left_glyph, u32 right_glyph)
+{
+	// font units to add to the left glyph's advance, 0 for pairs without kerning
+	if (ttf->num_glyphs <= left_glyph) { return 0; }
+	u32 glyphs = (left_glyph << 16) | (right_glyph & 0xffff);
+	u32 lo = ttf->kern_first[left_glyph];
+	u32 hi = ttf->kern_first[left_glyph + 1];
+	while (lo < hi) {
+		u32 mid = lo + (hi - lo) / 2;
+		if (ttf->kern_pairs[mid].glyphs < glyphs) { lo = mid + 1; }
+		else { hi = mid; }
 	}
-	else if (tmp1 == 3) {
-		tmp1 = -1;
+	if (lo < ttf->num_kern_pairs && ttf->kern_pairs[lo].glyphs == glyphs) {
+		return ttf->kern_pairs[lo].value;
 	}
-	
-	s32 scale = (s32) tmp1;
-	f2dot14 &= 0x3fff;
-	scale += (s32) (f2dot14 / 0x4000);
-	return scale;
+	return 0;
+}
+
+void ttf_measure_text(TrueTypeFont* ttf, const char* text, u32 length, u32 point_size,
+					  s32 max_width, TrueTypeFontTextMetrics* metrics)
+{
+	ttf_measure_texts(ttf, 1, &text, &length, point_size, max_width, metrics);
+}
+
+void ttf_measure_texts(TrueTypeFont* ttf, u32 count, const char** texts, const u32* lengths,
+					   u32 point_size, s32 max_width, TrueTypeFontTextMetrics* metrics)
+{
+	/*
+		NOTE:
+		 - utf-8, the same layout as vktextAddText(), hmtx advances plus kerning,
+		   '\n' starts a new line
+		 - 0 < max_width wraps greedily after spaces, a word wider than a line
+		   breaks between two characters, spaces a line wraps at do not count
+		 - only cmap, advances and kern pairs are read, never glyphs or outlines
+	 */
+	assert(ttf != NULL);
+
+	// everything adds up in font units, converted once per string
+	s32 scale = (s32) point_size / (s32) ttf->units_per_em;
+	i32 max_units = (0 < max_width) ? (i32) (max_width / scale) : 0;
+	s32 line_height = scale * (ttf->ascent - ttf->descent);
+
+	for (u32 t = 0; t < count; t++) {
+		const u8* ptr = (const u8*) texts[t];
+		const u8* end = ptr + lengths[t];
+		i32 widest = 0;
+		i32 line = 0;
+		i32 before_space = 0;			// line without the spaces it may wrap at
+		i32 word_start = -1;			// line where the last word began, -1 for none
+		u32 num_lines = (ptr < end) ? 1 : 0;
+		u32 prev = 0;
+
+		while (ptr < end) {
+			u32 c = *ptr;
+			if (c < 0x80) { ptr++; }
+			else { c = ttf_utf8_next(&ptr, end); }
+
+			if (c == '\n') {
+				widest = MAX(widest, line);
+				line = 0;
+				word_start = -1;
+				prev = 0;
+				num_lines++;
+				continue;
+			}
+
+			u32 glyph_index = (c < ttf->cmap_dense_size) ?
+				ttf->cmap_dense[c] : (u32) ttf_glyph_index_get(ttf, c);
+			i32 advance = ttf->advances[MIN(glyph_index, ttf->num_glyphs - 1u)];
+			if (prev != 0) { advance += ttf_kerning_get(ttf, prev, glyph_index); }
+			prev = glyph_index;
+
+			if (c == ' ') {
+				if (word_start != line) { before_space = line; }
+				line += advance;
+				word_start = line;
+				continue;
+			}
+
+			if (max_units != 0 && max_units < line + advance && line != 0) {
+				num_lines++;
+				if (0 <= word_start) {
+					// the word moves down, it is everything after the spaces
+					widest = MAX(widest, before_space);
+					line -= word_start;
+				} else {
+					widest = MAX(widest, line);
+					line = 0;
+				}
+				word_start = -1;
+			}
+			line += advance;
+		}
+		widest = MAX(widest, line);
+
+		metrics[t] = (TrueTypeFontTextMetrics) {
+			scale * widest, line_height * num_lines, num_lines
+		};
+	}
+}
+
+u32 ttf_text_fit(TrueTypeFont* ttf, const char* text, u32 length, u32 point_size,
+				 s32 max_width, s32* width)
+{
+	// bytes of the first line that fit in max_width, e.g. what is left before an
+	// ellipsis, 'width' gets their width when not NULL
+	assert(ttf != NULL);
+
+	s32 scale = (s32) point_size / (s32) ttf->units_per_em;
+	i32 max_units = (i32) (max_width / scale);
+	const u8* begin = (const u8*) text;
+	const u8* ptr = begin;
+	const u8* end = ptr + length;
+	i32 line = 0;
+	u32 prev = 0;
+	u32 fit = 0;
+	while (ptr < end) {
+		u32 c = *ptr;
+		if (c < 0x80) { ptr++; }
+		else { c = ttf_utf8_next(&ptr, end); }
+		if (c == '\n') { break; }
+
+		u32 glyph_index = (c < ttf->cmap_dense_size) ?
+			ttf->cmap_dense[c] : (u32) ttf_glyph_index_get(ttf, c);
+		i32 advance = ttf->advances[MIN(glyph_index, ttf->num_glyphs - 1u)];
+		if (prev != 0) { advance += ttf_kerning_get(ttf, prev, glyph_index); }
+		prev = glyph_index;
+
+		if (max_units < line + advance) { break; }
+		line += advance;
+		fit = ptr - begin;
+	}
+
+	if (width != NULL) { *width = scale * line; }
+	return fit;
+}
+
+TrueTypeFontAtlasGlyph* ttf_font_atlas_glyph_get(TrueTypeFontAtlas* atlas, u32 code_point)
+{
+	// NULL if the code point was not packed
+	u32 lo = 0;
+	u32 hi = atlas->num_glyphs;
+	while (lo < hi) {
+		u32 mid = lo + (hi - lo) / 2;
+		if (atlas->glyphs[mid].code_point < code_point) { lo = mid + 1; }
+		else { hi = mid; }
+	}
+	if (lo < atlas->num_glyphs && atlas->glyphs[lo].code_point == code_point) {
+		return atlas->glyphs + lo;
+	}
+	return NULL;
+}
+
+void ttf_arena_init(TrueTypeFontArena* arena, void* memory, u64 size)
+{
+	// the memory stays the caller's, pushes are undone when a call returns
+	*arena = (TrueTypeFontArena) {
+		.base = (u8*) memory,
+		.size = size,
+		.offset = 0
+	};
+}
+
+void ttf_glyph_bitmap_metrics(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+							  TrueTypeFontRasterFlags flags, TrueTypeFontGlyphBitmap* bitmap)
+{
+	// the size and placement ttf_glyph_rasterize fills, pixels is always NULL
+	assert(ttf != NULL);
+	assert(bitmap != NULL);
+
+	s32 spread;
+	s32 scale = ttf_glyph_raster_scale(ttf, point_size, flags, &padding, &spread);
+	TrueTypeFontAtlasGlyph entry = (TrueTypeFontAtlasGlyph) { 0 };
+	entry.glyph_index = glyph_index;
+	TrueTypeFontAtlasCell cell = (TrueTypeFontAtlasCell) { 0 };
+	ttf_glyph_cell_measure(ttf, &entry, scale, padding, &cell);
+
+	*bitmap = (TrueTypeFontGlyphBitmap) {
+		.width = cell.width,
+		.height = cell.height,
+		.bearing_x = entry.bearing_x,
+		.bearing_y = entry.bearing_y,
+		.advance = entry.advance,
+		.pixels = NULL
+	};
+}
+
+u64 ttf_glyph_scratch_size(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						   TrueTypeFontRasterFlags flags)
+{
+	// enough for ttf_glyph_rasterize with any clip rect
+	assert(ttf != NULL);
+
+	TrueTypeFontGlyphBitmap bitmap;
+	ttf_glyph_bitmap_metrics(ttf, glyph_index, point_size, padding, flags, &bitmap);
+	if (bitmap.width == 0) { return 0; }
+
+	s32 spread;
+	s32 scale = ttf_glyph_raster_scale(ttf, point_size, flags, &padding, &spread);
+	u32 num_lines = ttf_glyph_edges_get(ttf, glyph_index, scale)->num_lines;
+	return num_lines * sizeof(line2f) + 16 +
+		ttf_fill_scratch_size(num_lines, bitmap.width, bitmap.height, flags);
+}
+
+int ttf_glyph_rasterize(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						TrueTypeFontRasterFlags flags, const TrueTypeFontRasterTarget* target,
+						TrueTypeFontArena* scratch)
+{
+	/*
+	  	USAGE:
+
+		TrueTypeFontGlyphBitmap bitmap;
+		ttf_glyph_bitmap_metrics(ttf, glyph_index, 32, 1, TTF_RASTER_AA, &bitmap);
+		... reserve bitmap.width x bitmap.height at dst, grow scratch to
+		    ttf_glyph_scratch_size(ttf, glyph_index, 32, 1, TTF_RASTER_AA) ...
+		TrueTypeFontRasterTarget target = { dst, dst_stride, 0, 0, 0, 0 };
+		ttf_glyph_rasterize(ttf, glyph_index, 32, 1, TTF_RASTER_AA, &target, &scratch);
+
+	  	NOTE:
+		 - same pixels as ttf_glyph_bitmap_create, written in place, nothing is
+		   allocated and every pixel of the clipped cell is overwritten
+		 - returns 0 and leaves the target alone when scratch is too small
+		 - uses the font's edge cache, one thread per font like ttf_glyph_get
+	 */
+	assert(ttf != NULL);
+	assert(target != NULL && target->pixels != NULL);
+	assert(scratch != NULL);
+
+	s32 spread;
+	s32 scale = ttf_glyph_raster_scale(ttf, point_size, flags, &padding, &spread);
+	TrueTypeFontAtlasGlyph entry = (TrueTypeFontAtlasGlyph) { 0 };
+	entry.glyph_index = glyph_index;
+	TrueTypeFontAtlasCell cell = (TrueTypeFontAtlasCell) { 0 };
+	ttf_glyph_cell_measure(ttf, &entry, scale, padding, &cell);
+
+	u32 x0 = target->clip_x;
+	u32 y0 = target->clip_y;
+	u32 x1 = cell.width;
+	u32 y1 = cell.height;
+	if (target->clip_width != 0 || target->clip_height != 0) {
+		x1 = MIN(x1, x0 + target->clip_width);
+		y1 = MIN(y1, y0 + target->clip_height);
+	}
+	if (x1 <= x0 || y1 <= y0) { return 1; }
+
+	TrueTypeFontEdgeList* edges = ttf_glyph_edges_get(ttf, glyph_index, scale);
+	u64 offset = scratch->offset;
+	line2f* lines = (line2f*) ttf_arena_push(scratch, edges->num_lines * sizeof(line2f));
+	u64 fill_size = ttf_fill_scratch_size(edges->num_lines, cell.width, y1 - y0, flags);
+	if ((lines == NULL && edges->num_lines != 0) ||
+		scratch->size - scratch->offset < fill_size) {
+		scratch->offset = offset;
+		return 0;
+	}
+
+	u32 num_lines = ttf_glyph_lines(edges, scale, -entry.bearing_x, entry.bearing_y, false,
+									lines);
+	ttf_fill_lines(lines, num_lines, target->pixels + (u64) y0 * target->stride + x0,
+				   target->stride, cell.width, x0, y0, x1 - x0, y1 - y0, flags, spread,
+				   scratch);
+	scratch->offset = offset;
+	return 1;
+}
+
+u32 ttf_glyph_raster_lines(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+						   TrueTypeFontRasterFlags flags, line2f* lines, s32* sdf_spread)
+{
+	/*
+	  	NOTE:
+		 - the lines ttf_glyph_rasterize fills, in pixels from the top left of the
+		   cell ttf_glyph_bitmap_metrics measures, y down
+		 - lines can be NULL to only count them, the count is 0 for empty glyphs
+		 - for rasterizers that live elsewhere, the gpu one in vkgc_cache.c
+	 */
+	assert(ttf != NULL);
+
+	s32 spread;
+	s32 scale = ttf_glyph_raster_scale(ttf, point_size, flags, &padding, &spread);
+	if (sdf_spread != NULL) { *sdf_spread = spread; }
+	TrueTypeFontAtlasGlyph entry = (TrueTypeFontAtlasGlyph) { 0 };
+	entry.glyph_index = glyph_index;
+	TrueTypeFontAtlasCell cell = (TrueTypeFontAtlasCell) { 0 };
+	ttf_glyph_cell_measure(ttf, &entry, scale, padding, &cell);
+	if (cell.width == 0) { return 0; }
+
+	TrueTypeFontEdgeList* edges = ttf_glyph_edges_get(ttf, glyph_index, scale);
+	if (lines == NULL) { return edges->num_lines; }
+	return ttf_glyph_lines(edges, scale, -entry.bearing_x, entry.bearing_y, false, lines);
+}
+
+void ttf_glyph_bitmap_create(TrueTypeFont* ttf, u32 glyph_index, u32 point_size, u32 padding,
+							 TrueTypeFontRasterFlags flags, TrueTypeFontGlyphBitmap* bitmap)
+{
+	/*
+	  	NOTE:
+		 - one glyph rasterized and measured exactly like an atlas cell, for caches
+		   that pack glyphs themselves
+		 - pixels is NULL and the size 0x0 for glyphs without an outline
+		 - TTF_RASTER_SDF uses a spread of point_size / 8, padding grows to fit it
+		 - ttf_glyph_rasterize writes the same pixels into memory the caller owns
+	 */
+	assert(ttf != NULL);
+	assert(bitmap != NULL);
+
+	ttf_glyph_bitmap_metrics(ttf, glyph_index, point_size, padding, flags, bitmap);
+	if (bitmap->width == 0) { return; }
+
+	u64 scratch_size = ttf_glyph_scratch_size(ttf, glyph_index, point_size, padding, flags);
+	void* memory = malloc(scratch_size);
+	TrueTypeFontArena scratch;
+	ttf_arena_init(&scratch, memory, scratch_size);
+	bitmap->pixels = (u8*) malloc(bitmap->width * bitmap->height);
+	TrueTypeFontRasterTarget target = { bitmap->pixels, bitmap->width, 0, 0, 0, 0 };
+	ttf_glyph_rasterize(ttf, glyph_index, point_size, padding, flags, &target, &scratch);
+	free(memory);
+}
+
+void ttf_glyph_bitmap_free(TrueTypeFontGlyphBitmap* bitmap)
+{
+	free(bitmap->pixels);
+	*bitmap = (TrueTypeFontGlyphBitmap) { 0 };
+}
+
+static bool ttf_skyline_pack(TrueTypeFontAtlasCell* cells, u64* order, u32 num_cells,
+							 u32 width, u32 height, TrueTypeFontSkylineNode* nodes)
+{
+	/*
+	  	NOTE:
+		 - the skyline is the top edge of everything packed so far as a list of
+		   horizontal segments, each cell goes where its top ends up lowest,
+		   leftmost on ties
+		 - every cell adds at most one segment, nodes holds num_cells + 1
+	 */
+	u32 num_nodes = 1;
+	nodes[0] = (TrueTypeFontSkylineNode) { 0, 0, width };
+
+	for (u32 n = 0; n < num_cells; n++) {
+		TrueTypeFontAtlasCell* cell = cells + (order[n] & 0xfffff);
+		cell->x = 0;
+		cell->y = 0;
+		if (cell->width == 0 || cell->height == 0) { continue; }
+
+		u32 best = num_nodes;
+		u32 best_y = 0;
+		for (u32 i = 0; i < num_nodes; i++) {
+			u32 x = nodes[i].x;
+			if (width < x + cell->width) { break; }
+			u32 y = 0;
+			for (u32 j = i; j < num_nodes && nodes[j].x < x + cell->width; j++) {
+				y = MAX(y, nodes[j].y);
+			}
+			if (height < y + cell->height) { continue; }
+			if (best == num_nodes || y < best_y) {
+				best = i;
+				best_y = y;
+			}
+		}
+		if (best == num_nodes) { return false; }
+
+		cell->x = nodes[best].x;
+		cell->y = best_y;
+
+		memmove(nodes + best + 1, nodes + best, (num_nodes - best) * sizeof(*nodes));
+		nodes[best] = (TrueTypeFontSkylineNode) { cell->x, best_y + cell->height, cell->width };
+		num_nodes++;
+
+		// the new segment shadows the ones it spans
+		u32 right = cell->x + cell->width;
+		while (best + 1 < num_nodes && nodes[best + 1].x < right) {
+			TrueTypeFontSkylineNode* node = nodes + best + 1;
+			u32 shrink = right - node->x;
+			if (shrink < node->width) {
+				node->x += shrink;
+				node->width -= shrink;
+				break;
+			}
+			memmove(node, node + 1, (num_nodes - best - 2) * sizeof(*nodes));
+			num_nodes--;
+		}
+
+		for (u32 i = 0; i + 1 < num_nodes;) {
+			if (nodes[i].y == nodes[i + 1].y) {
+				nodes[i].width += nodes[i + 1].width;
+				memmove(nodes + i + 1, nodes + i + 2, (num_nodes - i - 2) * sizeof(*nodes));
+				num_nodes--;
+			} else { i++; }
+		}
+	}
+
+	return true;
+}
+
+static i32 ttf_u32_cmp(const void* a, const void* b)
+{
+	u32 x = *((u32*) a);
+	u32 y = *((u32*) b);
+	return (x > y) - (x < y);
+}
+
+static u64 ttf_hash(const void* data, u64 size)
+{
+	// FNV-1a over 8 byte words with a shift to fold high bits down, four words
+	// at a time in lanes that do not wait on each other's multiplies, it only
+	// has to notice a font file that changed
+	const u8* bytes = data;
+	u64 lanes[4] = {
+		0xcbf29ce484222325ull ^ size, 0x84222325cbf29ce4ull, 0x9e3779b97f4a7c15ull,
+		0xbf58476d1ce4e5b9ull
+	};
+	u64 i = 0;
+	for (; i + 4 * U64_SIZE <= size; i += 4 * U64_SIZE) {
+		u64 words[4];
+		memcpy(words, bytes + i, 4 * U64_SIZE);
+		for (u32 l = 0; l < 4; l++) {
+			lanes[l] = (lanes[l] ^ words[l]) * 0x100000001b3ull;
+			lanes[l] ^= lanes[l] >> 29;
+		}
+	}
+	u64 hash = lanes[0];
+	for (u32 l = 1; l < 4; l++) {
+		hash = (hash ^ lanes[l]) * 0x100000001b3ull;
+		hash ^= hash >> 29;
+	}
+	for (; i < size; i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+static void* ttf_cache_put(void* font, u64* tail, const void* src, u64 size)
+{
+	// appends at the 8 byte aligned tail, the offset from the font is stored in
+	// place of the pointer, 'font' is NULL while measuring
+	if (src == NULL) { return NULL; }
+	u64 offset = *tail;
+	if (font != NULL) { memcpy(font + offset, src, size); }
+	*tail = (offset + size + 7) & ~7ull;
+	return (void*) (uintptr_t) offset;
+}
+
+static bool ttf_cache_relocate(TrueTypeFont* ttf, u64 limit, void** ptr, u64 size)
+{
+	// offsets become pointers into the view, anything outside of it is rejected
+	u64 offset = (u64) (uintptr_t) *ptr;
+	if (offset == 0) { return size == 0; }
+	if (offset < sizeof(TrueTypeFont) || limit < offset || limit - offset < size) {
+		return false;
+	}
+	*ptr = ((void*) ttf) + offset;
+	return true;
+}
+
+static u32 ttf_atlas_code_points(const char* characters, u32** code_points)
+{
+	// the unique code points of the utf-8 string in ascending order
+	u32 length = strlen(characters);
+	u32* points = (u32*) malloc(MAX(length, 1) * U32_SIZE);
+	const u8* ptr = (const u8*) characters;
+	const u8* end = ptr + length;
+	u32 num_code_points = 0;
+	while (ptr < end) { points[num_code_points++] = ttf_utf8_next(&ptr, end); }
+	qsort(points, num_code_points, U32_SIZE, ttf_u32_cmp);
+	u32 num_unique = 0;
+	for (u32 i = 0; i < num_code_points; i++) {
+		if (num_unique == 0 || points[num_unique - 1] != points[i]) {
+			points[num_unique++] = points[i];
+		}
+	}
+	*code_points = points;
+	return num_unique;
+}
+
+static bool ttf_atlas_cache_path(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 char* path, u32 size)
+{
+	// the file name is the key's hash, the header holds the key to tell collisions apart
+	u64 hash = ttf_hash(key, sizeof(TrueTypeFontAtlasCacheKey));
+	i32 length = snprintf(path, size, "%s/%016llx.atlas", cache_dir,
+						  (unsigned long long) hash);
+	return 0 < length && (u32) length < size;
+}
+
+static bool ttf_atlas_cache_load(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 TrueTypeFontAtlas* atlas)
+{
+	/*
+		header								// magic, key, atlas size and metrics
+		glyphs								// num_glyphs TrueTypeFontAtlasGlyph
+		bitmap								// width * height
+
+		NOTE:
+		 - the view is copy on write, the atlas is used and freed like a
+		   rasterized one, nothing is read until its pages are touched
+		 - false leaves the atlas empty, a missing file is not worth a warning
+	 */
+	*atlas = (TrueTypeFontAtlas) { 0 };
+	char path[512];
+	if (!ttf_atlas_cache_path(cache_dir, key, path, sizeof(path))) { return false; }
+
+	u32 size;
+	void* view = file_map(path, &size);
+	if (view == NULL) { return false; }
+
+	TrueTypeFontAtlasCacheHeader* header = view;
+	u64 glyphs_size = 0;
+	u64 bitmap_size = 0;
+	bool valid = sizeof(TrueTypeFontAtlasCacheHeader) <= size &&
+		header->magic == TTF_ATLAS_CACHE_MAGIC && header->file_size == size &&
+		memcmp(&header->key, key, sizeof(TrueTypeFontAtlasCacheKey)) == 0 &&
+		header->num_glyphs == key->num_code_points;
+	if (valid) {
+		glyphs_size = (u64) header->num_glyphs * sizeof(TrueTypeFontAtlasGlyph);
+		bitmap_size = (u64) header->width * header->height;
+		valid = sizeof(TrueTypeFontAtlasCacheHeader) + glyphs_size + bitmap_size == size;
+	}
+	if (!valid) {
+		logw("[ttf] %s is not an atlas cache for this font and build\n", path);
+		file_unmap(view);
+		return false;
+	}
+
+	atlas->width = header->width;
+	atlas->height = header->height;
+	atlas->scale = header->scale;
+	atlas->ascent = header->ascent;
+	atlas->descent = header->descent;
+	atlas->sdf_spread = header->sdf_spread;
+	atlas->num_glyphs = header->num_glyphs;
+	atlas->glyphs = (TrueTypeFontAtlasGlyph*) (view + sizeof(TrueTypeFontAtlasCacheHeader));
+	atlas->bitmap = (u8*) atlas->glyphs + glyphs_size;
+	atlas->mapping = view;
+	return true;
+}
+
+static void ttf_atlas_cache_save(const char* cache_dir, const TrueTypeFontAtlasCacheKey* key,
+								 const TrueTypeFontAtlas* atlas)
+{
+	// a failed save only costs the next launch a rasterization
+	char path[512];
+	if (!ttf_atlas_cache_path(cache_dir, key, path, sizeof(path))) { return; }
+	CreateDirectoryA(cache_dir, NULL);
+
+	u64 glyphs_size = (u64) atlas->num_glyphs * sizeof(TrueTypeFontAtlasGlyph);
+	u64 bitmap_size = (u64) atlas->width * atlas->height;
+	u64 size = sizeof(TrueTypeFontAtlasCacheHeader) + glyphs_size + bitmap_size;
+	if (0xffffffff < size) { return; }
+
+	void* image = malloc(size);
+	TrueTypeFontAtlasCacheHeader* header = image;
+	*header = (TrueTypeFontAtlasCacheHeader) {
+		TTF_ATLAS_CACHE_MAGIC, (u32) size, *key, atlas->width, atlas->height, atlas->scale,
+		atlas->ascent, atlas->descent, atlas->sdf_spread, atlas->num_glyphs, 0
+	};
+	memcpy(image + sizeof(TrueTypeFontAtlasCacheHeader), atlas->glyphs, glyphs_size);
+	memcpy(image + sizeof(TrueTypeFontAtlasCacheHeader) + glyphs_size, atlas->bitmap,
+		   bitmap_size);
+	if (!file_write(path, image, size)) {
+		logw("[ttf] could not save the atlas cache %s\n", path);
+	}
+	free(image);
+}
+
+static i32 ttf_u64_cmp(const void* a, const void* b)
+{
+	u64 x = *((u64*) a);
+	u64 y = *((u64*) b);
+	return (x > y) - (x < y);
+}
+
+static void ttf_flatten_quad(Array* lines, vec2f p0, vec2f c, vec2f p1, s32 tolerance)
+{
+	// a quadratic split into n chords strays at most |p0 - 2c + p1| / (4 n^2)
+	s32 ddx = p0.x - 2.0f * c.x + p1.x;
+	s32 ddy = p0.y - 2.0f * c.y + p1.y;
+	s32 dd = sqrtf(ddx * ddx + ddy * ddy);
+	u32 n = (u32) ceilf(sqrtf(dd / (4.0f * tolerance)));
+	n = MIN(MAX(n, 1), TTF_FLATTEN_MAX_SEGMENTS);
+
+	vec2f point0 = p0;
+	for (u32 i = 1; i <= n; i++) {
+		s32 t = (s32) i / (s32) n;
+		s32 u = 1.0f - t;
+		vec2f point1 = {
+			u * u * p0.x + 2.0f * u * t * c.x + t * t * p1.x,
+			u * u * p0.y + 2.0f * u * t * c.y + t * t * p1.y
+		};
+		if (i == n) { point1 = p1; }
+		line2f line = { point0, point1 };
+		arr_add(lines, &line);
+		point0 = point1;
+	}
+}
+
+static void ttf_flatten_glyph(TrueTypeFont* ttf, TrueTypeFontGlyph* glyph, s32 tolerance,
+							  Array* lines)
+{
+	i16* pts_x = ttf->outlines.pts_x + glyph->first_point;
+	i16* pts_y = ttf->outlines.pts_y + glyph->first_point;
+	u8* on_curve = ttf->outlines.on_curve + glyph->first_point;
+	u16* end_pts = ttf->outlines.end_pts + glyph->first_contour;
+
+	u32 contour_start = 0;
+	for (i16 c = 0; c < glyph->num_contours; c++) {
+		u32 contour_end = end_pts[c];
+		u32 n = contour_end - contour_start + 1;
+
+		/*
+		  	NOTE:
+			 - the contour starts at its first on-curve point and the walk ends on
+			   that point again, which closes it
+			 - a contour made only of off-curve points starts at the implied point
+			   between its last and first point
+		 */
+		u32 start = n - 1;
+		vec2f start_point = {
+			0.5f * (pts_x[contour_start] + pts_x[contour_end]),
+			0.5f * (pts_y[contour_start] + pts_y[contour_end])
+		};
+		for (u32 i = 0; i < n; i++) {
+			if (on_curve[contour_start + i]) {
+				start = i;
+				start_point = (vec2f) { pts_x[contour_start + i], pts_y[contour_start + i] };
+				break;
+			}
+		}
+
+		vec2f point = start_point;
+		vec2f control;
+		bool has_control = false;
+		for (u32 k = 0; k < n; k++) {
+			u32 i = contour_start + (start + 1 + k) % n;
+			vec2f next = { pts_x[i], pts_y[i] };
+			if (on_curve[i]) {
+				if (has_control) { ttf_flatten_quad(lines, point, control, next, tolerance); }
+				else {
+					line2f line = { point, next };
+					arr_add(lines, &line);
+				}
+				point = next;
+				has_control = false;
+			} else {
+				if (has_control) {
+					// two off-curve points in a row imply an on-curve one between them
+					vec2f mid = { 0.5f * (control.x + next.x), 0.5f * (control.y + next.y) };
+					ttf_flatten_quad(lines, point, control, mid, tolerance);
+					point = mid;
+				}
+				control = next;
+				has_control = true;
+			}
+		}
+		if (has_control) { ttf_flatten_quad(lines, point, control, start_point, tolerance); }
+
+		contour_start = contour_end + 1;
+	}
+}
+
+static u32 ttf_edge_bucket(TrueTypeFont* ttf, s32 scale)
+{
+	// log2 of the pixels per em, rounded up
+	s32 pixels_per_em = MAX(scale * ttf->units_per_em, 1.0f);
+	return MIN((u32) ceilf(log2f(pixels_per_em)), TTF_EDGE_CACHE_BUCKETS - 1);
+}
+
+TrueTypeFontEdgeList* ttf_glyph_edges_get(TrueTypeFont* ttf, u32 glyph_index, s32 scale)
+{
+	/*
+	  	NOTE:
+		 - edge lists are kept in font units and flattened for the largest scale of
+		   their bucket, every scale inside a bucket reuses them and stays within
+		   TTF_FLATTEN_TOLERANCE pixels
+		 - the cache is direct mapped, a miss evicts whatever held the slot
+	 */
+	assert(ttf != NULL);
+	assert(0.0f < scale);
+	if (ttf->num_glyphs <= glyph_index) { glyph_index = 0; }
+
+	u32 bucket = ttf_edge_bucket(ttf, scale);
+
+	TrueTypeFontEdgeCache* cache = &ttf->edge_cache;
+	u32 key = glyph_index * TTF_EDGE_CACHE_BUCKETS + bucket;
+	u32 slot = ((key * 2654435761u) >> 16) & (cache->capacity - 1);
+	TrueTypeFontEdgeList* entry = cache->entries + slot;
+	if (entry->glyph_index == glyph_index && entry->bucket == bucket) {
+		cache->hits++;
+		return entry;
+	}
+
+	cache->misses++;
+	if (entry->glyph_index != ~0u) {
+		cache->evictions++;
+		free(entry->lines);
+	}
+
+	s32 bucket_scale = (s32) (1 << bucket) / (s32) ttf->units_per_em;
+	Array lines;
+	arr_init(&lines, sizeof(line2f));
+	ttf_flatten_glyph(ttf, ttf_glyph_get(ttf, glyph_index),
+					  TTF_FLATTEN_TOLERANCE / bucket_scale, &lines);
+
+	entry->glyph_index = glyph_index;
+	entry->bucket = bucket;
+	entry->num_lines = lines.size;
+	entry->lines = (line2f*) lines.data;	// the array's storage is handed over
+	return entry;
+}
+
+void ttf_edge_cache_reset(TrueTypeFont* ttf, u32 capacity)
+{
+	// drops every cached edge list and the counters, capacity 0 only frees
+	assert(ttf != NULL);
+	assert((capacity & (capacity - 1)) == 0);
+
+	TrueTypeFontEdgeCache* cache = &ttf->edge_cache;
+	for (u32 i = 0; i < cache->capacity; i++) {
+		if (cache->entries[i].glyph_index != ~0u) { free(cache->entries[i].lines); }
+	}
+	free(cache->entries);
+
+	*cache = (TrueTypeFontEdgeCache) { 0 };
+	if (capacity == 0) { return; }
+
+	cache->capacity = capacity;
+	cache->entries = (TrueTypeFontEdgeList*) malloc(capacity * sizeof(TrueTypeFontEdgeList));
+	for (u32 i = 0; i < capacity; i++) {
+		cache->entries[i] = (TrueTypeFontEdgeList) { ~0u, 0, 0, NULL };
+	}
+}
+
+TrueTypeFontMesh* ttf_glyph_mesh_get(TrueTypeFont* ttf, u32 glyph_index)
+{
+	/*
+	  	USAGE:
+
+		TrueTypeFontMesh* mesh = ttf_glyph_mesh_get(ttf, glyph_index);
+		for every triangle t < mesh->num_vertices / 3, pixel = pen + scale * (x, -y),
+		see shaders/vector.frag for the curve test
+
+	  	NOTE:
+		 - the mesh is the glyph's outline at every size, solid triangles cover
+		   the polygon through the on-curve points, one curve triangle per
+		   quadratic adds or keeps out the part between its chord and the curve
+		 - solid triangles are nonzero winding trapezoids, overlapping contours
+		   are fine, curves whose control triangles overlap are halved first
+		 - meshes are kept until ttf_mesh_cache_reset or ttf_free
+	 */
+	assert(ttf != NULL);
+	if (ttf->num_glyphs <= glyph_index) { glyph_index = 0; }
+
+	if (ttf->meshes == NULL) {
+		ttf->meshes = (TrueTypeFontMesh*) malloc(ttf->num_glyphs * sizeof(TrueTypeFontMesh));
+		for (u32 i = 0; i < ttf->num_glyphs; i++) {
+			ttf->meshes[i] = (TrueTypeFontMesh) { ~0u, 0, NULL };
+		}
+	}
+	TrueTypeFontMesh* mesh = ttf->meshes + glyph_index;
+	if (mesh->num_vertices != ~0u) { return mesh; }
+
+	Array edges;
+	Array curves;
+	Array vertices;
+	arr_init(&edges, sizeof(TrueTypeFontMeshEdge));
+	arr_init(&curves, sizeof(TrueTypeFontMeshVertex));
+	arr_init(&vertices, sizeof(TrueTypeFontMeshVertex));
+	ttf_mesh_outline(ttf, glyph_index, &edges, &curves);
+	ttf_mesh_fill((TrueTypeFontMeshEdge*) edges.data, edges.size, &vertices);
+
+	mesh->num_curves = curves.size / 3;
+	mesh->num_vertices = vertices.size + curves.size;
+	mesh->vertices = (TrueTypeFontMeshVertex*)
+		malloc(MAX(mesh->num_vertices, 1) * sizeof(TrueTypeFontMeshVertex));
+	memcpy(mesh->vertices, vertices.data, vertices.size * sizeof(TrueTypeFontMeshVertex));
+	memcpy(mesh->vertices + vertices.size, curves.data,
+		   curves.size * sizeof(TrueTypeFontMeshVertex));
+	arr_free(&edges);
+	arr_free(&curves);
+	arr_free(&vertices);
+	return mesh;
+}
+
+void ttf_mesh_cache_reset(TrueTypeFont* ttf)
+{
+	// frees every glyph mesh, they are built again on demand
+	assert(ttf != NULL);
+	if (ttf->meshes == NULL) { return; }
+
+	for (u32 i = 0; i < ttf->num_glyphs; i++) { free(ttf->meshes[i].vertices); }
+	free(ttf->meshes);
+	ttf->meshes = NULL;
+}
+
+static void ttf_mesh_edge(Array* edges, vec2f p0, vec2f p1)
+{
+	// horizontal edges never bound a trapezoid
+	if (p0.y == p1.y) { return; }
+	TrueTypeFontMeshEdge edge = (p0.y < p1.y) ?
+		(TrueTypeFontMeshEdge) { p0, p1, 1 } : (TrueTypeFontMeshEdge) { p1, p0, -1 };
+	arr_add(edges, &edge);
+}
+
+static i32 ttf_mesh_winding(const TrueTypeFontEdgeList* outline, vec2f p)
+{
+	// nonzero winding of p, rays go right
+	i32 winding = 0;
+	for (u32 i = 0; i < outline->num_lines; i++) {
+		const line2f* line = outline->lines + i;
+		if ((line->p0.y <= p.y) == (line->p1.y <= p.y)) { continue; }
+		s32 x = line->p0.x + (p.y - line->p0.y) * (line->p1.x - line->p0.x) /
+			(line->p1.y - line->p0.y);
+		if (p.x < x) { winding += (line->p0.y < line->p1.y) ? 1 : -1; }
+	}
+	return winding;
+}
+
+static void ttf_mesh_curve(Array* edges, Array* vertices, const TrueTypeFontEdgeList* outline,
+						   vec2f p0, vec2f c, vec2f p1)
+{
+	/*
+	  	NOTE:
+		 - with the ink away from the control point the curve bulges out, the
+		   chord bounds the polygon and the curve triangle fills the lens between
+		   chord and curve, u * u - v < 0
+		 - with the ink on the control point's side the curve bulges in, the
+		   polygon goes around the control point and the triangle fills the
+		   control point's side of the curve
+		 - the side is probed next to the curve's midpoint, contours that run
+		   against the font's direction still come out right
+	 */
+	vec2f mid = {
+		0.25f * p0.x + 0.5f * c.x + 0.25f * p1.x,
+		0.25f * p0.y + 0.5f * c.y + 0.25f * p1.y
+	};
+	vec2f d = { c.x - mid.x, c.y - mid.y };
+	s32 length = sqrtf(d.x * d.x + d.y * d.y);
+	if (length < 1e-3f) {
+		ttf_mesh_edge(edges, p0, p1);
+		return;
+	}
+	s32 probe = TTF_MESH_PROBE / length;
+	bool ink_in = ttf_mesh_winding(outline, (vec2f) { mid.x + probe * d.x,
+													  mid.y + probe * d.y }) != 0;
+	bool ink_out = ttf_mesh_winding(outline, (vec2f) { mid.x - probe * d.x,
+													   mid.y - probe * d.y }) != 0;
+	if (ink_in == ink_out) {
+		// inside overlapping contours, or too thin to tell, the chord does
+		ttf_mesh_edge(edges, p0, p1);
+		return;
+	}
+
+	s32 side = ink_out ? 1.0f : -1.0f;
+	if (ink_out) {
+		ttf_mesh_edge(edges, p0, p1);
+	} else {
+		ttf_mesh_edge(edges, p0, c);
+		ttf_mesh_edge(edges, c, p1);
+	}
+	TrueTypeFontMeshVertex triangle[3] = {
+		{ p0.x, p0.y, 0.0f, 0.0f, side },
+		{ c.x, c.y, 0.5f, 0.0f, side },
+		{ p1.x, p1.y, 1.0f, 1.0f, side }
+	};
+	for (u32 i = 0; i < 3; i++) { arr_add(vertices, triangle + i); }
+}
+
+static bool ttf_mesh_separated(const vec2f* a, u32 na, const vec2f* b, u32 nb)
+{
+	// some edge normal of a keeps b strictly on the far side, touching is apart
+	for (u32 i = 0; i < na; i++) {
+		vec2f p = a[i];
+		vec2f q = a[(i + 1) % na];
+		vec2f normal = { q.y - p.y, p.x - q.x };
+		s32 a_min = INFINITY;
+		s32 a_max = -INFINITY;
+		s32 b_min = INFINITY;
+		s32 b_max = -INFINITY;
+		for (u32 j = 0; j < na; j++) {
+			s32 d = normal.x * a[j].x + normal.y * a[j].y;
+			a_min = MIN(a_min, d);
+			a_max = MAX(a_max, d);
+		}
+		for (u32 j = 0; j < nb; j++) {
+			s32 d = normal.x * b[j].x + normal.y * b[j].y;
+			b_min = MIN(b_min, d);
+			b_max = MAX(b_max, d);
+		}
+		s32 epsilon = 1e-3f * (fabsf(normal.x) + fabsf(normal.y));
+		if (a_max <= b_min + epsilon || b_max <= a_min + epsilon) { return true; }
+	}
+	return false;
+}
+
+static bool ttf_mesh_overlap(const TrueTypeFontMeshSegment* curve,
+							 const TrueTypeFontMeshSegment* other)
+{
+	// control triangle against a line or another control triangle
+	vec2f a[3] = { curve->p0, curve->c, curve->p1 };
+	vec2f b[3] = { other->p0, other->curve ? other->c : other->p1, other->p1 };
+	u32 nb = other->curve ? 3 : 2;
+	return !ttf_mesh_separated(a, 3, b, nb) && !ttf_mesh_separated(b, nb, a, 3);
+}
+
+static void ttf_mesh_split(Array* segments)
+{
+	/*
+	  	NOTE:
+		 - the polygon through chords and control points is only the glyph's
+		   outline when no control triangle overlaps another segment, curves
+		   that do are halved at t = 0.5 until they do not
+		 - gives up after TTF_MESH_MAX_SPLITS rounds, overlaps left then show as
+		   slivers of wrong coverage
+	 */
+	for (u32 round = 0; round < TTF_MESH_MAX_SPLITS; round++) {
+		u32 num_segments = segments->size;
+		bool* split = (bool*) calloc(num_segments, sizeof(bool));
+		bool any = false;
+		for (u32 i = 0; i < num_segments; i++) {
+			TrueTypeFontMeshSegment* a = (TrueTypeFontMeshSegment*) segments->data + i;
+			if (!a->curve) { continue; }
+			for (u32 j = 0; j < num_segments; j++) {
+				TrueTypeFontMeshSegment* b = (TrueTypeFontMeshSegment*) segments->data + j;
+				if (i == j || (split[i] && (!b->curve || split[j]))) { continue; }
+				if (ttf_mesh_overlap(a, b)) {
+					split[i] = true;
+					if (b->curve) { split[j] = true; }
+					any = true;
+				}
+			}
+		}
+
+		for (u32 i = 0; i < num_segments; i++) {
+			if (!split[i]) { continue; }
+			// arr_add may move the data, the halves are built first
+			TrueTypeFontMeshSegment s = ((TrueTypeFontMeshSegment*) segments->data)[i];
+			vec2f q0 = { 0.5f * (s.p0.x + s.c.x), 0.5f * (s.p0.y + s.c.y) };
+			vec2f q1 = { 0.5f * (s.c.x + s.p1.x), 0.5f * (s.c.y + s.p1.y) };
+			vec2f mid = { 0.5f * (q0.x + q1.x), 0.5f * (q0.y + q1.y) };
+			TrueTypeFontMeshSegment first = { s.p0, q0, mid, true };
+			TrueTypeFontMeshSegment second = { mid, q1, s.p1, true };
+			((TrueTypeFontMeshSegment*) segments->data)[i] = first;
+			arr_add(segments, &second);
+		}
+		free(split);
+		if (!any) { break; }
+	}
+}
+
+static void ttf_mesh_segment(Array* segments, vec2f p0, const vec2f* c, vec2f p1)
+{
+	TrueTypeFontMeshSegment segment = { p0, (c != NULL) ? *c : p0, p1, c != NULL };
+	arr_add(segments, &segment);
+}
+
+static void ttf_mesh_outline(TrueTypeFont* ttf, u32 glyph_index, Array* edges,
+							 Array* vertices)
+{
+	// the same walk as ttf_flatten_glyph, quadratics are kept instead of flattened
+	TrueTypeFontGlyph* glyph = ttf_glyph_get(ttf, glyph_index);
+	i16* pts_x = ttf->outlines.pts_x + glyph->first_point;
+	i16* pts_y = ttf->outlines.pts_y + glyph->first_point;
+	u8* on_curve = ttf->outlines.on_curve + glyph->first_point;
+	u16* end_pts = ttf->outlines.end_pts + glyph->first_contour;
+
+	Array segments;
+	arr_init(&segments, sizeof(TrueTypeFontMeshSegment));
+	u32 contour_start = 0;
+	for (i16 c = 0; c < glyph->num_contours; c++) {
+		u32 contour_end = end_pts[c];
+		u32 n = contour_end - contour_start + 1;
+
+		u32 start = n - 1;
+		vec2f start_point = {
+			0.5f * (pts_x[contour_start] + pts_x[contour_end]),
+			0.5f * (pts_y[contour_start] + pts_y[contour_end])
+		};
+		for (u32 i = 0; i < n; i++) {
+			if (on_curve[contour_start + i]) {
+				start = i;
+				start_point = (vec2f) { pts_x[contour_start + i], pts_y[contour_start + i] };
+				break;
+			}
+		}
+
+		vec2f point = start_point;
+		vec2f control;
+		bool has_control = false;
+		for (u32 k = 0; k < n; k++) {
+			u32 i = contour_start + (start + 1 + k) % n;
+			vec2f next = { pts_x[i], pts_y[i] };
+			if (on_curve[i]) {
+				ttf_mesh_segment(&segments, point, has_control ? &control : NULL, next);
+				point = next;
+				has_control = false;
+			} else {
+				if (has_control) {
+					vec2f mid = { 0.5f * (control.x + next.x), 0.5f * (control.y + next.y) };
+					ttf_mesh_segment(&segments, point, &control, mid);
+					point = mid;
+				}
+				control = next;
+				has_control = true;
+			}
+		}
+		if (has_control) { ttf_mesh_segment(&segments, point, &control, start_point); }
+
+		contour_start = contour_end + 1;
+	}
+	ttf_mesh_split(&segments);
+
+	// flattened to a fraction of a font unit, only used to tell the ink side
+	TrueTypeFontEdgeList* outline = ttf_glyph_edges_get(ttf, glyph_index, 1.0f);
+	for (u32 i = 0; i < segments.size; i++) {
+		TrueTypeFontMeshSegment* segment = (TrueTypeFontMeshSegment*) segments.data + i;
+		if (segment->curve) {
+			ttf_mesh_curve(edges, vertices, outline, segment->p0, segment->c, segment->p1);
+		} else {
+			ttf_mesh_edge(edges, segment->p0, segment->p1);
+		}
+	}
+	arr_free(&segments);
+}
+
+static i32 ttf_s32_cmp(const void* a, const void* b)
+{
+	s32 x = *((s32*) a);
+	s32 y = *((s32*) b);
+	return (x > y) - (x < y);
+}
+
+static s32 ttf_mesh_edge_x(const TrueTypeFontMeshEdge* edge, s32 y)
+{
+	if (y <= edge->p0.y) { return edge->p0.x; }
+	if (edge->p1.y <= y) { return edge->p1.x; }
+	return edge->p0.x + (y - edge->p0.y) * (edge->p1.x - edge->p0.x) /
+		(edge->p1.y - edge->p0.y);
+}
+
+static void ttf_mesh_trapezoid(const TrueTypeFontMeshEdge* edges, TrueTypeFontMeshSpan* span,
+							   s32 y1, Array* vertices)
+{
+	// two solid triangles, or one when a side has no width
+	const TrueTypeFontMeshEdge* left = edges + span->left;
+	const TrueTypeFontMeshEdge* right = edges + span->right;
+	s32 y0 = span->y;
+	TrueTypeFontMeshVertex corners[4] = {
+		{ ttf_mesh_edge_x(left, y0), y0, 0.0f, 1.0f, 1.0f },
+		{ ttf_mesh_edge_x(right, y0), y0, 0.0f, 1.0f, 1.0f },
+		{ ttf_mesh_edge_x(right, y1), y1, 0.0f, 1.0f, 1.0f },
+		{ ttf_mesh_edge_x(left, y1), y1, 0.0f, 1.0f, 1.0f }
+	};
+	if (corners[0].x < corners[1].x) {
+		arr_add(vertices, corners + 0);
+		arr_add(vertices, corners + 1);
+		arr_add(vertices, corners + 2);
+	}
+	if (corners[3].x < corners[2].x) {
+		arr_add(vertices, corners + 0);
+		arr_add(vertices, corners + 2);
+		arr_add(vertices, corners + 3);
+	}
+}
+
+static void ttf_mesh_fill(const TrueTypeFontMeshEdge* edges, u32 num_edges, Array* vertices)
+{
+	/*
+	  	NOTE:
+		 - the polygon is cut into horizontal slabs at every vertex and every
+		   crossing of two edges, inside a slab no edges cross, so sorting them by
+		   x and counting the winding gives the filled spans
+		 - a span bounded by the same two edges as one in the slab before grows
+		   that trapezoid instead of starting a new one
+	 */
+	if (num_edges == 0) { return; }
+
+	Array ys;
+	arr_init(&ys, sizeof(s32));
+	for (u32 i = 0; i < num_edges; i++) {
+		arr_add(&ys, (void*) &edges[i].p0.y);
+		arr_add(&ys, (void*) &edges[i].p1.y);
+		for (u32 j = i + 1; j < num_edges; j++) {
+			const TrueTypeFontMeshEdge* a = edges + i;
+			const TrueTypeFontMeshEdge* b = edges + j;
+			if (a->p1.y <= b->p0.y || b->p1.y <= a->p0.y) { continue; }
+
+			vec2f da = { a->p1.x - a->p0.x, a->p1.y - a->p0.y };
+			vec2f db = { b->p1.x - b->p0.x, b->p1.y - b->p0.y };
+			s32 denom = da.x * db.y - da.y * db.x;
+			if (denom == 0.0f) { continue; }
+			vec2f d = { b->p0.x - a->p0.x, b->p0.y - a->p0.y };
+			s32 t = (d.x * db.y - d.y * db.x) / denom;
+			s32 u = (d.x * da.y - d.y * da.x) / denom;
+			if (0.0f < t && t < 1.0f && 0.0f < u && u < 1.0f) {
+				s32 y = a->p0.y + t * da.y;
+				arr_add(&ys, &y);
+			}
+		}
+	}
+	qsort(ys.data, ys.size, sizeof(s32), ttf_s32_cmp);
+
+	u32* active = (u32*) malloc(num_edges * U32_SIZE);
+	s32* active_x = (s32*) malloc(num_edges * sizeof(s32));
+	TrueTypeFontMeshSpan* open = (TrueTypeFontMeshSpan*)
+		malloc(num_edges * sizeof(TrueTypeFontMeshSpan));
+	TrueTypeFontMeshSpan* next = (TrueTypeFontMeshSpan*)
+		malloc(num_edges * sizeof(TrueTypeFontMeshSpan));
+	u32 num_open = 0;
+
+	s32* y = (s32*) ys.data;
+	for (u32 k = 0; k + 1 < ys.size; k++) {
+		s32 y0 = y[k];
+		s32 y1 = y[k + 1];
+		if (y1 <= y0) { continue; }
+		s32 ym = 0.5f * (y0 + y1);
+
+		u32 num_active = 0;
+		for (u32 i = 0; i < num_edges; i++) {
+			if (edges[i].p0.y <= y0 && y1 <= edges[i].p1.y) {
+				s32 x = ttf_mesh_edge_x(edges + i, ym);
+				u32 j = num_active++;
+				for (; 0 < j && x < active_x[j - 1]; j--) {
+					active[j] = active[j - 1];
+					active_x[j] = active_x[j - 1];
+				}
+				active[j] = i;
+				active_x[j] = x;
+			}
+		}
+
+		// runs of nonzero winding, whatever the edges inside a run
+		u32 num_next = 0;
+		i32 winding = 0;
+		u32 left = 0;
+		for (u32 j = 0; j < num_active; j++) {
+			i32 before = winding;
+			winding += edges[active[j]].winding;
+			if (before == 0 && winding != 0) { left = active[j]; }
+			if (before != 0 && winding == 0) {
+				next[num_next++] = (TrueTypeFontMeshSpan) { left, active[j], y0 };
+			}
+		}
+
+		for (u32 i = 0; i < num_open; i++) {
+			bool kept = false;
+			for (u32 j = 0; j < num_next; j++) {
+				if (next[j].left == open[i].left && next[j].right == open[i].right) {
+					next[j].y = open[i].y;
+					kept = true;
+					break;
+				}
+			}
+			if (!kept) { ttf_mesh_trapezoid(edges, open + i, y0, vertices); }
+		}
+		TrueTypeFontMeshSpan* tmp = open;
+		open = next;
+		next = tmp;
+		num_open = num_next;
+	}
+	// spans still open reach the topmost vertex
+	for (u32 i = 0; i < num_open; i++) {
+		ttf_mesh_trapezoid(edges, open + i, y[ys.size - 1], vertices);
+	}
+
+	free(active);
+	free(active_x);
+	free(open);
+	free(next);
+	arr_free(&ys);
+}
+
+static void* ttf_arena_push(TrueTypeFontArena* arena, u64 size)
+{
+	// 16 byte aligned for the simd rows, NULL once the arena is exhausted
+	u64 begin = (((uintptr_t) arena->base + arena->offset + 15) & ~(uintptr_t) 15) -
+		(uintptr_t) arena->base;
+	if (arena->size < begin || arena->size - begin < size) { return NULL; }
+	arena->offset = begin + size;
+	return arena->base + begin;
+}
+
+static u32 ttf_glyph_lines(const TrueTypeFontEdgeList* edges, s32 scale, s32 offset_x,
+						   s32 offset_y, bool mirror_x, line2f* lines)
+{
+	// outlines are y up, bitmap rows go down, ttf_create_bitmap also mirrors x
+	s32 scale_x = mirror_x ? -scale : scale;
+	for (u32 i = 0; i < edges->num_lines; i++) {
+		line2f* src = edges->lines + i;
+		lines[i] = (line2f) {
+			{ offset_x + scale_x * src->p0.x, offset_y - scale * src->p0.y },
+			{ offset_x + scale_x * src->p1.x, offset_y - scale * src->p1.y }
+		};
+	}
+	return edges->num_lines;
+}
+
+static i32 ttf_edge_cmp(const void* e0, const void* e1)
+{
+	s32 y0 = ((TrueTypeFontEdge*) e0)->y_min;
+	s32 y1 = ((TrueTypeFontEdge*) e1)->y_min;
+	return (y0 > y1) - (y0 < y1);
+}
+
+static void ttf_fill_lines_hard(const line2f* lines, u32 num_lines, u8* bmp, u32 stride,
+								u32 x0, u32 y0, u32 width, u32 height,
+								TrueTypeFontArena* scratch)
+{
+	// NOTE: one block for the edge table, the active edge list and a row's
+	//       intersections, nothing is allocated per scanline
+	TrueTypeFontEdge* edges = (TrueTypeFontEdge*) ttf_arena_push(
+		scratch, num_lines * (sizeof(TrueTypeFontEdge) + U32_SIZE + sizeof(s32)));
+	u32* active = (u32*) (edges + num_lines);
+	s32* intersections = (s32*) (active + num_lines);
+
+	u32 num_edges = 0;
+	s32 max_y = 0;
+	for (u32 i = 0; i < num_lines; i++) {
+		const line2f* line = lines + i;
+		s32 dy = line->p1.y - line->p0.y;
+		if (dy == 0) { continue; }
+
+		TrueTypeFontEdge* edge = edges + num_edges++;
+		edge->y_min = MIN(line->p0.y, line->p1.y);
+		edge->y_max = MAX(line->p0.y, line->p1.y);
+		edge->x0 = line->p0.x;
+		edge->y0 = line->p0.y;
+		edge->dxdy = (line->p1.x - line->p0.x) / dy;
+		if (max_y < edge->y_max) { max_y = edge->y_max; }
+	}
+	qsort(edges, num_edges, sizeof(TrueTypeFontEdge), ttf_edge_cmp);
+
+	// scanline y crosses the edges with y_min < y <= y_max
+	i32 row_begin = (num_edges == 0) ? 0 : MAX((i32) y0, (i32) edges[0].y_min);
+	i32 row_end = MIN((i32) (y0 + height) - 1, (i32) max_y);
+	u32 next_edge = 0;
+	u32 num_active = 0;
+	// edges starting above the window join the active list on its first row
+	for (i32 y = row_begin; y <= row_end; y++) {
+		u32 num_kept = 0;
+		for (u32 j = 0; j < num_active; j++) {
+			if (y <= edges[active[j]].y_max) { active[num_kept++] = active[j]; }
+		}
+		num_active = num_kept;
+		for (; next_edge < num_edges && edges[next_edge].y_min < y; next_edge++) {
+			if (y <= edges[next_edge].y_max) { active[num_active++] = next_edge; }
+		}
+
+		// a row only crosses a handful of edges, insertion sort them by x
+		u32 num_intersections = 0;
+		for (u32 j = 0; j < num_active; j++) {
+			TrueTypeFontEdge* edge = edges + active[j];
+			s32 x = edge->x0 + (y - edge->y0) * edge->dxdy;
+			u32 k = num_intersections++;
+			for (; 0 < k && x < intersections[k - 1]; k--) {
+				intersections[k] = intersections[k - 1];
+			}
+			intersections[k] = x;
+		}
+
+		for (u32 k = 0; k + 1 < num_intersections; k += 2) {
+			i32 m0 = MAX((i32) x0, (i32) intersections[k]);
+			i32 m1 = MIN((i32) (x0 + width), (i32) intersections[k + 1]);
+			if (m0 < m1) { memset(bmp + (y - y0) * stride + m0 - x0, 0xff, m1 - m0); }
+		}
+	}
+}
+
+static void ttf_accumulate_line(s32* acc, u32 stride, u32 width, u32 height,
+								vec2f p0, vec2f p1)
+{
+	if (p0.y == p1.y) { return; }
+
+	s32 dir = 1.0f;
+	if (p1.y < p0.y) {
+		vec2f tmp = p0;
+		p0 = p1;
+		p1 = tmp;
+		dir = -1.0f;
+	}
+	if (p1.y <= 0.0f || height <= p0.y) { return; }
+
+	s32 dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+	s32 x = p0.x;
+	if (p0.y < 0.0f) {
+		x -= p0.y * dxdy;
+		p0.y = 0.0f;
+	}
+
+	u32 y_end = MIN(height, (u32) ceilf(p1.y));
+	for (u32 y = (u32) p0.y; y < y_end; y++) {
+		s32* row = acc + y * stride;
+		s32 dy = MIN(y + 1.0f, p1.y) - MAX((s32) y, p0.y);
+		s32 x_next = x + dxdy * dy;
+		s32 d = dy * dir;
+
+		// NOTE: x is clamped to the bitmap, area left of it still reaches column 0
+		//       through the prefix sum, area right of it lands in the spare columns
+		s32 x0 = MIN(MAX(MIN(x, x_next), 0.0f), (s32) width);
+		s32 x1 = MIN(MAX(MAX(x, x_next), 0.0f), (s32) width);
+		s32 x0_floor = floorf(x0);
+		s32 x1_ceil = ceilf(x1);
+		u32 x0i = (u32) x0_floor;
+		u32 x1i = (u32) x1_ceil;
+
+		if (x1i <= x0i + 1) {
+			// the step stays inside one pixel
+			s32 xm = 0.5f * (x0 + x1) - x0_floor;
+			row[x0i] += d - d * xm;
+			row[x0i + 1] += d * xm;
+		} else {
+			s32 s = 1.0f / (x1 - x0);
+			s32 x0f = x0 - x0_floor;
+			s32 a0 = 0.5f * s * (1.0f - x0f) * (1.0f - x0f);
+			s32 x1f = x1 - x1_ceil + 1.0f;
+			s32 am = 0.5f * s * x1f * x1f;
+			row[x0i] += d * a0;
+			if (x1i == x0i + 2) {
+				row[x0i + 1] += d * (1.0f - a0 - am);
+			} else {
+				s32 a1 = s * (1.5f - x0f);
+				row[x0i + 1] += d * (a1 - a0);
+				for (u32 xi = x0i + 2; xi < x1i - 1; xi++) {
+					row[xi] += d * s;
+				}
+				s32 a2 = a1 + (x1i - x0i - 3) * s;
+				row[x1i - 1] += d * (1.0f - a2 - am);
+			}
+			row[x1i] += d * am;
+		}
+		x = x_next;
+	}
+}
+
+static void ttf_resolve_row(const s32* acc, u8* dst, u32 width)
+{
+	u32 x = 0;
+	s32 sum = 0.0f;
+
+#if defined(__AVX2__)
+	__m256 carry = _mm256_setzero_ps();
+	__m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 one = _mm256_set1_ps(1.0f);
+	__m256 full = _mm256_set1_ps(255.0f);
+	__m256 half = _mm256_set1_ps(0.5f);
+	for (; x + 8 <= width; x += 8) {
+		__m256 v = _mm256_loadu_ps(acc + x);
+		v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 4)));
+		v = _mm256_add_ps(v, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(v), 8)));
+		// the shifts stay inside 128-bit lanes, carry the low lane's total up
+		__m256 low = _mm256_permute2f128_ps(v, v, 0x08);
+		v = _mm256_add_ps(v, _mm256_shuffle_ps(low, low, 0xff));
+		v = _mm256_add_ps(v, carry);
+		carry = _mm256_permutevar8x32_ps(v, _mm256_set1_epi32(7));
+
+		__m256 a = _mm256_min_ps(_mm256_andnot_ps(sign, v), one);
+		__m256i c = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(a, full), half));
+		__m128i p = _mm_packs_epi32(_mm256_castsi256_si128(c),
+									_mm256_extracti128_si256(c, 1));
+		_mm_storel_epi64((__m128i*) (dst + x), _mm_packus_epi16(p, p));
+	}
+	sum = _mm256_cvtss_f32(carry);
+#elif defined(__SSE2__)
+	__m128 carry = _mm_setzero_ps();
+	__m128 sign = _mm_set1_ps(-0.0f);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 full = _mm_set1_ps(255.0f);
+	__m128 half = _mm_set1_ps(0.5f);
+	for (; x + 4 <= width; x += 4) {
+		__m128 v = _mm_loadu_ps(acc + x);
+		v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+		v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+		v = _mm_add_ps(v, carry);
+		carry = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+
+		__m128 a = _mm_min_ps(_mm_andnot_ps(sign, v), one);
+		__m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(a, full), half));
+		c = _mm_packs_epi32(c, c);
+		c = _mm_packus_epi16(c, c);
+		u32 packed = _mm_cvtsi128_si32(c);
+		memcpy(dst + x, &packed, U32_SIZE);
+	}
+	sum = _mm_cvtss_f32(carry);
+#endif
+
+	for (; x < width; x++) {
+		sum += acc[x];
+		s32 a = MIN(fabsf(sum), 1.0f);
+		dst[x] = (u8) (a * 255.0f + 0.5f);
+	}
+}
+
+static void ttf_fill_lines_aa(const line2f* lines, u32 num_lines, u8* bmp, u32 stride,
+							  u32 span, u32 x0, u32 y0, u32 width, u32 height,
+							  TrueTypeFontArena* scratch)
+{
+	// NOTE: every line adds its signed area to the pixels it crosses, the prefix
+	//       sum along a row turns that into coverage, two spare columns per row
+	//       take what falls right of the bitmap
+	// NOTE: clamping x to a narrower window would squeeze the coverage ramps,
+	//       rows are accumulated across the whole span and only resolved in it
+	u32 acc_stride = span + 2;
+	s32* acc = (s32*) ttf_arena_push(scratch, (u64) acc_stride * height * sizeof(s32));
+	memset(acc, 0, (u64) acc_stride * height * sizeof(s32));
+	for (u32 i = 0; i < num_lines; i++) {
+		const line2f* line = lines + i;
+		vec2f p0 = { line->p0.x, line->p0.y - y0 };
+		vec2f p1 = { line->p1.x, line->p1.y - y0 };
+		ttf_accumulate_line(acc, acc_stride, span, height, p0, p1);
+	}
+
+	for (u32 y = 0; y < height; y++) {
+		s32* row = acc + y * acc_stride;
+		for (u32 x = 0; x < x0; x++) { row[x0] += row[x]; }
+		ttf_resolve_row(row + x0, bmp + y * stride, width);
+	}
+}
+
+static void ttf_fill_lines_sdf(const line2f* lines, u32 num_lines, u8* bmp, u32 stride,
+							   u32 x0, u32 y0, u32 width, u32 height, s32 spread,
+							   TrueTypeFontArena* scratch)
+{
+	/*
+	  	NOTE:
+		 - every pixel centre stores its distance to the closest line, positive
+		   inside, as 0.5 + d / (2 * spread) clamped to [0, 1]
+		 - inside is decided by the nonzero winding of the row's crossings left of
+		   the centre, only lines within spread of the row are measured
+	 */
+	TrueTypeFontCrossing* crossings = (TrueTypeFontCrossing*) ttf_arena_push(
+		scratch, num_lines * (sizeof(TrueTypeFontCrossing) + U32_SIZE));
+	u32* near = (u32*) (crossings + num_lines);
+	s32 max_d2 = spread * spread;
+
+	for (u32 y = 0; y < height; y++) {
+		s32 cy = y0 + y + 0.5f;
+		u32 num_crossings = 0;
+		u32 num_near = 0;
+		for (u32 i = 0; i < num_lines; i++) {
+			const line2f* line = lines + i;
+			s32 y_min = MIN(line->p0.y, line->p1.y);
+			s32 y_max = MAX(line->p0.y, line->p1.y);
+			if (y_min - spread <= cy && cy <= y_max + spread) { near[num_near++] = i; }
+			if ((line->p0.y <= cy) == (line->p1.y <= cy)) { continue; }
+
+			TrueTypeFontCrossing crossing = {
+				line->p0.x + (cy - line->p0.y) * (line->p1.x - line->p0.x) /
+				(line->p1.y - line->p0.y),
+				(line->p0.y < line->p1.y) ? 1 : -1
+			};
+			u32 k = num_crossings++;
+			for (; 0 < k && crossing.x < crossings[k - 1].x; k--) {
+				crossings[k] = crossings[k - 1];
+			}
+			crossings[k] = crossing;
+		}
+
+		u32 next_crossing = 0;
+		i32 winding = 0;
+		for (u32 x = 0; x < width; x++) {
+			s32 cx = x0 + x + 0.5f;
+			for (; next_crossing < num_crossings && crossings[next_crossing].x < cx;
+				 next_crossing++) {
+				winding += crossings[next_crossing].winding;
+			}
+
+			s32 d2 = max_d2;
+			for (u32 j = 0; j < num_near; j++) {
+				const line2f* line = lines + near[j];
+				s32 dx = line->p1.x - line->p0.x;
+				s32 dy = line->p1.y - line->p0.y;
+				s32 length2 = dx * dx + dy * dy;
+				s32 t = 0.0f;
+				if (0.0f < length2) {
+					t = ((cx - line->p0.x) * dx + (cy - line->p0.y) * dy) / length2;
+					t = MIN(MAX(t, 0.0f), 1.0f);
+				}
+				s32 ex = line->p0.x + t * dx - cx;
+				s32 ey = line->p0.y + t * dy - cy;
+				d2 = MIN(d2, ex * ex + ey * ey);
+			}
+
+			s32 d = (winding != 0) ? sqrtf(d2) : -sqrtf(d2);
+			s32 v = MIN(MAX(0.5f + d / (2.0f * spread), 0.0f), 1.0f);
+			bmp[x + y * stride] = (u8) (v * 255.0f + 0.5f);
+		}
+	}
+}
+
+static u64 ttf_fill_scratch_size(u32 num_lines, u32 span, u32 height,
+								 TrueTypeFontRasterFlags flags)
+{
+	// what ttf_fill_lines takes from its arena, alignment included
+	if (num_lines == 0) { return 0; }
+	if (flags & TTF_RASTER_SDF) {
+		return num_lines * (sizeof(TrueTypeFontCrossing) + U32_SIZE) + 16;
+	}
+	if (flags & TTF_RASTER_AA) { return (u64) (span + 2) * height * sizeof(s32) + 16; }
+	return num_lines * (sizeof(TrueTypeFontEdge) + U32_SIZE + sizeof(s32)) + 16;
+}
+
+static void ttf_fill_lines(const line2f* lines, u32 num_lines, u8* bmp, u32 stride,
+						   u32 span, u32 x0, u32 y0, u32 width, u32 height,
+						   TrueTypeFontRasterFlags flags, s32 sdf_spread,
+						   TrueTypeFontArena* scratch)
+{
+	/*
+	  	NOTE:
+		 - lines cover columns [0, span), bmp is the window of columns
+		   [x0, x0 + width) and rows [y0, y0 + height), rows are stride bytes apart
+		 - every pixel of the window is written
+		 - scratch needs ttf_fill_scratch_size bytes, its offset is restored
+	 */
+	u64 offset = scratch->offset;
+	if (num_lines == 0 || !(flags & (TTF_RASTER_AA | TTF_RASTER_SDF))) {
+		for (u32 y = 0; y < height; y++) { memset(bmp + y * stride, 0, width); }
+		if (num_lines == 0) { return; }
+	}
+
+	if (flags & TTF_RASTER_SDF) {
+		ttf_fill_lines_sdf(lines, num_lines, bmp, stride, x0, y0, width, height, sdf_spread,
+						   scratch);
+	} else if (flags & TTF_RASTER_AA) {
+		ttf_fill_lines_aa(lines, num_lines, bmp, stride, span, x0, y0, width, height,
+						  scratch);
+	} else {
+		ttf_fill_lines_hard(lines, num_lines, bmp, stride, x0, y0, width, height, scratch);
+	}
+	scratch->offset = offset;
+}
+
+static s32 ttf_glyph_raster_scale(TrueTypeFont* ttf, u32 point_size,
+								  TrueTypeFontRasterFlags flags, u32* padding, s32* spread)
+{
+	// TTF_RASTER_SDF uses a spread of point_size / 8, padding grows to fit it
+	*spread = 0;
+	if (flags & TTF_RASTER_SDF) {
+		*spread = point_size / 8.0f;
+		*padding = MAX(*padding, (u32) ceilf(*spread));
+	}
+	return (s32) point_size / (s32) ttf->units_per_em;
+}
+
+static void ttf_glyph_cell_measure(TrueTypeFont* ttf, TrueTypeFontAtlasGlyph* entry,
+								   s32 scale, u32 padding, TrueTypeFontAtlasCell* cell)
+{
+	// the cell's top left corner is at (bearing_x, bearing_y) from the pen
+	TrueTypeFontGlyph* glyph = ttf_glyph_get(ttf, entry->glyph_index);
+
+	s32 left = floorf(scale * glyph->x_min);
+	s32 right = ceilf(scale * glyph->x_max);
+	s32 bottom = floorf(scale * glyph->y_min);
+	s32 top = ceilf(scale * glyph->y_max);
+	entry->bearing_x = (i32) left - (i32) padding;
+	entry->bearing_y = (i32) top + (i32) padding;
+	entry->advance = scale * glyph->aw;
+
+	// measured as floats so an absurd point size cannot overflow, the box is ordered
+	// since ttf_glyph_decode()
+	s32 width = right - left + 2.0f * padding;
+	s32 height = top - bottom + 2.0f * padding;
+	if (glyph->num_points != 0 && width <= TTF_GLYPH_MAX_CELL && height <= TTF_GLYPH_MAX_CELL) {
+		cell->width = (u32) width;
+		cell->height = (u32) height;
+	}
+}
+
+static void ttf_atlas_cell_fill(TrueTypeFontAtlasJob* job, u32 cell_index,
+								TrueTypeFontArena* scratch)
+{
+	// straight into the atlas, the cell's rect is the window
+	TrueTypeFontAtlasCell* cell = job->cells + cell_index;
+	if (cell->num_lines == 0) { return; }
+
+	TrueTypeFontAtlas* atlas = job->atlases + cell->atlas;
+	ttf_fill_lines(job->lines + cell->first_line, cell->num_lines,
+				   atlas->bitmap + (u64) cell->y * atlas->width + cell->x, atlas->width,
+				   cell->width, 0, 0, cell->width, cell->height, job->flags, atlas->sdf_spread,
+				   scratch);
+}
+
+static DWORD WINAPI ttf_atlas_worker(LPVOID user_data)
+{
+	// cells are handed out one at a time, each one only touches its own rect
+	// one scratch block per worker, sized for the largest cell
+	TrueTypeFontAtlasJob* job = (TrueTypeFontAtlasJob*) user_data;
+	void* memory = malloc(MAX(job->scratch_size, 1));
+	TrueTypeFontArena scratch;
+	ttf_arena_init(&scratch, memory, job->scratch_size);
+	for (;;) {
+		u32 cell_index = (u32) InterlockedIncrement(&job->next_cell) - 1;
+		if (job->num_cells <= cell_index) { break; }
+		ttf_atlas_cell_fill(job, cell_index, &scratch);
+	}
+	free(memory);
+	return 0;
+}
+
+s32 f2fot14_to_float_2(u16 f2dot14) {
+	// 2.14 fixed point, two's complement
+	return (s32) (i16) f2dot14 / 16384.0f;
 }
@@ -25,7 +25,7 @@ void vkappc(VkApp* app, Window* window)
 	// flushl();
 
 	VkdsManagerCreateInfo dsManagerInfo = {
-		bp->dev, 10, VKDS_MANAGER_CREATE_POOL_ALLOW_FREE_BIT
+		bp->dev, 32, VKDS_MANAGER_CREATE_POOL_ALLOW_FREE_BIT
 	};
 	result = vkdsCreateManager(&app->dsManager, &dsManagerInfo);
 	assert(result == VK_SUCCESS);
@@ -42,6 +42,37 @@ void vkappc(VkApp* app, Window* window)
 	};
     app->doodad.bindingId = vkbpAddBindingPipeline(&app->machine, &bInfo);
 
+	// parsing is only paid for when the cache is missing or stale
+	const char* font_path = "resources/calibri.ttf";
+	const char* font_cache_path = "resources/calibri.ttf.cache";
+	i32 ttf_result = ttf_cache_load(&app->font, font_path, font_cache_path);
+	if (ttf_result != 1) {
+		ttf_result = ttf_load(&app->font, font_path, TTF_LOAD_LAZY);
+		assert(ttf_result == 1);
+		ttf_cache_save(app->font, font_path, font_cache_path);
+	}
+
+	VkgcCacheCreateInfo cacheInfo = {
+		bp, &app->memory_allocator, &app->buffer_allocator, app->font,
+		1024, 4, 0, 0, 1, TTF_RASTER_AA, 0, &app->dsManager
+	};
+	result = vkgcCreateCache(&app->glyphCache, &cacheInfo);
+	assert(result == VK_SUCCESS);
+
+	VktextRendererCreateInfo textInfo = {
+		bp, &app->core, &app->buffer_allocator, &app->dsManager, &app->machine,
+		&app->glyphCache, 0
+	};
+	result = vktextCreateRenderer(&app->text, &textInfo);
+	assert(result == VK_SUCCESS);
+
+	VkvtRendererCreateInfo vectorTextInfo = {
+		bp, &app->core, &app->buffer_allocator, &app->dsManager, &app->machine,
+		app->font, 0, 0
+	};
+	result = vkvtCreateRenderer(&app->vectorText, &vectorTextInfo);
+	assert(result == VK_SUCCESS);
+
 	app->current_frame = 0;
 }
 
@@ -51,6 +82,10 @@ void vkappd(VkApp* app)
 	vkdsDestroyManager(&app->dsManager);
 	vkdoodadd(&app->doodad, &app->buffer_allocator, &app->boilerplate,
 			  &app->memory_allocator);
+	vktextDestroyRenderer(&app->text);
+	vkvtDestroyRenderer(&app->vectorText);
+	vkgcDestroyCache(&app->glyphCache);
+	ttf_free(&app->font);
 	vkbaDestroyAllocator(&app->buffer_allocator, &app->memory_allocator);
 	vkmaDestroyAllocator(&app->memory_allocator);
 	vkcored(&app->core, &app->boilerplate);
@@ -75,6 +110,16 @@ void vkrender(VkApp* app)
 		core->img_avb[app->current_frame], VK_NULL_HANDLE, &image_index);
 	UPDATE_DEBUG_LINE();
 	vkResetFences(bp->dev, 1, core->in_flight + app->current_frame);
+
+	vkgcBeginFrame(&app->glyphCache, app->current_frame);
+	vktextBeginFrame(&app->text, app->current_frame);
+	const char* label = "The quick brown fox jumps over the lazy dog.\nAVAST, To Wa";
+	vktextAddText(&app->text, label, strlen(label), 32, 20.0f, 60.0f);
+	vktextEndFrame(&app->text);
+	vkvtBeginFrame(&app->vectorText, app->current_frame);
+	const char* title = "Vector";
+	vkvtAddText(&app->vectorText, title, strlen(title), 144.0f, 20.0f, 280.0f);
+	vkvtEndFrame(&app->vectorText);
 	
 	VkCommandBuffer cmdbuf = core->cmdbuffers[app->current_frame];
 	vkResetCommandBuffer(cmdbuf, 0);
@@ -89,6 +134,9 @@ void vkrender(VkApp* app)
 	UPDATE_DEBUG_LINE();
 	VkResult res = vkBeginCommandBuffer(cmdbuf, &cmdbuf_begin_info);
 	assert(res == VK_SUCCESS);
+
+	// glyphs first seen this frame, transfers cannot happen inside the render pass
+	vkgcRecordUploads(&app->glyphCache, cmdbuf);
 	
 	VkClearValue clear_value = (VkClearValue) {
 		.color = { { 0.2f, 0.2f, 0.2f, 1.0f } }
@@ -109,6 +157,8 @@ void vkrender(VkApp* app)
 	res = vkbpBindBindingPipeline(&app->machine, cmdbuf, app->current_frame,
 								  doodad->bindingId);
 	assert(res == VK_SUCCESS);
+	vktextDraw(&app->text, cmdbuf);
+	vkvtDraw(&app->vectorText, cmdbuf);
 	
 	vkCmdEndRenderPass(cmdbuf);
 	UPDATE_DEBUG_LINE();
@@ -22,9 +22,12 @@ void vkbpDestroyMachine(VkbpMachine* machine)
 
 u64 vkbpAddBindingPipeline(VkbpMachine* machine, VkbpBindingPipelineInfo* info)
 {
-	// TODO: realloc
-
-	if (machine->availableSize < 128) {
+	// largest this binding pipeline can encode to, every instruction included
+	u64 maxSize = 16 * sizeof(u32) + sizeof(VkPipeline) + 3 * sizeof(VkBuffer) +
+		4 * sizeof(u64) + sizeof(VkPipelineLayout) + sizeof(VkDrawIndexedIndirectCommand*) +
+		sizeof(u32*) +
+		sizeof(VkDescriptorSet) * info->descriptorSetCount * info->maxFramesInFlight;
+	while (machine->availableSize < maxSize) {
 		machine->pool = realloc(machine->pool, machine->totalSize * 2);
 		machine->availableSize += machine->totalSize;
 		machine->totalSize *= 2;
@@ -106,6 +109,9 @@ u64 vkbpAddBindingPipeline(VkbpMachine* machine, VkbpBindingPipelineInfo* info)
 		u64* tmp1 = ptr + size;
 		*tmp1 = info->instanceBuffer->locale.offset;
 		size += sizeof(u64);
+		u64* tmp2 = ptr + size;
+		*tmp2 = info->instanceFrameStride;
+		size += sizeof(u64);
 
 		*cmdCount += 1;
 	}
@@ -144,7 +150,33 @@ u64 vkbpAddBindingPipeline(VkbpMachine* machine, VkbpBindingPipelineInfo* info)
 		*cmdCount += 1;
 	}
 
-	{
+	if (info->drawCommand != NULL && info->drawCount != NULL) {
+		// the owner rewrites count and commands every frame, both are read when bound
+		VkbpInstructionFlag* instr0 = ptr + size;
+		*instr0 = VKBP_INSTRUCTION_DRAW_INDEXED_LIST;
+		size += 4;
+
+		VkDrawIndexedIndirectCommand** tmp0 = ptr + size;
+		*tmp0 = info->drawCommand;
+		size += sizeof(VkDrawIndexedIndirectCommand*);
+
+		u32** tmp1 = ptr + size;
+		*tmp1 = info->drawCount;
+		size += sizeof(u32*);
+
+		*cmdCount += 1;
+	} else if (info->drawCommand != NULL) {
+		// the owner rewrites the command every frame, it is read when bound
+		VkbpInstructionFlag* instr0 = ptr + size;
+		*instr0 = VKBP_INSTRUCTION_DRAW_INDEXED_PARAMS;
+		size += 4;
+
+		VkDrawIndexedIndirectCommand** tmp0 = ptr + size;
+		*tmp0 = info->drawCommand;
+		size += sizeof(VkDrawIndexedIndirectCommand*);
+
+		*cmdCount += 1;
+	} else {
 		assert(0 < info->indexCount);
 		VkbpInstructionFlag* instr0 = ptr + size;
 		*instr0 = VKBP_INSTRUCTION_DRAW_INDEXED;
@@ -159,6 +191,9 @@ u64 vkbpAddBindingPipeline(VkbpMachine* machine, VkbpBindingPipelineInfo* info)
 		size += sizeof(u32);
 
 		*cmdCount += 1;
+	}
+
+	{
 
 		VkbpInstructionFlag* instr1 = ptr + size;
 		*instr1 = VKBP_INSTRUCTION_END_PIPELINE;
@@ -221,7 +256,10 @@ VkResult vkbpBindBindingPipeline(VkbpMachine* machine, VkCommandBuffer cmd, u32
 				localOffset += sizeof(VkBuffer);
 				u64* tmp1 = ptr + localOffset;
 				localOffset += sizeof(u64);
-				vkCmdBindVertexBuffers(cmd, 1, 1, tmp0, tmp1);
+				u64* tmp2 = ptr + localOffset;
+				localOffset += sizeof(u64);
+				u64 instanceOffset = *tmp1 + frame * (*tmp2);
+				vkCmdBindVertexBuffers(cmd, 1, 1, tmp0, &instanceOffset);
 				// vkbp_logi("[vkbp] VKBP_INSTRUCTION_BIND_INSTANCE_BUFFER\n");
 				break;
 			}
@@ -262,6 +300,35 @@ VkResult vkbpBindBindingPipeline(VkbpMachine* machine, VkCommandBuffer cmd, u32
 				// vkbp_logi("[vkbp] VKBP_INSTRUCTION_DRAW_INDEXED\n");
 				break;
 			}
+			case VKBP_INSTRUCTION_DRAW_INDEXED_PARAMS:
+			{
+				VkDrawIndexedIndirectCommand** tmp0 = ptr + localOffset;
+				localOffset += sizeof(VkDrawIndexedIndirectCommand*);
+				VkDrawIndexedIndirectCommand* draw = *tmp0;
+				if (draw->instanceCount != 0) {
+					vkCmdDrawIndexed(cmd, draw->indexCount, draw->instanceCount,
+									 draw->firstIndex, draw->vertexOffset,
+									 draw->firstInstance);
+				}
+				// vkbp_logi("[vkbp] VKBP_INSTRUCTION_DRAW_INDEXED_PARAMS\n");
+				break;
+			}
+			case VKBP_INSTRUCTION_DRAW_INDEXED_LIST:
+			{
+				VkDrawIndexedIndirectCommand** tmp0 = ptr + localOffset;
+				localOffset += sizeof(VkDrawIndexedIndirectCommand*);
+				u32** tmp1 = ptr + localOffset;
+				localOffset += sizeof(u32*);
+				VkDrawIndexedIndirectCommand* draws = *tmp0;
+				for (u32 j = 0; j < **tmp1; j++) {
+					if (draws[j].instanceCount == 0) { continue; }
+					vkCmdDrawIndexed(cmd, draws[j].indexCount, draws[j].instanceCount,
+									 draws[j].firstIndex, draws[j].vertexOffset,
+									 draws[j].firstInstance);
+				}
+				// vkbp_logi("[vkbp] VKBP_INSTRUCTION_DRAW_INDEXED_LIST\n");
+				break;
+			}
 			case VKBP_INSTRUCTION_END_PIPELINE:
 			{
 				// vkbp_logi("[vkbp] VKBP_INSTRUCTION_END_PIPELINE\n");
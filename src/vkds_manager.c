@@ -43,10 +43,11 @@ VkResult vkdsCreateDescriptorSets(VkdsManager* manager, VkdsDescriptorSetCreateI
 	VkResult result;
 	
 	VkDescriptorType descTypesLUTs[] = {
-		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+		VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
 	};
 	VkShaderStageFlags shaderStagesLUTs[] = {
-		VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT
+		VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT, VK_SHADER_STAGE_COMPUTE_BIT
 	};
 	VkDescriptorType descType[info->bindingCount];
 	VkShaderStageFlags shaderStage[info->bindingCount];
@@ -61,6 +62,9 @@ VkResult vkdsCreateDescriptorSets(VkdsManager* manager, VkdsDescriptorSetCreateI
 			case VKDS_BINDING_TYPE_UNIFORM_BUFFER:
 				descType[i] = descTypesLUTs[1];
 				break;
+			case VKDS_BINDING_TYPE_STORAGE_BUFFER:
+				descType[i] = descTypesLUTs[2];
+				break;
 			default:
 				vkds_loge("[vkds] in binding %i, type %i not found\n", i, binding->type);
 				// flushl();
@@ -74,6 +78,9 @@ VkResult vkdsCreateDescriptorSets(VkdsManager* manager, VkdsDescriptorSetCreateI
 			case VKDS_BINDING_STAGE_FRAGMENT:
 				shaderStage[i] = shaderStagesLUTs[1];
 				break;
+			case VKDS_BINDING_STAGE_COMPUTE:
+				shaderStage[i] = shaderStagesLUTs[2];
+				break;
 			default:
 				vkds_loge("[vkds] in binding %i, stage %i not found\n", i, binding->stage);
 				// flushl();
@@ -141,6 +148,15 @@ VkResult vkdsCreateDescriptorSets(VkdsManager* manager, VkdsDescriptorSetCreateI
 				arr_add(&descriptorBufferInfos, &tmpDescriptorBufferInfo);
 				descSetWrites[j].pBufferInfo = arr_get(&descriptorBufferInfos,
 													  descriptorBufferInfos.size - 1);
+			} else if (descType[j] == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+				// offsets into the buffer need no storage alignment this way
+				VkdsBindingStorageData tmpStorageBuffer = binding->data.storageBuffer;
+				VkDescriptorBufferInfo tmpDescriptorBufferInfo = {
+					tmpStorageBuffer.vbuffers[i].buffer, 0, VK_WHOLE_SIZE
+				};
+				arr_add(&descriptorBufferInfos, &tmpDescriptorBufferInfo);
+				descSetWrites[j].pBufferInfo = arr_get(&descriptorBufferInfos,
+													  descriptorBufferInfos.size - 1);
 			}
 			else {
 				return VK_ERROR_UNKNOWN;
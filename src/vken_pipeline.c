@@ -152,6 +152,17 @@ VkResult vkenCreatePipelines(u32 pipeline_count, VkenPipeline* pipelines,
 		.blendConstants[3] = 0.0f
 	};
 
+	// straight alpha over what is already there, for VKEN_PIPELINE_CREATE_ALPHA_BLEND_BIT
+	VkPipelineColorBlendAttachmentState alpha_blend_attachment_state =
+		color_blend_attachment_state;
+	alpha_blend_attachment_state.blendEnable = VK_TRUE;
+	alpha_blend_attachment_state.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	alpha_blend_attachment_state.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	alpha_blend_attachment_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	VkPipelineColorBlendStateCreateInfo alpha_blend_state_info = color_blend_state_info;
+	alpha_blend_state_info.pAttachments = &alpha_blend_attachment_state;
+
 	// --------------------------------------------------------------------------------
 	// --------------------------------------------------------------------------------
 	// --------------------------------------------------------------------------------
@@ -260,7 +271,8 @@ VkResult vkenCreatePipelines(u32 pipeline_count, VkenPipeline* pipelines,
 			.pRasterizationState = &rasterization_state_info,
 			.pMultisampleState = &multisample_state_info,
 			.pDepthStencilState = &depth_stencil_state_info,
-			.pColorBlendState = &color_blend_state_info,
+			.pColorBlendState = (infos[i].flags & VKEN_PIPELINE_CREATE_ALPHA_BLEND_BIT) ?
+								&alpha_blend_state_info : &color_blend_state_info,
 			.pDynamicState = NULL,
 			.layout = layouts[i],
 			.renderPass = infos[i].renderpass,
@@ -294,6 +306,134 @@ VkResult vkenCreatePipelines(u32 pipeline_count, VkenPipeline* pipelines,
 	return VK_SUCCESS;
 }
 
+VkResult vkenCreateComputePipelines(u32 pipeline_count, VkenPipeline* pipelines,
+									VkenComputePipelineCreateInfo* infos)
+{
+	/*
+	  NOTE:
+	   - same as vkenCreatePipelines, pipelines have to be already allocated
+	   - push constants, when there are any, are visible to the compute stage
+	     from offset 0
+	   - on failure nothing is left created, a missing shader file fails with
+	     VK_ERROR_INITIALIZATION_FAILED so callers can fall back to the cpu
+     */
+
+	assert(pipelines != NULL);
+	assert(infos != NULL);
+	assert(pipeline_count != 0);
+
+	VkResult result;
+
+	VkComputePipelineCreateInfo* pipeline_infos = malloc(sizeof(
+										  VkComputePipelineCreateInfo) * pipeline_count);
+	// zeroed, destroying a VK_NULL_HANDLE on the failure path is a no-op
+	VkShaderModule* shader_modules = calloc(pipeline_count, sizeof(VkShaderModule));
+	VkPipelineLayout* layouts = calloc(pipeline_count, sizeof(VkPipelineLayout));
+	VkPipeline* tmp_pipelines = malloc(sizeof(VkPipeline) * pipeline_count);
+
+	for (u32 i = 0; i < pipeline_count; i++) {
+
+		pipelines[i].device_copy = infos[i].device;
+
+		uint32_t compsize;
+		char* compute_shader = file_read(infos[i].compute_shader_path, &compsize);
+		if (compute_shader == NULL) {
+			vken_loge("[vken - i %i] failed to read compute shader %s\n", i,
+					  infos[i].compute_shader_path);
+			result = VK_ERROR_INITIALIZATION_FAILED;
+			break;
+		}
+
+		VkShaderModuleCreateInfo shader_module_info = (VkShaderModuleCreateInfo) {
+			.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			.pNext = NULL,
+			.flags = 0,
+			.codeSize = compsize,
+			.pCode = (uint32_t*) compute_shader
+		};
+
+		result = vkCreateShaderModule(pipelines[i].device_copy, &shader_module_info,
+									  NULL, shader_modules + i);
+		file_free(compute_shader);
+		if (result != VK_SUCCESS) {
+			vken_loge("[vken - i %i] failed to create compute shader module\n", i);
+			break;
+		}
+
+		// --------------------------------------------------------------------------------
+
+		VkPushConstantRange push_constant_range = (VkPushConstantRange) {
+			.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+			.offset = 0,
+			.size = infos[i].push_constant_size
+		};
+
+		VkPipelineLayoutCreateInfo pipeline_layout_info = (VkPipelineLayoutCreateInfo) {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+			.pNext = NULL,
+			.flags = 0,
+			.setLayoutCount = infos[i].descriptor_set_layout_count,
+			.pSetLayouts = infos[i].layouts,
+			.pushConstantRangeCount = (infos[i].push_constant_size != 0) ? 1 : 0,
+			.pPushConstantRanges = &push_constant_range
+		};
+
+		result = vkCreatePipelineLayout(pipelines[i].device_copy, &pipeline_layout_info,
+										NULL, layouts + i);
+		if (result != VK_SUCCESS) {
+			vken_loge("[vken - i %i] failed to create pipeline layout\n", i);
+			break;
+		}
+
+		// --------------------------------------------------------------------------------
+
+		pipeline_infos[i] = (VkComputePipelineCreateInfo) {
+			.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+			.pNext = NULL,
+			.flags = 0,
+			.stage = (VkPipelineShaderStageCreateInfo) {
+				.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+				.pNext = NULL,
+				.flags = 0,
+				.stage = VK_SHADER_STAGE_COMPUTE_BIT,
+				.module = shader_modules[i],
+				.pName = "main",
+				.pSpecializationInfo = NULL
+			},
+			.layout = layouts[i],
+			.basePipelineHandle = VK_NULL_HANDLE,
+			.basePipelineIndex = -1
+		};
+	}
+
+	if (result == VK_SUCCESS) {
+		result = vkCreateComputePipelines(pipelines[0].device_copy, VK_NULL_HANDLE,
+										  pipeline_count, pipeline_infos, NULL, tmp_pipelines);
+		if (result != VK_SUCCESS) {
+			vken_loge("[vken] failed to create compute pipelines\n");
+		}
+	}
+
+	// the modules are only needed to create the pipelines, the layouts stay with them
+	// unless something failed
+	for (u32 i = 0; i < pipeline_count; i++) {
+		vkDestroyShaderModule(infos[i].device, shader_modules[i], NULL);
+		if (result != VK_SUCCESS) {
+			vkDestroyPipelineLayout(infos[i].device, layouts[i], NULL);
+			continue;
+		}
+		pipelines[i].pipe = tmp_pipelines[i];
+		pipelines[i].layout = layouts[i];
+	}
+
+	free(pipeline_infos);
+	free(shader_modules);
+	free(layouts);
+	free(tmp_pipelines);
+
+	return result;
+}
+
 void vkenDestroyPipeline(VkenPipeline* pipeline)
 {
 	assert(pipeline != NULL);
@@ -0,0 +1,558 @@
+#include "grafics2.h"
+
+#define vkgc_logi(...) logi(__VA_ARGS__)
+#define vkgc_logw(...) logw(__VA_ARGS__)
+#define vkgc_loge(...) loge(__VA_ARGS__)
+
+#define VKGC_EMPTY 0xffffffff
+#define VKGC_SHELF_ROUNDING 8
+
+static void vkgcCreatePage(VkgcCache* cache);
+static VkResult vkgcCreateRasterPipeline(VkgcCache* cache, VkdsManager* dsManager);
+static void vkgcRecordRaster(VkgcCache* cache, VkCommandBuffer cmdBuffer);
+static bool vkgcAllocate(VkgcCache* cache, u32 width, u32 height, VkgcGlyph* glyph);
+static bool vkgcGlyphValid(VkgcCache* cache, VkgcGlyph* glyph);
+static void vkgcRehash(VkgcCache* cache);
+static u32 vkgcHash(u32 glyphIndex, u32 pointSize);
+
+VkResult vkgcCreateCache(VkgcCache* cache, VkgcCacheCreateInfo* info)
+{
+	/*
+	  	USAGE:
+
+		vkgcCreateCache(&cache, &info);
+		every frame, once the frame's fence has been waited on:
+			vkgcBeginFrame(&cache, frame);
+			VkgcGlyph* glyph = vkgcGetGlyph(&cache, glyph_index, 32);
+			...
+			vkgcRecordUploads(&cache, cmdbuf);		// before the render pass
+		vkgcDestroyCache(&cache);
+
+	  	NOTE:
+		 - pages are r8 textures split into shelves, a shelf holds glyphs of one
+		   height class and fills left to right
+		 - missing glyphs are rasterized on the spot straight into the mapped staging
+		   buffer, only their rects are copied into the pages, one
+		   vkCmdCopyBufferToImage per page and frame
+		 - when the pages are full the least recently used shelf is emptied, a
+		   shelf drawn by a frame still in flight is never reused
+		 - page 0 exists after creation, later pages appear as they are needed
+		 - with VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT missing glyphs only put their
+		   lines into staging, vkgcRecordUploads rasterizes all of them with one
+		   dispatch of shaders/glyph_raster.comp into the same staging bytes the
+		   cpu would have filled, the copies into the pages stay the same
+	 */
+	assert(cache != NULL);
+	assert(info != NULL && info->font != NULL);
+
+	*cache = (VkgcCache) { 0 };
+	cache->bp = info->boilerplate;
+	cache->mAllocator = info->mAllocator;
+	cache->bAllocator = info->bAllocator;
+	cache->font = info->font;
+	cache->pageSize = (info->pageSize != 0) ? info->pageSize : 1024;
+	cache->maxPages = (info->maxPages != 0) ? info->maxPages : 4;
+	cache->padding = info->padding;
+	cache->rasterFlags = info->rasterFlags;
+	cache->flags = info->flags;
+	arr_init(&cache->rasterJobs, sizeof(VkgcRasterJob));
+
+	u32 maxGlyphs = (info->maxGlyphs != 0) ? info->maxGlyphs : 4096;
+	cache->capacity = 1;
+	while (cache->capacity < maxGlyphs) { cache->capacity *= 2; }
+	cache->glyphs = (VkgcGlyph*) malloc(cache->capacity * sizeof(VkgcGlyph));
+	for (u32 i = 0; i < cache->capacity; i++) { cache->glyphs[i].glyphIndex = VKGC_EMPTY; }
+
+	arr_init(&cache->shelves, sizeof(VkgcShelf));
+	cache->pages = (VkgcPage*) calloc(cache->maxPages, sizeof(VkgcPage));
+
+	u64 stagingSize = (info->stagingSize != 0) ? info->stagingSize : 64 * KILOBYTE;
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		VkbaVirtualBufferInfo stagingInfo = { HOST_INDEX, stagingSize, NULL, 0 };
+		VkResult result = vkbaCreateVirtualBuffer(cache->bAllocator, cache->staging + i,
+												  &stagingInfo);
+		if (result != VK_SUCCESS) {
+			vkgc_loge("[vkgc] Failed to create %llu byte staging buffer\n", stagingSize);
+			for (u32 j = 0; j < i; j++) {
+				vkbaDestroyVirtualBuffer(cache->bAllocator, cache->staging + j);
+			}
+			free(cache->pages);
+			arr_free(&cache->shelves);
+			free(cache->glyphs);
+			return result;
+		}
+	}
+
+	vkgcCreatePage(cache);
+
+	if ((cache->flags & VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT) &&
+		vkgcCreateRasterPipeline(cache, info->dsManager) != VK_SUCCESS)
+	{
+		vkgc_logw("[vkgc] No compute rasterizer, glyphs are rasterized on the cpu\n");
+		cache->flags &= ~VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT;
+	}
+
+	vkgc_logi("[vkgc] Glyph cache created, %ux%u pages, %llu byte staging per frame\n",
+			  cache->pageSize, cache->pageSize, stagingSize);
+	return VK_SUCCESS;
+}
+
+void vkgcDestroyCache(VkgcCache* cache)
+{
+	for (u32 i = 0; i < cache->numPages; i++) {
+		vktextured(&cache->pages[i].texture, cache->bp, cache->mAllocator);
+		arr_free(&cache->pages[i].copies);
+	}
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		vkbaDestroyVirtualBuffer(cache->bAllocator, cache->staging + i);
+	}
+	// the raster descriptor set layout belongs to the descriptor set manager
+	if (cache->flags & VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT) {
+		vkenDestroyPipeline(&cache->rasterPipeline);
+	}
+	arr_free(&cache->rasterJobs);
+	free(cache->scratch.base);
+	free(cache->pages);
+	arr_free(&cache->shelves);
+	free(cache->glyphs);
+	*cache = (VkgcCache) { 0 };
+
+	vkgc_logi("[vkgc] Glyph cache destroyed\n");
+}
+
+void vkgcBeginFrame(VkgcCache* cache, u32 frameIndex)
+{
+	// the staging buffer of frameIndex is free again once its fence signaled
+	VkgcStats* frame = &cache->frameStats;
+	VkgcStats* total = &cache->totalStats;
+	total->hits += frame->hits;
+	total->misses += frame->misses;
+	total->deferred += frame->deferred;
+	total->evictions += frame->evictions;
+	total->bytesUploaded += frame->bytesUploaded;
+	*frame = (VkgcStats) { 0 };
+
+	cache->frame++;
+	cache->frameIndex = frameIndex % MAX_FRAMES_IN_FLIGHT;
+	cache->stagingOffset = 0;
+}
+
+VkgcGlyph* vkgcGetGlyph(VkgcCache* cache, u32 glyphIndex, u32 pointSize)
+{
+	/*
+	  	NOTE:
+		 - NULL when the glyph cannot be placed this frame, the staging buffer is
+		   full or every shelf is still in flight, asking again next frame works
+		 - the pointer is valid until the next vkgcGetGlyph
+	 */
+	if ((cache->numGlyphs + 1) * 4 > cache->capacity * 3) { vkgcRehash(cache); }
+
+	u32 mask = cache->capacity - 1;
+	u32 slot = vkgcHash(glyphIndex, pointSize) & mask;
+	VkgcGlyph* reuse = NULL;
+	for (;;) {
+		VkgcGlyph* glyph = cache->glyphs + slot;
+		if (glyph->glyphIndex == VKGC_EMPTY) { break; }
+
+		bool valid = vkgcGlyphValid(cache, glyph);
+		if (glyph->glyphIndex == glyphIndex && glyph->pointSize == pointSize) {
+			if (valid) {
+				if (glyph->shelf != VKGC_EMPTY) {
+					VkgcShelf* shelf = (VkgcShelf*) cache->shelves.data + glyph->shelf;
+					shelf->lastUsed = cache->frame;
+				}
+				cache->frameStats.hits++;
+				return glyph;
+			}
+			if (reuse == NULL) { reuse = glyph; }
+			break;
+		}
+		// evicted entries keep their slot so probing stays intact, new ones take it
+		if (!valid && reuse == NULL) { reuse = glyph; }
+		slot = (slot + 1) & mask;
+	}
+	cache->frameStats.misses++;
+
+	TrueTypeFontGlyphBitmap bitmap;
+	ttf_glyph_bitmap_metrics(cache->font, glyphIndex, pointSize, cache->padding,
+							 cache->rasterFlags, &bitmap);
+	VkgcGlyph entry = (VkgcGlyph) {
+		.glyphIndex = glyphIndex,
+		.pointSize = pointSize,
+		.page = 0,
+		.shelf = VKGC_EMPTY,
+		.generation = 0,
+		.width = bitmap.width,
+		.height = bitmap.height,
+		.bearingX = bitmap.bearing_x,
+		.bearingY = bitmap.bearing_y,
+		.advance = bitmap.advance
+	};
+
+	if (bitmap.width != 0) {
+		// copies need 4 byte aligned buffer offsets
+		VkbaVirtualBuffer* staging = cache->staging + cache->frameIndex;
+		u64 offset = ((staging->locale.offset + cache->stagingOffset + 3) & ~3ull) -
+			staging->locale.offset;
+		u64 size = (u64) bitmap.width * bitmap.height;
+		u64 end = offset + size;
+		bool compute = (cache->flags & VKGC_CACHE_CREATE_COMPUTE_RASTER_BIT) != 0;
+		u32 numLines = 0;
+		s32 sdfSpread = 0.0f;
+		if (compute) {
+			// the shader writes whole words, the lines follow them and every job of
+			// the frame goes after the last lines
+			numLines = ttf_glyph_raster_lines(cache->font, glyphIndex, pointSize,
+											  cache->padding, cache->rasterFlags, NULL,
+											  &sdfSpread);
+			end = offset + ((size + 3) & ~3ull) + numLines * sizeof(line2f) +
+				(cache->rasterJobs.size + 1) * sizeof(VkgcRasterJob);
+		}
+		if (staging->locale.size < end ||
+			!vkgcAllocate(cache, bitmap.width, bitmap.height, &entry))
+		{
+			cache->frameStats.deferred++;
+			return NULL;
+		}
+
+		if (compute) {
+			u64 lineOffset = offset + ((size + 3) & ~3ull);
+			ttf_glyph_raster_lines(cache->font, glyphIndex, pointSize, cache->padding,
+								   cache->rasterFlags,
+								   (line2f*) ((u8*) staging->dst + lineOffset), NULL);
+			VkgcRasterJob job = (VkgcRasterJob) {
+				.pixelWord = (staging->locale.offset + offset) / 4,
+				.lineWord = (staging->locale.offset + lineOffset) / 4,
+				.numLines = numLines,
+				.width = bitmap.width,
+				.height = bitmap.height,
+				.sdfSpread = sdfSpread
+			};
+			arr_add(&cache->rasterJobs, &job);
+			cache->stagingOffset = lineOffset + numLines * sizeof(line2f);
+		} else {
+			u64 scratchSize = ttf_glyph_scratch_size(cache->font, glyphIndex, pointSize,
+													 cache->padding, cache->rasterFlags);
+			if (cache->scratch.size < scratchSize) {
+				u64 newSize = MAX(cache->scratch.size, 4 * KILOBYTE);
+				while (newSize < scratchSize) { newSize *= 2; }
+				free(cache->scratch.base);
+				ttf_arena_init(&cache->scratch, malloc(newSize), newSize);
+			}
+			TrueTypeFontRasterTarget target = {
+				(u8*) staging->dst + offset, bitmap.width, 0, 0, 0, 0
+			};
+			ttf_glyph_rasterize(cache->font, glyphIndex, pointSize, cache->padding,
+								cache->rasterFlags, &target, &cache->scratch);
+			cache->stagingOffset = offset + size;
+		}
+		cache->frameStats.bytesUploaded += size;
+
+		VkBufferImageCopy copy = (VkBufferImageCopy) {
+			.bufferOffset = staging->locale.offset + offset,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+			.imageOffset = { entry.x, entry.y, 0 },
+			.imageExtent = { entry.width, entry.height, 1 }
+		};
+		arr_add(&cache->pages[entry.page].copies, &copy);
+
+		float pageSize = cache->pageSize;
+		entry.u0 = entry.x / pageSize;
+		entry.v0 = entry.y / pageSize;
+		entry.u1 = (entry.x + entry.width) / pageSize;
+		entry.v1 = (entry.y + entry.height) / pageSize;
+	}
+
+	if (reuse == NULL) {
+		reuse = cache->glyphs + slot;
+		cache->numGlyphs++;
+	}
+	*reuse = entry;
+	return reuse;
+}
+
+void vkgcRecordUploads(VkgcCache* cache, VkCommandBuffer cmdBuffer)
+{
+	// pages without new glyphs are left alone
+	VkbaVirtualBuffer* staging = cache->staging + cache->frameIndex;
+	if (cache->rasterJobs.size != 0) { vkgcRecordRaster(cache, cmdBuffer); }
+	for (u32 i = 0; i < cache->numPages; i++) {
+		VkgcPage* page = cache->pages + i;
+		VkImage image = page->texture.image;
+
+		if (!page->initialized) {
+			vkcmdtransitionimglayout(cmdBuffer, image, VK_IMAGE_LAYOUT_UNDEFINED,
+									 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+			VkClearColorValue clearColor = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+			VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+			vkCmdClearColorImage(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+								 &clearColor, 1, &range);
+
+			// the copies below overwrite parts of the clear
+			VkMemoryBarrier barrier = (VkMemoryBarrier) {
+				.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+				.pNext = NULL,
+				.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+				.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT
+			};
+			vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+								 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL,
+								 0, NULL);
+		} else if (page->copies.size != 0) {
+			vkcmdtransitionimglayout(cmdBuffer, image,
+									 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+									 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		} else {
+			continue;
+		}
+
+		if (page->copies.size != 0) {
+			vkCmdCopyBufferToImage(cmdBuffer, staging->buffer, image,
+								   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, page->copies.size,
+								   (VkBufferImageCopy*) page->copies.data);
+			arr_clean(&page->copies);
+		}
+		vkcmdtransitionimglayout(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+								 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		page->initialized = true;
+	}
+}
+
+float vkgcHitRate(VkgcStats* stats)
+{
+	u64 lookups = stats->hits + stats->misses;
+	return (lookups != 0) ? (float) stats->hits / lookups : 1.0f;
+}
+
+static void vkgcCreatePage(VkgcCache* cache)
+{
+	VkgcPage* page = cache->pages + cache->numPages;
+	vkblanktexturec(&page->texture, cache->bp, cache->mAllocator, VK_FORMAT_R8_UNORM,
+					cache->pageSize, cache->pageSize);
+	page->top = 0;
+	page->initialized = false;
+	arr_init(&page->copies, sizeof(VkBufferImageCopy));
+	cache->numPages++;
+
+	vkgc_logi("[vkgc] Page %u created\n", cache->numPages - 1);
+}
+
+static VkResult vkgcCreateRasterPipeline(VkgcCache* cache, VkdsManager* dsManager)
+{
+	// one descriptor set per frame in flight, each binds its staging buffer's VkBuffer
+	if (dsManager == NULL) {
+		vkgc_loge("[vkgc] The compute rasterizer needs a descriptor set manager\n");
+		return VK_ERROR_INITIALIZATION_FAILED;
+	}
+
+	VkdsBindingData bindingData0;
+	bindingData0.storageBuffer = (VkdsBindingStorageData) { cache->staging };
+	VkdsBinding bindings[] = {
+		(VkdsBinding) {
+			0, VKDS_BINDING_TYPE_STORAGE_BUFFER, VKDS_BINDING_STAGE_COMPUTE, bindingData0
+		}
+	};
+	VkdsDescriptorSetCreateInfo dsInfo = {
+		1, bindings, MAX_FRAMES_IN_FLIGHT
+	};
+	VkDescriptorSetLayout layout;
+	VkResult result = vkdsCreateDescriptorSets(dsManager, &dsInfo, cache->rasterSets,
+											   &layout);
+	if (result != VK_SUCCESS) {
+		vkgc_loge("[vkgc] Failed to create raster descriptor sets\n");
+		return result;
+	}
+
+	VkenComputePipelineCreateInfo pInfo = {
+		"spv/glyph_raster.comp.spv", 1, &layout, 4 * sizeof(u32), cache->bp->dev
+	};
+	result = vkenCreateComputePipelines(1, &cache->rasterPipeline, &pInfo);
+	if (result != VK_SUCCESS) {
+		vkgc_loge("[vkgc] Failed to create raster pipeline\n");
+		return result;
+	}
+	return VK_SUCCESS;
+}
+
+static void vkgcRecordRaster(VkgcCache* cache, VkCommandBuffer cmdBuffer)
+{
+	/*
+	  	NOTE:
+		 - one workgroup per glyph, batched for the whole frame, the jobs are
+		   written after the frame's last lines, room was kept by vkgcGetGlyph
+		 - the host wrote lines and jobs before the submit, only the shader's
+		   writes need a barrier before the copies read them
+	 */
+	VkbaVirtualBuffer* staging = cache->staging + cache->frameIndex;
+	u64 jobOffset = ((staging->locale.offset + cache->stagingOffset + 3) & ~3ull) -
+		staging->locale.offset;
+	u64 jobsSize = cache->rasterJobs.size * sizeof(VkgcRasterJob);
+	memcpy((u8*) staging->dst + jobOffset, cache->rasterJobs.data, jobsSize);
+	cache->stagingOffset = jobOffset + jobsSize;
+
+	u32 mode = 0;
+	if (cache->rasterFlags & TTF_RASTER_SDF) {
+		mode = 2;
+	} else if (cache->rasterFlags & TTF_RASTER_AA) {
+		mode = 1;
+	}
+	u32 params[4] = {
+		(staging->locale.offset + jobOffset) / 4, cache->rasterJobs.size, mode, 0
+	};
+
+	VkenPipeline* pipeline = &cache->rasterPipeline;
+	vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipe);
+	vkCmdBindDescriptorSets(cmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0,
+							1, cache->rasterSets + cache->frameIndex, 0, NULL);
+	vkCmdPushConstants(cmdBuffer, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+					   sizeof(params), params);
+	vkCmdDispatch(cmdBuffer, cache->rasterJobs.size, 1, 1);
+
+	VkMemoryBarrier barrier = (VkMemoryBarrier) {
+		.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+		.pNext = NULL,
+		.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT
+	};
+	vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+						 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+	arr_clean(&cache->rasterJobs);
+}
+
+static bool vkgcAllocate(VkgcCache* cache, u32 width, u32 height, VkgcGlyph* glyph)
+{
+	/*
+	  	NOTE:
+		 - an open shelf of the same height class first, then a new shelf on a
+		   page with rows left, then a new page, then the least recently used
+		   shelf that is tall enough, its rows below the new height class become
+		   a shelf of their own
+		 - shelves drawn in the last MAX_FRAMES_IN_FLIGHT frames may still be
+		   sampled by the GPU and are not evicted
+	 */
+	u32 shelfHeight = (height + VKGC_SHELF_ROUNDING - 1) & ~(VKGC_SHELF_ROUNDING - 1);
+	if (cache->pageSize < width || cache->pageSize < shelfHeight) {
+		vkgc_logw("[vkgc] %ux%u glyph does not fit a %u page\n", width, height,
+				  cache->pageSize);
+		return false;
+	}
+
+	VkgcShelf* shelves = (VkgcShelf*) cache->shelves.data;
+	u32 found = VKGC_EMPTY;
+	for (u32 i = 0; i < cache->shelves.size; i++) {
+		if (shelves[i].height == shelfHeight && shelves[i].x + width <= cache->pageSize) {
+			found = i;
+			break;
+		}
+	}
+
+	if (found == VKGC_EMPTY) {
+		u32 pageIndex = VKGC_EMPTY;
+		for (u32 i = 0; i < cache->numPages; i++) {
+			if (cache->pages[i].top + shelfHeight <= cache->pageSize) {
+				pageIndex = i;
+				break;
+			}
+		}
+		if (pageIndex == VKGC_EMPTY && cache->numPages < cache->maxPages) {
+			pageIndex = cache->numPages;
+			vkgcCreatePage(cache);
+		}
+		if (pageIndex != VKGC_EMPTY) {
+			VkgcPage* page = cache->pages + pageIndex;
+			VkgcShelf shelf = (VkgcShelf) { pageIndex, page->top, shelfHeight, 0, 0, 0 };
+			page->top += shelfHeight;
+			arr_add(&cache->shelves, &shelf);
+			shelves = (VkgcShelf*) cache->shelves.data;
+			found = cache->shelves.size - 1;
+		}
+	}
+
+	if (found == VKGC_EMPTY) {
+		for (u32 i = 0; i < cache->shelves.size; i++) {
+			VkgcShelf* shelf = shelves + i;
+			if (shelf->height < shelfHeight ||
+				cache->frame < shelf->lastUsed + MAX_FRAMES_IN_FLIGHT)
+			{
+				continue;
+			}
+			if (found == VKGC_EMPTY || shelf->lastUsed < shelves[found].lastUsed ||
+				(shelf->lastUsed == shelves[found].lastUsed &&
+				 shelf->height < shelves[found].height))
+			{
+				found = i;
+			}
+		}
+		if (found == VKGC_EMPTY) { return false; }
+
+		// bumping the generation invalidates every glyph on the shelf
+		shelves[found].x = 0;
+		shelves[found].generation++;
+		cache->frameStats.evictions++;
+
+		// lookups match the height exactly, a tall shelf kept whole would waste its
+		// remaining rows, appending keeps the indices glyphs refer to
+		if (shelfHeight < shelves[found].height) {
+			VkgcShelf rest = (VkgcShelf) {
+				shelves[found].page, shelves[found].y + shelfHeight,
+				shelves[found].height - shelfHeight, 0, 0, 0
+			};
+			shelves[found].height = shelfHeight;
+			arr_add(&cache->shelves, &rest);
+			shelves = (VkgcShelf*) cache->shelves.data;
+		}
+	}
+
+	VkgcShelf* shelf = shelves + found;
+	glyph->page = shelf->page;
+	glyph->shelf = found;
+	glyph->generation = shelf->generation;
+	glyph->x = shelf->x;
+	glyph->y = shelf->y;
+	shelf->x += width;
+	shelf->lastUsed = cache->frame;
+	return true;
+}
+
+static bool vkgcGlyphValid(VkgcCache* cache, VkgcGlyph* glyph)
+{
+	if (glyph->shelf == VKGC_EMPTY) { return true; }
+	VkgcShelf* shelf = (VkgcShelf*) cache->shelves.data + glyph->shelf;
+	return shelf->generation == glyph->generation;
+}
+
+static void vkgcRehash(VkgcCache* cache)
+{
+	// drops evicted entries, grows while live ones would still fill half the table
+	u32 live = 0;
+	for (u32 i = 0; i < cache->capacity; i++) {
+		VkgcGlyph* glyph = cache->glyphs + i;
+		if (glyph->glyphIndex != VKGC_EMPTY && vkgcGlyphValid(cache, glyph)) { live++; }
+	}
+
+	VkgcGlyph* glyphs = cache->glyphs;
+	u32 capacity = cache->capacity;
+	while (cache->capacity <= live * 2) { cache->capacity *= 2; }
+	cache->glyphs = (VkgcGlyph*) malloc(cache->capacity * sizeof(VkgcGlyph));
+	for (u32 i = 0; i < cache->capacity; i++) { cache->glyphs[i].glyphIndex = VKGC_EMPTY; }
+	cache->numGlyphs = 0;
+
+	u32 mask = cache->capacity - 1;
+	for (u32 i = 0; i < capacity; i++) {
+		VkgcGlyph* glyph = glyphs + i;
+		if (glyph->glyphIndex == VKGC_EMPTY || !vkgcGlyphValid(cache, glyph)) { continue; }
+		u32 slot = vkgcHash(glyph->glyphIndex, glyph->pointSize) & mask;
+		while (cache->glyphs[slot].glyphIndex != VKGC_EMPTY) { slot = (slot + 1) & mask; }
+		cache->glyphs[slot] = *glyph;
+		cache->numGlyphs++;
+	}
+	free(glyphs);
+}
+
+static u32 vkgcHash(u32 glyphIndex, u32 pointSize)
+{
+	u32 hash = glyphIndex * 0x9e3779b1 ^ pointSize * 0x85ebca6b;
+	return hash ^ (hash >> 16);
+}
@@ -0,0 +1,348 @@
+#include "grafics2.h"
+
+#define vktext_logi(...) logi(__VA_ARGS__)
+#define vktext_logw(...) logw(__VA_ARGS__)
+#define vktext_loge(...) loge(__VA_ARGS__)
+
+#define VKTEXT_NO_BINDING 0xffffffffffffffff
+
+static VkResult vktextAddPage(VktextRenderer* renderer);
+
+VkResult vktextCreateRenderer(VktextRenderer* renderer, VktextRendererCreateInfo* info)
+{
+	/*
+	  	USAGE:
+
+		every frame, once the frame's fence has been waited on:
+			vkgcBeginFrame(&cache, frame);
+			vktextBeginFrame(&text, frame);
+			vktextAddText(&text, "label", 5, 24, x, y);
+			...
+			vktextEndFrame(&text);
+			vkgcRecordUploads(&cache, cmdbuf);		// before the render pass
+			...
+			vktextDraw(&text, cmdbuf);				// inside the render pass
+
+	  	NOTE:
+		 - every glyph of the frame is one instance of the same quad, all strings
+		   share one instance buffer, sorted by glyph cache page
+		 - one instanced draw per page that has glyphs this frame, no matter how
+		   many strings were added
+	 */
+	assert(renderer != NULL);
+	assert(info != NULL && info->cache != NULL);
+
+	*renderer = (VktextRenderer) { 0 };
+	renderer->bp = info->boilerplate;
+	renderer->bAllocator = info->bAllocator;
+	renderer->dsManager = info->dsManager;
+	renderer->machine = info->machine;
+	renderer->cache = info->cache;
+	// 2 x 4096 x 32 B = 256 KB of vkba's 1 MB HOST page, see vkvtCreateRenderer()
+	renderer->maxInstances = (info->maxInstances != 0) ? info->maxInstances : 4096;
+	renderer->pages = (VktextPage*) calloc(info->cache->maxPages, sizeof(VktextPage));
+	arr_init(&renderer->instances, sizeof(VktextInstance));
+	arr_init(&renderer->instancePages, sizeof(u32));
+	arr_init(&renderer->glyphIndices, sizeof(u32));
+
+	// pixels, y down from the top left, to clip space
+	VkExtent2D extent = info->core->swpcext;
+	renderer->uboData[0] = 2.0f / extent.width;
+	renderer->uboData[1] = 2.0f / extent.height;
+	renderer->uboData[2] = -1.0f;
+	renderer->uboData[3] = -1.0f;
+	VkbaVirtualBufferInfo vBufferInfo = { HOST_INDEX, 4 * 4, renderer->uboData, 1 };
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		VkResult result = vkbaCreateVirtualBuffer(renderer->bAllocator, renderer->ubos + i,
+												  &vBufferInfo);
+		if (result != VK_SUCCESS) { return result; }
+		memcpy(renderer->ubos[i].dst, renderer->ubos[i].src, renderer->ubos[i].locale.size);
+	}
+
+	VkbaVirtualBufferInfo instanceInfo = {
+		HOST_INDEX, sizeof(VktextInstance) * renderer->maxInstances * MAX_FRAMES_IN_FLIGHT,
+		NULL, 0
+	};
+	VkResult result = vkbaCreateVirtualBuffer(renderer->bAllocator, &renderer->instbuff,
+											  &instanceInfo);
+	if (result != VK_SUCCESS) {
+		vktext_loge("[vktext] Failed to create instance buffer for %u glyphs\n",
+					renderer->maxInstances);
+		return result;
+	}
+
+	// unit quad, the instance places and sizes it
+	Vertex vertices[4] = {
+		{ { 0.0f, 0.0f }, { 0.0f, 0.0f } },
+		{ { 1.0f, 0.0f }, { 1.0f, 0.0f } },
+		{ { 1.0f, 1.0f }, { 1.0f, 1.0f } },
+		{ { 0.0f, 1.0f }, { 0.0f, 1.0f } }
+	};
+	VkbaVirtualBufferInfo tmpBufferInfo = { DEVICE_INDEX, sizeof(Vertex) * 4, vertices };
+	vkbaStageVirtualBuffer(renderer->bAllocator, &renderer->vertexbuff, &tmpBufferInfo);
+
+	uint32_t indices[6] = { 0, 1, 3, 1, 2, 3 };
+	tmpBufferInfo = (VkbaVirtualBufferInfo) { DEVICE_INDEX, sizeof(u32) * 6, indices };
+	vkbaStageVirtualBuffer(renderer->bAllocator, &renderer->indexbuff, &tmpBufferInfo);
+
+	// the first page's descriptor set layout is the pipeline's
+	result = vktextAddPage(renderer);
+	if (result != VK_SUCCESS) { return result; }
+
+	VkVertexInputBindingDescription vibd[] = {
+		(VkVertexInputBindingDescription) {
+			.binding = 0,
+			.stride = sizeof(Vertex),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		},
+		(VkVertexInputBindingDescription) {
+			.binding = 1,
+			.stride = sizeof(VktextInstance),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+		}
+	};
+
+	VkVertexInputAttributeDescription viad[] = {
+		(VkVertexInputAttributeDescription) {
+			.binding = 0,
+			.location = 0,
+			.format = VK_FORMAT_R32G32_SFLOAT,
+			.offset = 0
+		},
+		(VkVertexInputAttributeDescription) {
+			.binding = 0,
+			.location = 1,
+			.format = VK_FORMAT_R32G32_SFLOAT,
+			.offset = 2*4
+		},
+		(VkVertexInputAttributeDescription) {
+			.binding = 1,
+			.location = 2,
+			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
+			.offset = 0
+		},
+		(VkVertexInputAttributeDescription) {
+			.binding = 1,
+			.location = 3,
+			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
+			.offset = 4*4
+		}
+	};
+
+	VkenPipelineCreateInfo pInfo = {
+		"spv/text.vert.spv", "spv/text.frag.spv", 2, vibd, 4, viad,
+		1, &renderer->dlayout, extent, renderer->bp->dev, info->core->renderpass, 0,
+		VKEN_PIPELINE_CREATE_ALPHA_BLEND_BIT
+	};
+	result = vkenCreatePipelines(1, &renderer->pipeline, &pInfo);
+	if (result != VK_SUCCESS) { return result; }
+
+	// binding pipelines need the pipeline, pages added before it get theirs now
+	for (u32 i = 0; i < renderer->numPages; i++) {
+		VktextPage* page = renderer->pages + i;
+		VkbpBindingPipelineInfo bInfo = {
+			renderer->pipeline.pipe, &renderer->vertexbuff, &renderer->indexbuff,
+			&renderer->instbuff, renderer->pipeline.layout, MAX_FRAMES_IN_FLIGHT, 1,
+			page->dsets, 6, 0, sizeof(VktextInstance) * renderer->maxInstances, &page->draw
+		};
+		page->bindingId = vkbpAddBindingPipeline(renderer->machine, &bInfo);
+	}
+
+	vktext_logi("[vktext] Text renderer created, %u glyphs per frame\n",
+				renderer->maxInstances);
+	return VK_SUCCESS;
+}
+
+void vktextDestroyRenderer(VktextRenderer* renderer)
+{
+	VkbaAllocator* bAllocator = renderer->bAllocator;
+
+	vkenDestroyPipeline(&renderer->pipeline);
+
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->vertexbuff);
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->indexbuff);
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->instbuff);
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		vkbaDestroyVirtualBuffer(bAllocator, renderer->ubos + i);
+	}
+
+	free(renderer->pages);
+	arr_free(&renderer->instances);
+	arr_free(&renderer->instancePages);
+	arr_free(&renderer->glyphIndices);
+	*renderer = (VktextRenderer) { 0 };
+
+	vktext_logi("[vktext] Text renderer destroyed\n");
+}
+
+void vktextBeginFrame(VktextRenderer* renderer, u32 frameIndex)
+{
+	renderer->frameIndex = frameIndex % MAX_FRAMES_IN_FLIGHT;
+	arr_clean(&renderer->instances);
+	arr_clean(&renderer->instancePages);
+}
+
+u32 vktextAddText(VktextRenderer* renderer, const char* text, u32 length, u32 pointSize,
+				  float x, float y)
+{
+	/*
+	  	NOTE:
+		 - utf-8, x and y are the pen on the first baseline in pixels, y down,
+		   '\n' starts a new line ascent - descent further down
+		 - advances come from hmtx and pairs are kerned with the font's 'kern',
+		   the same way ttf_measure_text() measures them
+		 - glyphs the cache could not place this frame are skipped but still
+		   advance the pen, returns the number of glyphs added
+	 */
+	VkgcCache* cache = renderer->cache;
+	TrueTypeFont* ttf = cache->font;
+	s32 scale = (s32) pointSize / (s32) ttf->units_per_em;
+	s32 lineAdvance = scale * (ttf->ascent - ttf->descent);
+
+	if (renderer->glyphIndices.size < length) {
+		arr_clean(&renderer->glyphIndices);
+		for (u32 i = 0; i < length; i++) { arr_push(&renderer->glyphIndices); }
+	}
+	u32* glyphIndices = (u32*) renderer->glyphIndices.data;
+
+	u32 added = 0;
+	const char* line = text;
+	const char* end = text + length;
+	while (line < end) {
+		const char* lineEnd = memchr(line, '\n', end - line);
+		if (lineEnd == NULL) { lineEnd = end; }
+		u32 numGlyphs = ttf_glyph_indices_utf8(ttf, line, lineEnd - line, glyphIndices);
+
+		s32 pen = x;
+		for (u32 i = 0; i < numGlyphs; i++) {
+			u32 glyphIndex = glyphIndices[i];
+			// kerned like ttf_measure_texts(), never after the missing glyph
+			if (i != 0 && glyphIndices[i - 1] != 0) {
+				pen += scale * ttf_kerning_get(ttf, glyphIndices[i - 1], glyphIndex);
+			}
+
+			VkgcGlyph* glyph = vkgcGetGlyph(cache, glyphIndex, pointSize);
+			if (glyph != NULL && glyph->width != 0) {
+				if (renderer->instances.size == renderer->maxInstances) {
+					vktext_logw("[vktext] More than %u glyphs this frame\n",
+								renderer->maxInstances);
+					return added;
+				}
+				// whole pixels keep the cached glyph sampled texel for texel
+				VktextInstance instance = (VktextInstance) {
+					{ floorf(pen + glyph->bearingX + 0.5f),
+					  floorf(y - glyph->bearingY + 0.5f), glyph->width, glyph->height },
+					{ glyph->u0, glyph->v0, glyph->u1, glyph->v1 }
+				};
+				arr_add(&renderer->instances, &instance);
+				arr_add(&renderer->instancePages, &glyph->page);
+				added++;
+			}
+			pen += scale * ttf->advances[MIN(glyphIndex, ttf->num_glyphs - 1u)];
+		}
+
+		y += lineAdvance;
+		line = lineEnd + 1;
+	}
+	return added;
+}
+
+void vktextEndFrame(VktextRenderer* renderer)
+{
+	// instances go to this frame's slice grouped by page, each page draws its range
+	while (renderer->numPages < renderer->cache->numPages) {
+		if (vktextAddPage(renderer) != VK_SUCCESS) { break; }
+	}
+
+	u32 first = 0;
+	for (u32 i = 0; i < renderer->numPages; i++) {
+		renderer->pages[i].draw = (VkDrawIndexedIndirectCommand) { 6, 0, 0, 0, 0 };
+	}
+	u32* instancePages = (u32*) renderer->instancePages.data;
+	for (u32 i = 0; i < renderer->instancePages.size; i++) {
+		renderer->pages[instancePages[i]].draw.instanceCount++;
+	}
+	for (u32 i = 0; i < renderer->numPages; i++) {
+		renderer->pages[i].draw.firstInstance = first;
+		first += renderer->pages[i].draw.instanceCount;
+	}
+
+	VktextInstance* dst = (VktextInstance*) renderer->instbuff.dst +
+		renderer->frameIndex * renderer->maxInstances;
+	VktextInstance* src = (VktextInstance*) renderer->instances.data;
+	if (renderer->numPages == 1) {
+		memcpy(dst, src, renderer->instances.size * sizeof(VktextInstance));
+		return;
+	}
+	u32 next[renderer->numPages];
+	for (u32 i = 0; i < renderer->numPages; i++) {
+		next[i] = renderer->pages[i].draw.firstInstance;
+	}
+	for (u32 i = 0; i < renderer->instances.size; i++) {
+		dst[next[instancePages[i]]++] = src[i];
+	}
+}
+
+void vktextDraw(VktextRenderer* renderer, VkCommandBuffer cmdBuffer)
+{
+	for (u32 i = 0; i < renderer->numPages; i++) {
+		VktextPage* page = renderer->pages + i;
+		if (page->draw.instanceCount == 0 || page->bindingId == VKTEXT_NO_BINDING) {
+			continue;
+		}
+		VkResult result = vkbpBindBindingPipeline(renderer->machine, cmdBuffer,
+												  renderer->frameIndex, page->bindingId);
+		assert(result == VK_SUCCESS);
+	}
+}
+
+static VkResult vktextAddPage(VktextRenderer* renderer)
+{
+	// descriptor sets for the next glyph cache page, they never change afterwards
+	VktextPage* page = renderer->pages + renderer->numPages;
+	VkTexture* texture = &renderer->cache->pages[renderer->numPages].texture;
+
+	VkdsBindingData bindingData0;
+	bindingData0.imageSampler = (VkdsBindingImageSamplerData) {
+		texture->sampler, texture->view
+	};
+	VkdsBindingData bindingData1;
+	bindingData1.uniformBuffer = (VkdsBindingUniformData) { renderer->ubos };
+	VkdsBinding bindings[] = {
+		(VkdsBinding) {
+			0, VKDS_BINDING_TYPE_IMAGE_SAMPLER, VKDS_BINDING_STAGE_FRAGMENT, bindingData0
+		},
+		(VkdsBinding) {
+			1, VKDS_BINDING_TYPE_UNIFORM_BUFFER, VKDS_BINDING_STAGE_VERTEX, bindingData1
+		}
+	};
+	VkdsDescriptorSetCreateInfo dsInfo = {
+		2, bindings, MAX_FRAMES_IN_FLIGHT
+	};
+	VkDescriptorSetLayout layout;
+	VkResult result = vkdsCreateDescriptorSets(renderer->dsManager, &dsInfo, page->dsets,
+											   &layout);
+	if (result != VK_SUCCESS) {
+		vktext_loge("[vktext] Failed to create descriptor sets for page %u\n",
+					renderer->numPages);
+		return result;
+	}
+
+	// every page's layout is defined the same way, the first one builds the
+	// pipeline, vkdsDestroyManager() destroys all of them
+	if (renderer->numPages == 0) {
+		renderer->dlayout = layout;
+	}
+
+	page->bindingId = VKTEXT_NO_BINDING;
+	if (renderer->pipeline.pipe != VK_NULL_HANDLE) {
+		VkbpBindingPipelineInfo bInfo = {
+			renderer->pipeline.pipe, &renderer->vertexbuff, &renderer->indexbuff,
+			&renderer->instbuff, renderer->pipeline.layout, MAX_FRAMES_IN_FLIGHT, 1,
+			page->dsets, 6, 0, sizeof(VktextInstance) * renderer->maxInstances, &page->draw
+		};
+		page->bindingId = vkbpAddBindingPipeline(renderer->machine, &bInfo);
+	}
+	renderer->numPages++;
+	return VK_SUCCESS;
+}
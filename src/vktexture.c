@@ -3,6 +3,189 @@
 #define UPDATE_DEBUG_LINE() bp->user_data.line = __LINE__ + 1
 #define UPDATE_DEBUG_FILE() bp->user_data.file = __FILE__
 
+// staging for streamed textures takes two bands out of the shared 1 MB host page,
+// the text renderers keep ~770 KB of it, see vkvtCreateRenderer()
+#define VK_TEXTURE_BAND_SIZE (64 * KILOBYTE)
+
+// decodes rows [first_row, first_row + num_rows) of 'image' to R8G8B8A8
+typedef void (*vkbanddecoder)(void* image, void* dst, u32 stride, u32 first_row, u32 num_rows);
+
+static void vktextureviewsampler(VkTexture* texture, VkBoilerplate* bp, VkFormat format,
+								 VkFilter filter, VkSamplerAddressMode address_mode)
+{
+	VkResult result;
+
+	VkImageViewCreateInfo view_info = (VkImageViewCreateInfo) {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.image = texture->image,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = format,
+		.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
+						VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
+		.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
+	};
+
+	UPDATE_DEBUG_LINE();
+	result = vkCreateImageView(bp->dev, &view_info, NULL, &texture->view);
+	assert(result == VK_SUCCESS);
+	logt("VkTexture.view created\n");
+
+	VkPhysicalDeviceProperties phydev_properties;
+	vkGetPhysicalDeviceProperties(bp->phydev, &phydev_properties);
+	
+	VkSamplerCreateInfo sampler_info = (VkSamplerCreateInfo) {
+		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.magFilter = filter,
+		.minFilter = filter,
+		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+		.addressModeU = address_mode,
+		.addressModeV = address_mode,
+		.addressModeW = address_mode,
+		.mipLodBias = 0.0f,
+		.anisotropyEnable = VK_FALSE,
+		.maxAnisotropy = phydev_properties.limits.maxSamplerAnisotropy,
+		.compareEnable = VK_FALSE,
+		.compareOp = VK_COMPARE_OP_ALWAYS,
+		.minLod = 0.0f,
+		.maxLod = 0.0f,
+		.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+		.unnormalizedCoordinates = VK_FALSE
+	};
+
+	UPDATE_DEBUG_LINE();
+	result =  vkCreateSampler(bp->dev, &sampler_info, NULL, &texture->sampler);
+	assert(result == VK_SUCCESS);
+	logt("VkTexture.sampler created\n");
+}
+
+static VkResult vkbandtexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
+							   VkmaAllocator* mAllocator, VkbaAllocator* bAllocator,
+							   u32 width, u32 height, vkbanddecoder decode_rows, void* image)
+{
+	/*
+		NOTE:
+		 - R8G8B8A8_SRGB with vkblanktexturec()'s view and sampler, ready to sample
+		 - the image streams through two bands of VK_TEXTURE_BAND_SIZE, one is
+		   decoded while the other is copied, so staging stays at two bands
+		   whatever the size of the image
+		 - 'decode_rows' is called for every band in order, top to bottom
+	 */
+	UPDATE_DEBUG_FILE();
+	VkResult result;
+
+	u64 row_size = 4 * (u64) width;
+	u32 band_rows = (u32) MIN(MAX(VK_TEXTURE_BAND_SIZE / row_size, 1), height);
+	u64 band_size = row_size * band_rows;
+
+	VkbaVirtualBuffer stagingBuffer;
+	VkbaVirtualBufferInfo tmpBufferInfo = { HOST_INDEX, 2 * band_size, NULL, 0 };
+	result = vkbaCreateVirtualBuffer(bAllocator, &stagingBuffer, &tmpBufferInfo);
+	if (result != VK_SUCCESS) { return result; }
+
+	VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+	vkblanktexturec(texture, bp, mAllocator, format, width, height);
+
+	VkCommandBufferAllocateInfo alloc_info = (VkCommandBufferAllocateInfo) {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = core->cmdpool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 2
+	};
+	VkCommandBuffer cmdbufs[2];
+	result = vkAllocateCommandBuffers(bp->dev, &alloc_info, cmdbufs);
+	assert(result == VK_SUCCESS);
+
+	VkFenceCreateInfo fence_info = (VkFenceCreateInfo) {
+		.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO
+	};
+	VkFence fences[2];
+	for (u32 i = 0; i < 2; i++) {
+		result = vkCreateFence(bp->dev, &fence_info, NULL, fences + i);
+		assert(result == VK_SUCCESS);
+	}
+
+	VkCommandBufferBeginInfo begin_info = (VkCommandBufferBeginInfo) {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+	};
+
+	u32 band = 0;
+	for (u32 y = 0; y < height; y += band_rows, band++) {
+		u32 i = band & 1;
+		u32 rows = MIN(band_rows, height - y);
+
+		// the copy out of this half two bands ago has to finish before it is reused
+		if (band >= 2) {
+			vkWaitForFences(bp->dev, 1, fences + i, VK_TRUE, UINT64_MAX);
+			vkResetFences(bp->dev, 1, fences + i);
+		}
+		decode_rows(image, (u8*) stagingBuffer.dst + i * band_size, (u32) row_size, y, rows);
+
+		vkBeginCommandBuffer(cmdbufs[i], &begin_info);
+		if (y == 0) {
+			vkcmdtransitionimglayout(cmdbufs[i], texture->image,
+									 VK_IMAGE_LAYOUT_UNDEFINED,
+									 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		}
+
+		VkBufferImageCopy copy = (VkBufferImageCopy) {
+			.bufferOffset = stagingBuffer.locale.offset + i * band_size,
+			.bufferRowLength = 0,
+			.bufferImageHeight = 0,
+			.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+			.imageOffset = { 0, (i32) y, 0 },
+			.imageExtent = { width, rows, 1 }
+		};
+		vkCmdCopyBufferToImage(cmdbufs[i], stagingBuffer.buffer, texture->image,
+							   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+		// barriers order every earlier submission on the queue, the last band
+		// makes all of the copies visible to the shaders
+		if (y + rows == height) {
+			vkcmdtransitionimglayout(cmdbufs[i], texture->image,
+									 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+		vkEndCommandBuffer(cmdbufs[i]);
+
+		VkSubmitInfo submit_info = (VkSubmitInfo) {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.commandBufferCount = 1,
+			.pCommandBuffers = cmdbufs + i
+		};
+		UPDATE_DEBUG_LINE();
+		result = vkQueueSubmit(bp->queue, 1, &submit_info, fences[i]);
+		assert(result == VK_SUCCESS);
+	}
+	vkWaitForFences(bp->dev, MIN(band, 2), fences, VK_TRUE, UINT64_MAX);
+
+	for (u32 i = 0; i < 2; i++) {
+		vkDestroyFence(bp->dev, fences[i], NULL);
+	}
+	vkFreeCommandBuffers(bp->dev, core->cmdpool, 2, cmdbufs);
+	vkbaDestroyVirtualBuffer(bAllocator, &stagingBuffer);
+
+	logt("VkTexture streamed, %ux%u in %u bands\n", width, height, band);
+	return VK_SUCCESS;
+}
+
+static void vkbmpband(void* image, void* dst, u32 stride, u32 first_row, u32 num_rows)
+{
+	bmp_decode_rows((BmpImage*) image, dst, stride, first_row, num_rows);
+	bmp_release_rows((BmpImage*) image, first_row, num_rows);
+}
+
+static void vkqoiband(void* image, void* dst, u32 stride, u32 first_row, u32 num_rows)
+{
+	// chunks only decode in order, the bands come top to bottom
+	qoi_decode_rows((QoiImage*) image, dst, stride, num_rows);
+	qoi_release((QoiImage*) image);
+}
+
 void vktexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
 				VkmaAllocator* mAllocator, VkbaAllocator* bAllocator)
 {
@@ -15,12 +198,12 @@ void vktexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
 	*/
 
 	TrueTypeFont* ttf = NULL;
-	i32 ttf_result = ttf_load(&ttf, "resources/calibri.ttf");
+	i32 ttf_result = ttf_load(&ttf, "resources/calibri.ttf", TTF_LOAD_LAZY);
 	assert(ttf_result == 1);
 	
 	u32 width = 128;
 	u32 height = width;
-	void* pixels = (void*) ttf_create_bitmap(ttf, 'a', width, height);
+	void* pixels = (void*) ttf_create_bitmap(ttf, 'a', width, height, TTF_RASTER_AA);
 	ttf_free(&ttf);
 	VkFormat format = VK_FORMAT_R8_SRGB;
 
@@ -67,51 +250,8 @@ void vktexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
 						  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 						  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-	VkImageViewCreateInfo view_info = (VkImageViewCreateInfo) {
-		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-		.pNext = NULL,
-		.flags = 0,
-		.image = texture->image,
-		.viewType = VK_IMAGE_VIEW_TYPE_2D,
-		.format = format,
-		.components = { VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY,
-						VK_COMPONENT_SWIZZLE_IDENTITY, VK_COMPONENT_SWIZZLE_IDENTITY },
-		.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 }
-	};
-
-	UPDATE_DEBUG_LINE();
-	result = vkCreateImageView(bp->dev, &view_info, NULL, &texture->view);
-	assert(result == VK_SUCCESS);
-	logt("VkTexture.view created\n");
-
-	VkPhysicalDeviceProperties phydev_properties;
-	vkGetPhysicalDeviceProperties(bp->phydev, &phydev_properties);
-	
-	VkSamplerCreateInfo sampler_info = (VkSamplerCreateInfo) {
-		.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-		.pNext = NULL,
-		.flags = 0,
-		.magFilter = VK_FILTER_NEAREST,
-		.minFilter = VK_FILTER_NEAREST,
-		.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
-		.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-		.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-		.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-		.mipLodBias = 0.0f,
-		.anisotropyEnable = VK_FALSE,
-		.maxAnisotropy = phydev_properties.limits.maxSamplerAnisotropy,
-		.compareEnable = VK_FALSE,
-		.compareOp = VK_COMPARE_OP_ALWAYS,
-		.minLod = 0.0f,
-		.maxLod = 0.0f,
-		.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
-		.unnormalizedCoordinates = VK_FALSE
-	};
-
-	UPDATE_DEBUG_LINE();
-	result =  vkCreateSampler(bp->dev, &sampler_info, NULL, &texture->sampler);
-	assert(result == VK_SUCCESS);
-	logt("VkTexture.sampler created\n");
+	vktextureviewsampler(texture, bp, format, VK_FILTER_NEAREST,
+						 VK_SAMPLER_ADDRESS_MODE_REPEAT);
 
 	vkbaDestroyVirtualBuffer(bAllocator, &stagingBuffer);
 	bmp_free(pixels);
@@ -149,55 +289,7 @@ void vktransitionimglayout(VkImage* image, VkBoilerplate* bp, VkCore* core,
 
     vkBeginCommandBuffer(cmdbuf, &begin_info);
 
-	VkAccessFlags src_flags, dst_flags;
-	VkPipelineStageFlags src_stage, dst_stage;
-	
-	if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
-		new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
-	{
-		src_flags = 0;
-		dst_flags = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-		src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-	}
-	else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
-			 new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
-	{
-		src_flags = VK_ACCESS_TRANSFER_WRITE_BIT;
-		dst_flags = VK_ACCESS_SHADER_READ_BIT;
-
-		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-	}
-	else
-	{
-		loge("vktrasitionimglayout(), unsupported image layout trasition\n");
-		exit(0);
-	}
-	
-	VkImageSubresourceRange subresrange = (VkImageSubresourceRange) {
-		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-		.baseMipLevel = 0,
-		.levelCount = 1,
-		.baseArrayLayer = 0,
-		.layerCount = 1
-	};
-	
-	VkImageMemoryBarrier barrier = (VkImageMemoryBarrier) {
-		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-		.pNext = NULL,
-		.srcAccessMask = src_flags,
-		.dstAccessMask = dst_flags,
-		.oldLayout = old_layout,
-		.newLayout = new_layout,
-		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-		.image = *image,
-		.subresourceRange = subresrange
-	};
-
-	vkCmdPipelineBarrier(cmdbuf, src_stage, dst_stage, 0, 0, NULL, 0, NULL,	1, &barrier);
+	vkcmdtransitionimglayout(cmdbuf, *image, old_layout, new_layout);
 
 	vkEndCommandBuffer(cmdbuf);
 
@@ -290,3 +382,151 @@ void vkcopybuftoimg(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
 	
 	vkFreeCommandBuffers(bp->dev, core->cmdpool, 1, &cmdbuf);
 }
+
+void vkblanktexturec(VkTexture* texture, VkBoilerplate* bp, VkmaAllocator* mAllocator,
+					 VkFormat format, uint32_t width, uint32_t height)
+{
+	/*
+	  	NOTE:
+		 - contents and layout are undefined, record the first transition and
+		   upload with vkcmdtransitionimglayout() and vkCmdCopyBufferToImage()
+		 - linear filtering, clamped to the edge, for atlases sampled in sub rects
+	 */
+	UPDATE_DEBUG_FILE();
+	VkResult result;
+
+	VkImageCreateInfo image_info = (VkImageCreateInfo) {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.pNext = NULL,
+		.flags = 0,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = format,
+		.extent = { width, height, 1 },
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = 0,
+		.pQueueFamilyIndices = NULL,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED
+	};
+
+	VkmaAllocationInfo allocInfo = {
+		VKMA_ALLOCATION_USAGE_DEVICE,
+		0,
+		"TEXTURE",
+		NULL
+	};
+
+	result = vkmaCreateImage(mAllocator, &image_info, &texture->image,
+							 &allocInfo, &texture->allocation);
+	assert(result == VK_SUCCESS);
+
+	vktextureviewsampler(texture, bp, format, VK_FILTER_LINEAR,
+						 VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE);
+
+	logt("VkTexture created, %ux%u blank\n", width, height);
+}
+
+VkResult vkbmptexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
+					   VkmaAllocator* mAllocator, VkbaAllocator* bAllocator, const char* path)
+{
+	/*
+	  	NOTE:
+		 - R8G8B8A8_SRGB with vkblanktexturec()'s view and sampler, ready to sample
+		 - texels go from the mapped file straight into the mapped staging buffer,
+		   bmp_decode_rows() is the only pass over them before the copy to the
+		   image, a band at a time so resident file pages stay at a few bands
+	 */
+	BmpImage bmp;
+	if (bmp_open(&bmp, path) != 1) { return VK_ERROR_UNKNOWN; }
+
+	VkResult result = vkbandtexturec(texture, bp, core, mAllocator, bAllocator,
+									 bmp.width, bmp.height, vkbmpband, &bmp);
+	bmp_close(&bmp);
+
+	logt("VkTexture created from %s\n", path);
+	return result;
+}
+
+VkResult vkqoitexturec(VkTexture* texture, VkBoilerplate* bp, VkCore* core,
+					   VkmaAllocator* mAllocator, VkbaAllocator* bAllocator, const char* path)
+{
+	// as vkbmptexturec(), the chunks are decoded into staging a band at a time
+	QoiImage qoi;
+	if (qoi_open(&qoi, path) != 1) { return VK_ERROR_UNKNOWN; }
+
+	VkResult result = vkbandtexturec(texture, bp, core, mAllocator, bAllocator,
+									 qoi.width, qoi.height, vkqoiband, &qoi);
+	qoi_close(&qoi);
+
+	logt("VkTexture created from %s\n", path);
+	return result;
+}
+
+void vkcmdtransitionimglayout(VkCommandBuffer cmdbuf, VkImage image,
+							  VkImageLayout old_layout, VkImageLayout new_layout)
+{
+	// records the barrier only, the caller owns cmdbuf and its submission
+	VkAccessFlags src_flags, dst_flags;
+	VkPipelineStageFlags src_stage, dst_stage;
+	
+	if (old_layout == VK_IMAGE_LAYOUT_UNDEFINED &&
+		new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	{
+		src_flags = 0;
+		dst_flags = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		src_stage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+	else if (old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+			 new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL)
+	{
+		src_flags = VK_ACCESS_TRANSFER_WRITE_BIT;
+		dst_flags = VK_ACCESS_SHADER_READ_BIT;
+
+		src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dst_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	}
+	else if (old_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL &&
+			 new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+	{
+		// earlier frames on the queue may still sample the image
+		src_flags = 0;
+		dst_flags = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		src_stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	}
+	else
+	{
+		loge("vktrasitionimglayout(), unsupported image layout trasition\n");
+		exit(0);
+	}
+	
+	VkImageSubresourceRange subresrange = (VkImageSubresourceRange) {
+		.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+		.baseMipLevel = 0,
+		.levelCount = 1,
+		.baseArrayLayer = 0,
+		.layerCount = 1
+	};
+	
+	VkImageMemoryBarrier barrier = (VkImageMemoryBarrier) {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.pNext = NULL,
+		.srcAccessMask = src_flags,
+		.dstAccessMask = dst_flags,
+		.oldLayout = old_layout,
+		.newLayout = new_layout,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image,
+		.subresourceRange = subresrange
+	};
+
+	vkCmdPipelineBarrier(cmdbuf, src_stage, dst_stage, 0, 0, NULL, 0, NULL,	1, &barrier);
+}
@@ -0,0 +1,341 @@
+#include "grafics2.h"
+
+#define vkvt_logi(...) logi(__VA_ARGS__)
+#define vkvt_logw(...) logw(__VA_ARGS__)
+#define vkvt_loge(...) loge(__VA_ARGS__)
+
+#define VKVT_NOT_UPLOADED 0xffffffff
+#define VKVT_NO_DRAW 0xffffffff
+
+static u32 vkvtUploadGlyph(VkvtRenderer* renderer, u32 glyphIndex, u32* numVertices);
+
+VkResult vkvtCreateRenderer(VkvtRenderer* renderer, VkvtRendererCreateInfo* info)
+{
+	/*
+	  	USAGE:
+
+		every frame, once the frame's fence has been waited on:
+			vkvtBeginFrame(&vectorText, frame);
+			vkvtAddText(&vectorText, "Title", 5, 96.0f, x, y);
+			...
+			vkvtEndFrame(&vectorText);
+			...
+			vkvtDraw(&vectorText, cmdbuf);			// inside the render pass
+
+	  	NOTE:
+		 - glyphs are drawn from ttf_glyph_mesh_get() meshes, no atlas, any point
+		   size costs the same few KB of vertices per glyph
+		 - a mesh is copied into the host visible vertex buffer the first time
+		   its glyph is drawn and stays there, frames in flight only ever read
+		   vertices that were written before them
+		 - one instanced draw per distinct glyph of the frame, all of them issued
+		   by a single binding pipeline
+		 - curve edges are antialiased in shaders/vector.frag, straight edges are
+		   as sharp as the rasterizer makes them
+	 */
+	assert(renderer != NULL);
+	assert(info != NULL && info->font != NULL);
+
+	*renderer = (VkvtRenderer) { 0 };
+	renderer->bp = info->boilerplate;
+	renderer->bAllocator = info->bAllocator;
+	renderer->dsManager = info->dsManager;
+	renderer->machine = info->machine;
+	renderer->font = info->font;
+	// vkba's HOST page is 1 MB and never grows, the defaults share it with vkgc's
+	// staging (2 x 64 KB) and vktext's instances (2 x 4096 x 32 B = 256 KB):
+	// 16384 x 20 B = 320 KB of vertices, most of a latin font, and 2 x 2048 x
+	// 16 B = 64 KB of instances, ~250 KB stay free for staging and textures
+	renderer->maxVertices = (info->maxVertices != 0) ? info->maxVertices : 16384;
+	renderer->maxInstances = (info->maxInstances != 0) ? info->maxInstances : 2048;
+
+	u32 numGlyphs = info->font->num_glyphs;
+	renderer->firstVertices = (u32*) malloc(numGlyphs * sizeof(u32));
+	renderer->glyphDraws = (u32*) malloc(numGlyphs * sizeof(u32));
+	memset(renderer->firstVertices, 0xff, numGlyphs * sizeof(u32));
+	memset(renderer->glyphDraws, 0xff, numGlyphs * sizeof(u32));
+	renderer->drawGlyphs = (u32*) malloc(renderer->maxInstances * sizeof(u32));
+	renderer->draws = (VkDrawIndexedIndirectCommand*)
+		malloc(renderer->maxInstances * sizeof(VkDrawIndexedIndirectCommand));
+	arr_init(&renderer->instances, sizeof(VkvtInstance));
+	arr_init(&renderer->instanceGlyphs, sizeof(u32));
+	arr_init(&renderer->glyphIndices, sizeof(u32));
+
+	// pixels, y down from the top left, to clip space
+	VkExtent2D extent = info->core->swpcext;
+	renderer->uboData[0] = 2.0f / extent.width;
+	renderer->uboData[1] = 2.0f / extent.height;
+	renderer->uboData[2] = -1.0f;
+	renderer->uboData[3] = -1.0f;
+	VkbaVirtualBufferInfo vBufferInfo = { HOST_INDEX, 4 * 4, renderer->uboData, 1 };
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		VkResult result = vkbaCreateVirtualBuffer(renderer->bAllocator, renderer->ubos + i,
+												  &vBufferInfo);
+		if (result != VK_SUCCESS) { return result; }
+		memcpy(renderer->ubos[i].dst, renderer->ubos[i].src, renderer->ubos[i].locale.size);
+	}
+
+	VkbaVirtualBufferInfo vertexInfo = {
+		HOST_INDEX, sizeof(TrueTypeFontMeshVertex) * renderer->maxVertices, NULL, 0
+	};
+	VkResult result = vkbaCreateVirtualBuffer(renderer->bAllocator, &renderer->vertexbuff,
+											  &vertexInfo);
+	if (result != VK_SUCCESS) {
+		vkvt_loge("[vkvt] Failed to create vertex buffer for %u vertices\n",
+				  renderer->maxVertices);
+		return result;
+	}
+
+	VkbaVirtualBufferInfo instanceInfo = {
+		HOST_INDEX, sizeof(VkvtInstance) * renderer->maxInstances * MAX_FRAMES_IN_FLIGHT,
+		NULL, 0
+	};
+	result = vkbaCreateVirtualBuffer(renderer->bAllocator, &renderer->instbuff,
+									 &instanceInfo);
+	if (result != VK_SUCCESS) {
+		vkvt_loge("[vkvt] Failed to create instance buffer for %u glyphs\n",
+				  renderer->maxInstances);
+		return result;
+	}
+
+	// meshes are triangle lists, a draw's first index is its glyph's first vertex
+	u32* indices = (u32*) malloc(renderer->maxVertices * sizeof(u32));
+	for (u32 i = 0; i < renderer->maxVertices; i++) { indices[i] = i; }
+	VkbaVirtualBufferInfo tmpBufferInfo = {
+		DEVICE_INDEX, sizeof(u32) * renderer->maxVertices, indices
+	};
+	vkbaStageVirtualBuffer(renderer->bAllocator, &renderer->indexbuff, &tmpBufferInfo);
+	free(indices);
+
+	VkdsBindingData bindingData0;
+	bindingData0.uniformBuffer = (VkdsBindingUniformData) { renderer->ubos };
+	VkdsBinding bindings[] = {
+		(VkdsBinding) {
+			0, VKDS_BINDING_TYPE_UNIFORM_BUFFER, VKDS_BINDING_STAGE_VERTEX, bindingData0
+		}
+	};
+	VkdsDescriptorSetCreateInfo dsInfo = {
+		1, bindings, MAX_FRAMES_IN_FLIGHT
+	};
+	result = vkdsCreateDescriptorSets(renderer->dsManager, &dsInfo, renderer->dsets,
+									  &renderer->dlayout);
+	if (result != VK_SUCCESS) {
+		vkvt_loge("[vkvt] Failed to create descriptor sets\n");
+		return result;
+	}
+
+	VkVertexInputBindingDescription vibd[] = {
+		(VkVertexInputBindingDescription) {
+			.binding = 0,
+			.stride = sizeof(TrueTypeFontMeshVertex),
+			.inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+		},
+		(VkVertexInputBindingDescription) {
+			.binding = 1,
+			.stride = sizeof(VkvtInstance),
+			.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
+		}
+	};
+
+	VkVertexInputAttributeDescription viad[] = {
+		(VkVertexInputAttributeDescription) {
+			.binding = 0,
+			.location = 0,
+			.format = VK_FORMAT_R32G32_SFLOAT,
+			.offset = 0
+		},
+		(VkVertexInputAttributeDescription) {
+			.binding = 0,
+			.location = 1,
+			.format = VK_FORMAT_R32G32B32_SFLOAT,
+			.offset = 2*4
+		},
+		(VkVertexInputAttributeDescription) {
+			.binding = 1,
+			.location = 2,
+			.format = VK_FORMAT_R32G32B32A32_SFLOAT,
+			.offset = 0
+		}
+	};
+
+	VkenPipelineCreateInfo pInfo = {
+		"spv/vector.vert.spv", "spv/vector.frag.spv", 2, vibd, 3, viad,
+		1, &renderer->dlayout, extent, renderer->bp->dev, info->core->renderpass, 0,
+		VKEN_PIPELINE_CREATE_ALPHA_BLEND_BIT
+	};
+	result = vkenCreatePipelines(1, &renderer->pipeline, &pInfo);
+	if (result != VK_SUCCESS) { return result; }
+
+	VkbpBindingPipelineInfo bInfo = {
+		renderer->pipeline.pipe, &renderer->vertexbuff, &renderer->indexbuff,
+		&renderer->instbuff, renderer->pipeline.layout, MAX_FRAMES_IN_FLIGHT, 1,
+		renderer->dsets, 0, 0, sizeof(VkvtInstance) * renderer->maxInstances,
+		renderer->draws, &renderer->drawCount
+	};
+	renderer->bindingId = vkbpAddBindingPipeline(renderer->machine, &bInfo);
+
+	vkvt_logi("[vkvt] Vector text renderer created, %u vertices, %u glyphs per frame\n",
+			  renderer->maxVertices, renderer->maxInstances);
+	return VK_SUCCESS;
+}
+
+void vkvtDestroyRenderer(VkvtRenderer* renderer)
+{
+	VkbaAllocator* bAllocator = renderer->bAllocator;
+
+	vkenDestroyPipeline(&renderer->pipeline);
+
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->vertexbuff);
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->indexbuff);
+	vkbaDestroyVirtualBuffer(bAllocator, &renderer->instbuff);
+	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		vkbaDestroyVirtualBuffer(bAllocator, renderer->ubos + i);
+	}
+
+	free(renderer->firstVertices);
+	free(renderer->glyphDraws);
+	free(renderer->drawGlyphs);
+	free(renderer->draws);
+	arr_free(&renderer->instances);
+	arr_free(&renderer->instanceGlyphs);
+	arr_free(&renderer->glyphIndices);
+	*renderer = (VkvtRenderer) { 0 };
+
+	vkvt_logi("[vkvt] Vector text renderer destroyed\n");
+}
+
+void vkvtBeginFrame(VkvtRenderer* renderer, u32 frameIndex)
+{
+	renderer->frameIndex = frameIndex % MAX_FRAMES_IN_FLIGHT;
+	arr_clean(&renderer->instances);
+	arr_clean(&renderer->instanceGlyphs);
+}
+
+u32 vkvtAddText(VkvtRenderer* renderer, const char* text, u32 length, float pointSize,
+				float x, float y)
+{
+	/*
+	  	NOTE:
+		 - utf-8, x and y are the pen on the first baseline in pixels, y down,
+		   '\n' starts a new line ascent - descent further down
+		 - laid out like vktextAddText(), but the pen is not snapped to whole
+		   pixels, the mesh is exact wherever it lands
+		 - glyphs whose mesh no longer fits the vertex buffer are skipped but
+		   still advance the pen, returns the number of glyphs added
+	 */
+	TrueTypeFont* ttf = renderer->font;
+	s32 scale = pointSize / (s32) ttf->units_per_em;
+	s32 lineAdvance = scale * (ttf->ascent - ttf->descent);
+
+	if (renderer->glyphIndices.size < length) {
+		arr_clean(&renderer->glyphIndices);
+		for (u32 i = 0; i < length; i++) { arr_push(&renderer->glyphIndices); }
+	}
+	u32* glyphIndices = (u32*) renderer->glyphIndices.data;
+
+	u32 added = 0;
+	const char* line = text;
+	const char* end = text + length;
+	while (line < end) {
+		const char* lineEnd = memchr(line, '\n', end - line);
+		if (lineEnd == NULL) { lineEnd = end; }
+		u32 numGlyphs = ttf_glyph_indices_utf8(ttf, line, lineEnd - line, glyphIndices);
+
+		s32 pen = x;
+		for (u32 i = 0; i < numGlyphs; i++) {
+			u32 glyphIndex = MIN(glyphIndices[i], ttf->num_glyphs - 1u);
+			// kerned like ttf_measure_texts(), never after the missing glyph
+			if (i != 0 && glyphIndices[i - 1] != 0) {
+				pen += scale * ttf_kerning_get(ttf, glyphIndices[i - 1], glyphIndex);
+			}
+
+			u32 numVertices;
+			u32 firstVertex = vkvtUploadGlyph(renderer, glyphIndex, &numVertices);
+			if (firstVertex != VKVT_NOT_UPLOADED && numVertices != 0) {
+				if (renderer->instances.size == renderer->maxInstances) {
+					vkvt_logw("[vkvt] More than %u glyphs this frame\n",
+							  renderer->maxInstances);
+					return added;
+				}
+				VkvtInstance instance = (VkvtInstance) { { pen, y }, scale, 0.0f };
+				arr_add(&renderer->instances, &instance);
+				arr_add(&renderer->instanceGlyphs, &glyphIndex);
+				added++;
+			}
+			pen += scale * ttf->advances[glyphIndex];
+		}
+
+		y += lineAdvance;
+		line = lineEnd + 1;
+	}
+	return added;
+}
+
+void vkvtEndFrame(VkvtRenderer* renderer)
+{
+	// instances go to this frame's slice grouped by glyph, each glyph draws its range
+	u32* instanceDraws = (u32*) renderer->instanceGlyphs.data;
+	u32 drawCount = 0;
+	for (u32 i = 0; i < renderer->instanceGlyphs.size; i++) {
+		u32 glyphIndex = instanceDraws[i];
+		u32 draw = renderer->glyphDraws[glyphIndex];
+		if (draw == VKVT_NO_DRAW) {
+			draw = drawCount++;
+			renderer->glyphDraws[glyphIndex] = draw;
+			renderer->drawGlyphs[draw] = glyphIndex;
+			TrueTypeFontMesh* mesh = ttf_glyph_mesh_get(renderer->font, glyphIndex);
+			renderer->draws[draw] = (VkDrawIndexedIndirectCommand) {
+				mesh->num_vertices, 0, renderer->firstVertices[glyphIndex], 0, 0
+			};
+		}
+		renderer->draws[draw].instanceCount++;
+		instanceDraws[i] = draw;
+	}
+
+	u32 next[MAX(drawCount, 1)];
+	u32 first = 0;
+	for (u32 i = 0; i < drawCount; i++) {
+		renderer->glyphDraws[renderer->drawGlyphs[i]] = VKVT_NO_DRAW;
+		renderer->draws[i].firstInstance = first;
+		next[i] = first;
+		first += renderer->draws[i].instanceCount;
+	}
+
+	VkvtInstance* dst = (VkvtInstance*) renderer->instbuff.dst +
+		renderer->frameIndex * renderer->maxInstances;
+	VkvtInstance* src = (VkvtInstance*) renderer->instances.data;
+	for (u32 i = 0; i < renderer->instances.size; i++) {
+		dst[next[instanceDraws[i]]++] = src[i];
+	}
+	renderer->drawCount = drawCount;
+}
+
+void vkvtDraw(VkvtRenderer* renderer, VkCommandBuffer cmdBuffer)
+{
+	if (renderer->drawCount == 0) { return; }
+	VkResult result = vkbpBindBindingPipeline(renderer->machine, cmdBuffer,
+											  renderer->frameIndex, renderer->bindingId);
+	assert(result == VK_SUCCESS);
+}
+
+static u32 vkvtUploadGlyph(VkvtRenderer* renderer, u32 glyphIndex, u32* numVertices)
+{
+	// the glyph's first vertex in the vertex buffer, meshed and copied on first use
+	TrueTypeFontMesh* mesh = ttf_glyph_mesh_get(renderer->font, glyphIndex);
+	*numVertices = mesh->num_vertices;
+	if (renderer->firstVertices[glyphIndex] != VKVT_NOT_UPLOADED) {
+		return renderer->firstVertices[glyphIndex];
+	}
+
+	if (renderer->maxVertices - renderer->numVertices < mesh->num_vertices) {
+		vkvt_logw("[vkvt] Glyph %u does not fit, %u of %u vertices used\n", glyphIndex,
+				  renderer->numVertices, renderer->maxVertices);
+		return VKVT_NOT_UPLOADED;
+	}
+	TrueTypeFontMeshVertex* dst = (TrueTypeFontMeshVertex*) renderer->vertexbuff.dst +
+		renderer->numVertices;
+	memcpy(dst, mesh->vertices, mesh->num_vertices * sizeof(TrueTypeFontMeshVertex));
+	renderer->firstVertices[glyphIndex] = renderer->numVertices;
+	renderer->numVertices += mesh->num_vertices;
+	return renderer->firstVertices[glyphIndex];
+}
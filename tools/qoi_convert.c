@@ -0,0 +1,89 @@
+#include "grafics2.h"
+
+/*
+	Converts every bmp given to qoi next to it, 'image.bmp' becomes 'image.qoi',
+	then maps both back and checks that they decode to the same texels.
+
+	USAGE: qoi_convert.exe image.bmp [image.bmp ...]
+ */
+
+static LARGE_INTEGER convert_now()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now;
+}
+
+static double convert_ms(LARGE_INTEGER begin)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return 1e3 * (double) (convert_now().QuadPart - begin.QuadPart) / frequency.QuadPart;
+}
+
+static u64 convert_size(const char* path)
+{
+	u32 size = 0;
+	void* view = file_map(path, &size);
+	file_unmap(view);
+	return size;
+}
+
+int main(int argc, char** argv)
+{
+	log_init("qoi_convert.log");
+
+	if (argc < 2) {
+		printf("USAGE: %s image.bmp [image.bmp ...]\n", argv[0]);
+		return 1;
+	}
+
+	i32 failed = 0;
+	printf("%-32s %10s %10s %7s %10s %10s %10s\n", "image", "bmp KB", "qoi KB", "ratio",
+		   "bmp ms", "qoi ms", "identical");
+	for (i32 i = 1; i < argc; i++) {
+		const char* bmp_path = argv[i];
+		char qoi_path[MAX_PATH];
+		snprintf(qoi_path, sizeof(qoi_path) - 4, "%s", bmp_path);
+		char* extension = strrchr(qoi_path, '.');
+		if (extension && !strpbrk(extension, "/\\")) {
+			*extension = '\0';
+		}
+		strcat(qoi_path, ".qoi");
+
+		if (qoi_convert_bmp(bmp_path, qoi_path) != 1) {
+			printf("failed to convert %s\n", bmp_path);
+			failed++;
+			continue;
+		}
+
+		u32 width, height;
+		LARGE_INTEGER begin = convert_now();
+		char* bmp = bmp_load(bmp_path, &width, &height);
+		double bmp_time = convert_ms(begin);
+
+		u32 qoi_width, qoi_height;
+		begin = convert_now();
+		char* qoi = qoi_load(qoi_path, &qoi_width, &qoi_height);
+		double qoi_time = convert_ms(begin);
+
+		bool identical = bmp && qoi && width == qoi_width && height == qoi_height &&
+			memcmp(bmp, qoi, 4 * (u64) width * height) == 0;
+		u64 bmp_size = convert_size(bmp_path);
+		u64 qoi_size = convert_size(qoi_path);
+
+		printf("%-32s %10llu %10llu %6.2fx %10.3f %10.3f %10s\n", bmp_path, bmp_size / KILOBYTE,
+			   qoi_size / KILOBYTE, (double) bmp_size / qoi_size, bmp_time, qoi_time,
+			   identical ? "yes" : "NO");
+		// noise doesn't compress, qoi spends 4 bytes on a pixel no op predicts
+		if (qoi_size >= bmp_size) {
+			printf("%-32s is larger as qoi, keep the bmp\n", qoi_path);
+		}
+		failed += !identical;
+		bmp_free(qoi);
+		bmp_free(bmp);
+	}
+
+	log_close();
+	return failed != 0;
+}
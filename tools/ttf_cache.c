@@ -0,0 +1,97 @@
+#include "grafics2.h"
+
+/*
+	Parses every font given and writes its memory-mappable cache next to it,
+	'font.ttf' becomes 'font.ttf.cache', then maps it back and checks that it
+	decodes to the same glyphs as the parsed font.
+
+	USAGE: ttf_cache.exe font.ttf [font.ttf ...]
+ */
+
+static LARGE_INTEGER cache_now()
+{
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return now;
+}
+
+static double cache_ms(LARGE_INTEGER begin)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	return 1e3 * (double) (cache_now().QuadPart - begin.QuadPart) / frequency.QuadPart;
+}
+
+static bool cache_identical(TrueTypeFont* a, TrueTypeFont* b)
+{
+	if (a->num_glyphs != b->num_glyphs || a->num_kern_pairs != b->num_kern_pairs ||
+		a->num_cmap_groups != b->num_cmap_groups) {
+		return false;
+	}
+	for (u32 i = 0; i < a->num_glyphs; i++) {
+		TrueTypeFontGlyph* ga = ttf_glyph_get(a, i);
+		TrueTypeFontGlyph* gb = ttf_glyph_get(b, i);
+		if (ga->num_points != gb->num_points || ga->num_contours != gb->num_contours ||
+			ga->aw != gb->aw) {
+			return false;
+		}
+		u32 pa = ga->first_point;
+		u32 pb = gb->first_point;
+		if (memcmp(a->outlines.pts_x + pa, b->outlines.pts_x + pb, ga->num_points * 2) ||
+			memcmp(a->outlines.pts_y + pa, b->outlines.pts_y + pb, ga->num_points * 2) ||
+			memcmp(a->outlines.on_curve + pa, b->outlines.on_curve + pb, ga->num_points)) {
+			return false;
+		}
+	}
+	return memcmp(a->cmap_groups, b->cmap_groups,
+				  a->num_cmap_groups * sizeof(TrueTypeFontCmapGroup)) == 0;
+}
+
+int main(int argc, char** argv)
+{
+	log_init("ttf_cache.log");
+
+	if (argc < 2) {
+		printf("USAGE: %s font.ttf [font.ttf ...]\n", argv[0]);
+		return 1;
+	}
+
+	i32 failed = 0;
+	printf("%-32s %8s %10s %10s %10s\n", "font", "glyphs", "parse ms", "map ms", "identical");
+	for (i32 i = 1; i < argc; i++) {
+		const char* font_path = argv[i];
+		char cache_path[MAX_PATH];
+		snprintf(cache_path, sizeof(cache_path), "%s.cache", font_path);
+
+		TrueTypeFont* ttf = NULL;
+		LARGE_INTEGER begin = cache_now();
+		if (ttf_load(&ttf, font_path, 0) != 1) {
+			printf("failed to load %s\n", font_path);
+			failed++;
+			continue;
+		}
+		double parse_time = cache_ms(begin);
+
+		if (ttf_cache_save(ttf, font_path, cache_path) != 1) {
+			printf("failed to write %s\n", cache_path);
+			ttf_free(&ttf);
+			failed++;
+			continue;
+		}
+
+		TrueTypeFont* cached = NULL;
+		begin = cache_now();
+		i32 result = ttf_cache_load(&cached, font_path, cache_path);
+		double map_time = cache_ms(begin);
+		bool identical = result == 1 && cache_identical(ttf, cached);
+
+		printf("%-32s %8u %10.3f %10.3f %10s\n", font_path, ttf->num_glyphs, parse_time,
+			   map_time, identical ? "yes" : "NO");
+		failed += !identical;
+		ttf_free(&cached);
+		ttf_free(&ttf);
+	}
+
+	log_close();
+	return failed != 0;
+}